@@ -195,6 +195,18 @@ class ActivityLog {
 
   static const char kKeyProperties[];
 
+  // Stage stats keys:
+  static const char kKeyStageStats[];
+  static const char kKeyStageStatsSyncCalls[];
+  static const char kKeyStageStatsSyncNs[];
+  static const char kKeyStageStatsSyncMaxNs[];
+  static const char kKeyStageStatsTimerCalls[];
+  static const char kKeyStageStatsTimerNs[];
+  static const char kKeyStageStatsTimerMaxNs[];
+  static const char kKeyStageStatsTimerRequests[];
+  static const char kKeyStageStatsGesturesConsumed[];
+  static const char kKeyStageStatsGesturesProduced[];
+
  private:
   // Extends the tail of the buffer by one element and returns that new element.
   // This may cause an older element to be overwritten if the buffer is full.
@@ -37,6 +37,17 @@ class ActivityReplay : public GestureConsumer {
 
   virtual void ConsumeGesture(const Gesture& gesture);
 
+  // The parsed log, for callers that drive interpreters themselves. The
+  // fingers of logged hardware states point into the log, so they must be
+  // copied before being passed to an interpreter.
+  ActivityLog* log() { return &log_; }
+  const HardwareProperties& hwprops() const { return hwprops_; }
+  // The logged property values, less those that replay ignores.
+  const Json::Value& properties() const { return properties_; }
+
+  // Returns the value of a logged property change as JSON.
+  static Json::Value PropChangeValue(const ActivityLog::PropChangeEntry& entry);
+
  private:
   // These return true on success
   bool ParseProperties(const Json::Value& dict,
@@ -63,6 +74,7 @@ class ActivityReplay : public GestureConsumer {
 
   ActivityLog log_;
   HardwareProperties hwprops_;
+  Json::Value properties_;
   PropRegistry* prop_reg_;
   std::deque<Gesture> consumed_gestures_;
   std::vector<std::shared_ptr<const std::string> > names_;
@@ -0,0 +1,33 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GESTURES_ASSIGNMENT_SOLVER_H_
+#define GESTURES_ASSIGNMENT_SOLVER_H_
+
+#include <stddef.h>
+
+#include "include/finger_metrics.h"
+
+namespace gestures {
+
+// The most rows, and the most columns, SolveAssignment takes.
+static const size_t kMaxAssignmentSize = kMaxFingers;
+
+// Pairs rows of |cost| with columns, each used at most once, where
+// cost[row][col] is the cost of pairing |row| with |col|, and an entry that
+// isn't less than INFINITY (NaN included) can't be paired. Picks the most
+// pairs there can be, and of those, the ones with the smallest total cost.
+// This is the Hungarian method, which takes O(n^3) time for n rows or
+// columns, whichever is more, however the costs are laid out.
+//
+// Only the first |rows| rows and |cols| columns of |cost| are read, and
+// both must be at most kMaxAssignmentSize. Sets row_to_col[row] to the
+// column paired with each row, or -1 if it's left out. Returns the number
+// of pairs.
+size_t SolveAssignment(const float cost[][kMaxAssignmentSize],
+                       size_t rows, size_t cols, int* row_to_col);
+
+}  // namespace gestures
+
+#endif  // GESTURES_ASSIGNMENT_SOLVER_H_
@@ -42,6 +42,11 @@ class FilterInterpreter : public Interpreter, public GestureConsumer {
 
   virtual void ConsumeGesture(const Gesture& gesture);
 
+  // States are passed on to next_, so next_ can keep its own.
+  virtual HardwareState* NextInputState() { return next_->NextInputState(); }
+
+  virtual void CollectStageStats(std::vector<GestureStageStats>* out) const;
+
  protected:
   virtual void SyncInterpretImpl(HardwareState* hwstate, stime_t* timeout);
   virtual void HandleTimerImpl(stime_t now, stime_t* timeout);
@@ -0,0 +1,179 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GESTURES_FINGER_MAP_H_
+#define GESTURES_FINGER_MAP_H_
+
+#include <stdint.h>
+
+#include "include/gestures.h"
+
+namespace gestures {
+
+// Maximum number of tracking ids a FingerSlotTable can hold at once.
+static const size_t kMaxFingerSlots = 64;
+
+// A FingerSlotTable gives each tracking id a slot in [0, kMaxFingerSlots)
+// that stays fixed for the lifetime of the contact. FingerMaps built on the
+// same table store their members as a bitmask of slots.
+//
+// When a contact leaves, its slot keeps the old id until the other free
+// slots have been used. So FingerMaps from previous frames, and ids that
+// come back after a short absence, keep their meaning. Slots are only
+// assigned by Update(), which the owner calls once per frame.
+class FingerSlotTable {
+ public:
+  FingerSlotTable() { Clear(); }
+
+  // Assigns slots to the tracking ids in |hwstate| that don't have one, and
+  // releases the slots of ids that are no longer present.
+  void Update(const HardwareState& hwstate);
+
+  // Forgets all ids.
+  void Clear();
+
+  // Returns the slot of |id|, or -1 if |id| has no slot.
+  int SlotForId(short id) const;
+
+  short IdForSlot(size_t slot) const { return ids_[slot]; }
+
+  // Slots holding an id, in ascending id order. Used to iterate FingerMaps
+  // in the same order as a std::set<short>.
+  size_t num_assigned() const { return num_assigned_; }
+  size_t SlotAtRank(size_t rank) const { return order_[rank]; }
+
+ private:
+  // Returns a slot for the new id |id|, or -1 if the table is full. Slots in
+  // |reserved| are not reused.
+  int AssignSlot(short id, uint64_t reserved);
+
+  // Position of |id| in order_, or where it would be inserted.
+  size_t LowerBound(short id) const;
+
+  short ids_[kMaxFingerSlots];
+  // Value of release_count_ when each slot's id last left the pad.
+  uint64_t released_at_[kMaxFingerSlots];
+  uint64_t release_count_;
+  // Slots holding an id, and slots whose id is currently on the pad.
+  uint64_t assigned_;
+  uint64_t live_;
+  // Assigned slots sorted by id.
+  uint8_t order_[kMaxFingerSlots];
+  size_t num_assigned_;
+};
+
+// The FingerMap class mimicks the subset of std::set<short> that the
+// interpreters use for sets of tracking ids, while storing the set as a slot
+// bitmask. Union, intersection, difference and equality are single integer
+// operations. Iteration yields ids in ascending order, like std::set.
+// Maps that are combined or compared must use the same FingerSlotTable, and
+// ids can only be inserted after the table has given them a slot.
+class FingerMap {
+ public:
+  class const_iterator {
+   public:
+    const_iterator(const FingerMap* map, size_t rank, size_t left)
+        : map_(map), rank_(rank), left_(left) {
+      SkipNonMembers();
+    }
+    short operator*() const {
+      return map_->slots_->IdForSlot(map_->slots_->SlotAtRank(rank_));
+    }
+    const_iterator& operator++() {
+      ++rank_;
+      --left_;
+      SkipNonMembers();
+      return *this;
+    }
+    // Two iterators over the same map are at the same spot iff the same
+    // number of members is left to visit.
+    bool operator==(const const_iterator& that) const {
+      return left_ == that.left_;
+    }
+    bool operator!=(const const_iterator& that) const {
+      return !(*this == that);
+    }
+
+   private:
+    void SkipNonMembers() {
+      if (!left_)
+        return;
+      size_t num_assigned = map_->slots_->num_assigned();
+      while (rank_ < num_assigned &&
+             !map_->HasSlot(map_->slots_->SlotAtRank(rank_)))
+        ++rank_;
+      if (rank_ == num_assigned)
+        left_ = 0;  // Members whose slot was cleared from the table
+    }
+
+    const FingerMap* map_;
+    size_t rank_;
+    size_t left_;
+  };
+  typedef const_iterator iterator;
+
+  FingerMap() : slots_(NULL), bits_(0) {}
+  explicit FingerMap(const FingerSlotTable* slots)
+      : slots_(slots), bits_(0) {}
+
+  size_t size() const { return __builtin_popcountll(bits_); }
+  bool empty() const { return bits_ == 0; }
+  void clear() { bits_ = 0; }
+
+  const_iterator begin() const { return const_iterator(this, 0, size()); }
+  const_iterator end() const { return const_iterator(this, 0, 0); }
+  const_iterator find(short id) const;
+  size_t count(short id) const {
+    int slot = slots_ ? slots_->SlotForId(id) : -1;
+    return slot >= 0 && HasSlot(slot);
+  }
+
+  void insert(short id);
+  size_t erase(short id);
+
+  // Removes the members of |that| from this map.
+  void RemoveAll(const FingerMap& that) { bits_ &= ~that.bits_; }
+
+  FingerMap& operator|=(const FingerMap& that) {
+    bits_ |= that.bits_;
+    return *this;
+  }
+  FingerMap& operator&=(const FingerMap& that) {
+    bits_ &= that.bits_;
+    return *this;
+  }
+  // Set difference.
+  FingerMap operator-(const FingerMap& that) const {
+    FingerMap ret(*this);
+    ret.RemoveAll(that);
+    return ret;
+  }
+
+  bool operator==(const FingerMap& that) const { return bits_ == that.bits_; }
+  bool operator!=(const FingerMap& that) const { return bits_ != that.bits_; }
+
+  // Removes any ids that are not finger ids in |hwstate|.
+  void RemoveMissingIds(const HardwareState& hwstate);
+
+ private:
+  bool HasSlot(size_t slot) const { return (bits_ >> slot) & 1; }
+
+  const FingerSlotTable* slots_;
+  uint64_t bits_;
+};
+
+// Overloads of the helpers in util.h, so call sites read the same whether
+// they hold a FingerMap or a std::set<short>.
+inline bool SetContainsValue(const FingerMap& the_set, short elt) {
+  return the_set.count(elt) != 0;
+}
+
+inline void RemoveMissingIdsFromSet(FingerMap* the_set,
+                                    const HardwareState& hs) {
+  the_set->RemoveMissingIds(hs);
+}
+
+}  // namespace gestures
+
+#endif  // GESTURES_FINGER_MAP_H_
@@ -54,6 +54,52 @@ extern Vector2 Add(const Vector2& left, const Vector2& right);
 extern Vector2 Sub(const Vector2& left, const Vector2& right);
 extern float Dot(const Vector2& left, const Vector2& right);
 
+// Pairwise offsets and squared distances between the fingers of one
+// HardwareState, indexed by finger index. Code that compares every finger
+// with every other fills this in once per frame and reads from it, rather
+// than recomputing each distance at every comparison. The table covers the
+// first kMaxFingers fingers. Lookups beyond that are computed on the fly.
+class FingerDistances {
+ public:
+  FingerDistances() : finger_cnt_(0), fingers_(NULL) {}
+
+  // Computes the table for |hwstate|, whose fingers must stay valid and
+  // unchanged while the table is in use.
+  void Update(const HardwareState& hwstate);
+
+  size_t finger_cnt() const { return finger_cnt_; }
+
+  // Position of finger |i| minus position of finger |j|.
+  float DeltaX(size_t i, size_t j) const {
+    if (InTable(i, j))
+      return delta_x_[i][j];
+    return fingers_[i].position_x - fingers_[j].position_x;
+  }
+  float DeltaY(size_t i, size_t j) const {
+    if (InTable(i, j))
+      return delta_y_[i][j];
+    return fingers_[i].position_y - fingers_[j].position_y;
+  }
+  float DistSq(size_t i, size_t j) const {
+    if (InTable(i, j))
+      return dist_sq_[i][j];
+    float dx = DeltaX(i, j);
+    float dy = DeltaY(i, j);
+    return dx * dx + dy * dy;
+  }
+
+ private:
+  static bool InTable(size_t i, size_t j) {
+    return i < kMaxFingers && j < kMaxFingers;
+  }
+
+  size_t finger_cnt_;
+  const FingerState* fingers_;
+  float delta_x_[kMaxFingers][kMaxFingers];
+  float delta_y_[kMaxFingers][kMaxFingers];
+  float dist_sq_[kMaxFingers][kMaxFingers];
+};
+
 class MetricsProperties {
  public:
   explicit MetricsProperties(PropRegistry* prop_reg);
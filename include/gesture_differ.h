@@ -0,0 +1,75 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GESTURES_GESTURE_DIFFER_H_
+#define GESTURES_GESTURE_DIFFER_H_
+
+#include <string>
+#include <vector>
+
+#include "include/gestures.h"
+
+// DiffGestures() aligns an expected gesture stream with an actual one by time
+// and measures how far apart they are. Gestures are only paired with gestures
+// of the same type, in order, and only if their end times are within a
+// window of each other. So an extra or dropped gesture shows up as one
+// unmatched gesture instead of shifting every later comparison, and
+// interleaved types (e.g. moves and button changes) don't block each other.
+
+namespace gestures {
+
+static const size_t kNumGestureTypes = kGestureTypeMouseWheel + 1;
+
+struct GestureTypeDiff {
+  size_t expected = 0;
+  size_t actual = 0;
+  size_t matched = 0;
+
+  // Over matched pairs: |end time difference|, and the distance between the
+  // pairs' values. Values are (dx, dy) for moves, scrolls, wheels and swipes,
+  // (vx, vy) for flings and dz for pinches. Other types have no value.
+  double total_time_offset = 0.0;
+  double max_time_offset = 0.0;
+  double total_deviation = 0.0;
+  double max_deviation = 0.0;
+  // Sums of the value magnitudes of the matched expected and actual gestures,
+  // e.g. the distance moved or the fling speed.
+  double expected_magnitude = 0.0;
+  double actual_magnitude = 0.0;
+
+  size_t missing() const { return expected - matched; }
+  size_t extra() const { return actual - matched; }
+};
+
+struct GestureDiff {
+  GestureTypeDiff types[kNumGestureTypes];
+
+  // Totals over all types.
+  size_t matched() const;
+  size_t missing() const;
+  size_t extra() const;
+  double max_deviation() const;
+  double max_time_offset() const;
+
+  // True if every gesture was matched to one with the same value.
+  bool Identical() const {
+    return !missing() && !extra() && max_deviation() == 0.0;
+  }
+
+  // A line per gesture type present in either stream, and a total line.
+  std::string Summary() const;
+};
+
+struct GestureDiffOptions {
+  // Largest end time difference, in seconds, of gestures that can be paired.
+  double time_window = 0.05;
+};
+
+GestureDiff DiffGestures(const std::vector<Gesture>& expected,
+                         const std::vector<Gesture>& actual,
+                         const GestureDiffOptions& options);
+
+}  // namespace gestures
+
+#endif  // GESTURES_GESTURE_DIFFER_H_
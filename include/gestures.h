@@ -11,6 +11,7 @@
 
 #ifdef __cplusplus
 #include <string>
+#include <vector>
 
 #include <memory>
 
@@ -648,6 +649,28 @@ typedef struct GesturesPropProvider {
   GesturesPropFree free_fn;
 } GesturesPropProvider;
 
+// Counters each interpreter in the chain keeps about itself. Times are in
+// nanoseconds, and don't include time spent in the interpreters it calls.
+struct GestureStageStats {
+  // The interpreter's class name, valid as long as the GestureInterpreter.
+  const char* name;
+  // Calls to the interpreter with a new hardware state, and time spent in
+  // them.
+  uint64_t sync_calls;
+  uint64_t sync_ns;
+  uint64_t sync_max_ns;
+  // Timer callbacks handled, and time spent in them.
+  uint64_t timer_calls;
+  uint64_t timer_ns;
+  uint64_t timer_max_ns;
+  // Calls after which the interpreter asked for a timer.
+  uint64_t timer_requests;
+  // Gestures received from the next interpreter in the chain, and gestures
+  // passed on toward the client.
+  uint64_t gestures_consumed;
+  uint64_t gestures_produced;
+};
+
 #ifdef __cplusplus
 // C++ API:
 
@@ -668,6 +691,13 @@ struct GestureInterpreter {
   ~GestureInterpreter();
   void PushHardwareState(HardwareState* hwstate);
 
+  // Returns a state to fill in and pass to the next PushHardwareState(), or
+  // NULL. Interpreters that keep past states then keep this one without
+  // copying it. Its fingers have room for the hardware's max_finger_cnt
+  // fingers and must not be pointed elsewhere. It may only be changed until
+  // it is pushed, and is freed by SetHardwareProperties() and Initialize().
+  HardwareState* NextHardwareState();
+
   void SetHardwareProperties(const HardwareProperties& hwprops);
 
   void TimerCallback(stime_t now, stime_t* timeout);
@@ -679,6 +709,18 @@ struct GestureInterpreter {
   void SetTimerProvider(GesturesTimerProvider* tp, void* data);
   void SetPropProvider(GesturesPropProvider* pp, void* data);
 
+  // When set before Initialize(), the interpreters' properties are not
+  // exported to the prop provider as they are constructed. They run on their
+  // defaults and are exported in one pass after the first hardware state,
+  // or earlier by calling CreateDeferredProps().
+  void SetDeferPropCreation(bool defer);
+  void CreateDeferredProps();
+
+  // When set before SetPropProvider(), property writes from the provider
+  // are staged, and only applied between hardware states. Lets the provider
+  // write properties from another thread. See PropRegistry::SetStagedWrites().
+  void SetStagedPropWrites(bool staged);
+
   // Initialize GestureInterpreter based on device configuration.  This must be
   // called after GesturesPropProvider is set and before it accepts any inputs.
   void Initialize(
@@ -688,6 +730,10 @@ struct GestureInterpreter {
   PropRegistry* prop_reg() const { return prop_reg_.get(); }
 
   std::string EncodeActivityLog();
+
+  // Returns the counters of each interpreter, from the one closest to the
+  // client down to the one that makes the gestures.
+  std::vector<GestureStageStats> GetStageStats() const;
  private:
   void InitializeTouchpad(void);
   void InitializeTouchpad2(void);
@@ -743,6 +789,9 @@ void GestureInterpreterSetHardwareProperties(GestureInterpreter*,
 void GestureInterpreterPushHardwareState(GestureInterpreter*,
                                          struct HardwareState*);
 
+// See GestureInterpreter::NextHardwareState().
+struct HardwareState* GestureInterpreterNextHardwareState(GestureInterpreter*);
+
 void GestureInterpreterSetCallback(GestureInterpreter*,
                                    GestureReadyFunction,
                                    void*);
@@ -760,6 +809,24 @@ void GestureInterpreterSetPropProvider(GestureInterpreter*,
 void GestureInterpreterInitialize(GestureInterpreter*,
                                   enum GestureInterpreterDeviceClass);
 
+// See GestureInterpreter::SetDeferPropCreation(). Call it before
+// GestureInterpreterInitialize().
+void GestureInterpreterSetDeferPropCreation(GestureInterpreter*,
+                                            GesturesPropBool defer);
+void GestureInterpreterCreateDeferredProps(GestureInterpreter*);
+
+// See GestureInterpreter::SetStagedPropWrites(). Call it before
+// GestureInterpreterSetPropProvider().
+void GestureInterpreterSetStagedPropWrites(GestureInterpreter*,
+                                           GesturesPropBool staged);
+
+// Copies the counters of up to |max_stats| interpreters to |stats|, in the
+// order of GestureInterpreter::GetStageStats(). Returns the number of
+// interpreters in the chain, which may be more than |max_stats|.
+size_t GestureInterpreterGetStageStats(GestureInterpreter*,
+                                       struct GestureStageStats* stats,
+                                       size_t max_stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -2,11 +2,12 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include <map>
+#include <stdint.h>
 
 #include <gtest/gtest.h>  // for FRIEND_TEST
 
 #include "include/filter_interpreter.h"
+#include "include/finger_map.h"
 #include "include/finger_metrics.h"
 #include "include/gestures.h"
 #include "include/prop_registry.h"
@@ -17,74 +18,72 @@
 
 namespace gestures {
 
-// This filter interpreter applies a low-pass infinite impulse response (iir)
-// filter to each incoming finger. The default filter is a low-pass 2nd order
-// Butterworth IIR filter with a normalized cutoff frequency of 0.2. It can be
-// configured via properties to use other formulae or
-// different coefficients for the Butterworth filter.
+// Helper class that runs the IIR filter of IirFilterInterpreter, and
+// optionally more biquad sections after it for higher order filters. The
+// history of each contact is kept in a row of its own, with the filtered
+// fields side by side, so each section runs on all of them at once. The
+// caller picks the row of each contact, and keeps it for as long as the
+// contact is present.
 
-class IirFilterInterpreter : public FilterInterpreter, public PropertyDelegate {
+class IirFilterBank : public PropertyDelegate {
+  FRIEND_TEST(IirFilterInterpreterTest, CoefficientTest);
   FRIEND_TEST(IirFilterInterpreterTest, DisableIIRTest);
  public:
-  // We'll maintain one IOHistory record per active finger
-  class IoHistory {
-   public:
-    IoHistory() : in_head(0), out_head(0) {}
-    explicit IoHistory(const FingerState& fs) : in_head(0), out_head(0) {
-      for (size_t i = 0; i < kInSize; i++)
-        in[i] = fs;
-      for (size_t i = 0; i < kOutSize; i++)
-        out[i] = fs;
-    }
-    // Note: NextOut() and the oldest PrevOut() point to the same object.
-    FingerState* NextOut() { return &out[NextOutHead()]; }
-    FingerState* PrevOut(size_t idx) {
-      return &out[(out_head + idx) % kOutSize];
-    }
-    // Note: NextIn() and the oldest PrevIn() point to the same object.
-    FingerState* NextIn() { return &in[NextInHead()]; }
-    FingerState* PrevIn(size_t idx) { return &in[(in_head + idx) % kInSize]; }
-    void Increment();
-
-    bool operator==(const IoHistory& that) const;
-    bool operator!=(const IoHistory& that) const { return !(*this == that); }
-
-    void WarpBy(float dx, float dy);
-
-   private:
-    size_t NextOutHead() const {
-      return (out_head + kOutSize - 1) % kOutSize;
-    }
-    size_t NextInHead() const {
-      return (in_head + kInSize - 1) % kInSize;
-    }
-
-    static const size_t kInSize = 3;
-    static const size_t kOutSize = 2;
-    FingerState in[kInSize];  // previous input values
-    size_t in_head;
-    FingerState out[kOutSize];  // previous output values
-    size_t out_head;
-  };
+  // Biquad sections that can run after the IIR one.
+  static const size_t kMaxExtraSections = 3;
+  // Coefficients of each extra section: b0, b1, b2, a1, a2.
+  static const size_t kSectionCoefficients = 5;
+
+  explicit IirFilterBank(PropRegistry* prop_reg);
+  virtual ~IirFilterBank() {}
+
+  // Filters the first |finger_cnt| fingers of |hwstate| in place. rows[i] is
+  // the row of finger i, in [0, kMaxFingerSlots), or -1 to leave it alone.
+  // A row that wasn't used in the previous call starts over with its
+  // finger's values.
+  //
+  // The output of the IIR filter then goes through |section_cnt| (at most
+  // kMaxExtraSections) biquad sections, whose coefficients follow each other
+  // in |sections|. Fields that skip the IIR filter skip these too.
+  void Filter(const HardwareProperties* hwprops, const int* rows,
+              size_t finger_cnt, const double* sections, size_t section_cnt,
+              HardwareState* hwstate);
+
+  // Starts the history of every contact over.
+  void Restart() { prev_rows_ = 0; }
 
-  // Takes ownership of |next|:
-  IirFilterInterpreter(PropRegistry* prop_reg, Interpreter* next,
-                       Tracer* tracer);
-  virtual ~IirFilterInterpreter() {}
-
- protected:
-  virtual void SyncInterpretImpl(HardwareState* hwstate, stime_t* timeout);
-
- public:
   virtual void DoubleWasWritten(DoubleProperty* prop);
 
  private:
-  // Whether IIR filter should be used. Put as a member variable for
-  // unittest purpose.
+  // The filtered fields.
+  enum Channel {
+    kChannelX,
+    kChannelY,
+    kChannelPressure,
+    kChannelTouchMajor,
+    kNumChannels
+  };
+  static const size_t kInSize = 3;
+  static const size_t kOutSize = 2;
+  static const size_t kSectionSize = 2;
+
+  struct History {
+    // Previous inputs and outputs, most recent first.
+    float in[kInSize][kNumChannels];
+    float out[kOutSize][kNumChannels];
+    // The same for each extra section, whose input is the output of the
+    // section before.
+    float section_in[kMaxExtraSections][kSectionSize][kNumChannels];
+    float section_out[kMaxExtraSections][kSectionSize][kNumChannels];
+  };
+
+  // Whether IIR filter was used on the last finger. Put as a member variable
+  // for unittest purpose.
   bool using_iir_;
 
-  // Sync state history information
-  std::map<short, IoHistory> histories_;
+  History histories_[kMaxFingerSlots];
+  // Rows used in the previous call.
+  uint64_t prev_rows_;
 
   // y[0] = b[0]*x[0] + b[1]*x[1] + b[2]*x[2] + b[3]*x[3]
   //        - (a[1]*y[1] + a[2]*y[2])
@@ -95,6 +94,45 @@ class IirFilterInterpreter : public FilterInterpreter, public PropertyDelegate {
   DoubleProperty iir_dist_thresh_;
   // Whether to adjust the IIR history when finger WARP is detected.
   BoolProperty adjust_iir_on_warp_;
+  // Whether to filter touch_major too. Palm detection thresholds are tuned
+  // on the raw value, so it's passed through by default.
+  BoolProperty filter_touch_major_;
+};
+
+// This filter interpreter applies a low-pass infinite impulse response (iir)
+// filter to each incoming finger. The default filter is a low-pass 2nd order
+// Butterworth IIR filter with a normalized cutoff frequency of 0.2. It can be
+// configured via properties to use other formulae or
+// different coefficients for the Butterworth filter.
+
+class IirFilterInterpreter : public FilterInterpreter {
+  FRIEND_TEST(IirFilterInterpreterTest, CoefficientTest);
+  FRIEND_TEST(IirFilterInterpreterTest, DisableIIRTest);
+ public:
+  // Takes ownership of |next|:
+  IirFilterInterpreter(PropRegistry* prop_reg, Interpreter* next,
+                       Tracer* tracer);
+  virtual ~IirFilterInterpreter() {}
+
+ protected:
+  virtual void SyncInterpretImpl(HardwareState* hwstate, stime_t* timeout);
+
+ private:
+  // Gives the first |finger_cnt| fingers of |hwstate| a row of iir_, or -1
+  // past kMaxFingerSlots contacts.
+  void AssignRows(const HardwareState& hwstate, size_t finger_cnt,
+                  int* rows);
+
+  IirFilterBank iir_;
+
+  // The tracking id in each row, and the rows used by the previous
+  // HardwareState.
+  short row_ids_[kMaxFingerSlots];
+  uint64_t live_rows_;
+  // The row of each finger of the previous HardwareState. Fingers mostly
+  // stay in the same order, so this is checked first.
+  int prev_rows_[kMaxFingerSlots];
+  size_t prev_finger_cnt_;
 };
 
 }  // namespace gestures
@@ -3,10 +3,10 @@
 // found in the LICENSE file.
 
 #include <map>
-#include <set>
 
 #include <gtest/gtest.h>  // for FRIEND_TEST
 
+#include "include/finger_map.h"
 #include "include/finger_metrics.h"
 #include "include/gestures.h"
 #include "include/interpreter.h"
@@ -19,8 +19,6 @@
 
 namespace gestures {
 
-typedef std::set<short> FingerMap;
-
 // This interpreter keeps some memory of the past and, for each incoming
 // frame of hardware state, immediately determines the gestures to the best
 // of its abilities.
@@ -31,17 +29,12 @@ class MultitouchMouseInterpreter;
 class TapRecord {
   FRIEND_TEST(ImmediateInterpreterTest, TapRecordTest);
  public:
-  explicit TapRecord(const ImmediateInterpreter* immediate_interpreter)
-      : immediate_interpreter_(immediate_interpreter),
-        t5r2_(false),
-        t5r2_touched_size_(0),
-        t5r2_released_size_(0),
-        fingers_below_max_age_(true) {}
+  explicit TapRecord(const ImmediateInterpreter* immediate_interpreter);
   void Update(const HardwareState& hwstate,
               const HardwareState& prev_hwstate,
-              const std::set<short>& added,
-              const std::set<short>& removed,
-              const std::set<short>& dead);
+              const FingerMap& added,
+              const FingerMap& removed,
+              const FingerMap& dead);
   void Clear();
 
   // if any gesturing fingers are moving
@@ -65,13 +58,13 @@ class TapRecord {
   float CotapMinPressure() const;
 
   std::map<short, FingerState> touched_;
-  std::set<short> released_;
+  FingerMap released_;
   // At least one finger must meet the minimum pressure requirement during a
   // tap. This set contains the fingers that have.
-  std::set<short> min_tap_pressure_met_;
+  FingerMap min_tap_pressure_met_;
   // All fingers must meet the cotap pressure, which is half of the min tap
   // pressure.
-  std::set<short> min_cotap_pressure_met_;
+  FingerMap min_cotap_pressure_met_;
   // Used to fetch properties
   const ImmediateInterpreter* immediate_interpreter_;
   // T5R2: For these pads, we try to track individual IDs, but if we get an
@@ -90,10 +83,26 @@ struct ScrollEvent {
   float dx, dy, dt;
   static ScrollEvent Add(const ScrollEvent& evt_a, const ScrollEvent& evt_b);
 };
+
+// Weighted sums used to fit a line through the cumulative scroll position
+// over time (see ScrollManager::RegressScrollVelocity).
+struct ScrollRegressionSums {
+  double w_;   // Sum of weights.
+  double t_;   // Sum of w * t.
+  double tt_;  // Sum of w * t^2.
+  double tx_;  // Sum of w * t * x.
+  double ty_;  // Sum of w * t * y.
+  double x_;   // Sum of w * x.
+  double y_;   // Sum of w * y.
+};
+
+// Circular buffer of recent scroll events. Along with each event it keeps
+// running sums over all events inserted since the last Clear(), so the
+// fling velocity and speed queries below cost the same no matter how many
+// events they cover.
 class ScrollEventBuffer {
  public:
-  explicit ScrollEventBuffer(size_t size)
-      : buf_(new ScrollEvent[size]), max_size_(size), size_(0), head_(0) {}
+  explicit ScrollEventBuffer(size_t size);
   void Insert(float dx, float dy, float dt);
   void Clear();
   size_t Size() const { return size_; }
@@ -102,31 +111,73 @@ class ScrollEventBuffer {
   // For efficiency, returns dist_sq and time of the last num_events events in
   // the buffer, from which speed can be computed.
   void GetSpeedSq(size_t num_events, float* dist_sq, float* dt) const;
+  // Returns the number of newest events that are non-zero and all point in
+  // the same (up, down, left or right) direction.
+  size_t SameDirectionCount() const;
+  // Fills |out| with the regression sums over the newest |count| events. The
+  // newest event has weight 1, and each older one weight_decay() times the
+  // weight of the one after it.
+  void GetRegressionSums(size_t count, ScrollRegressionSums* out) const;
+  // Sets the weight decay, which must be in (0, 1]. Changing it costs one
+  // pass over the buffer.
+  void SetWeightDecay(double decay);
+  double weight_decay() const { return weight_decay_; }
 
  private:
-  std::unique_ptr<ScrollEvent[]> buf_;
+  // Running sums up to and including an event. t_, x_ and y_ are the
+  // event's cumulative time and position.
+  struct Prefix {
+    double t_, x_, y_;
+    ScrollRegressionSums sums_;
+  };
+  struct Entry {
+    ScrollEvent event_;
+    Prefix prefix_;
+    // Length of the run of same-direction non-zero events ending here.
+    size_t run_;
+  };
+
+  // Returns the running sums before the newest |count| events.
+  const Prefix& PrefixBefore(size_t count) const;
+  // Recomputes the running sums of the stored events, with the origin placed
+  // just before the oldest one.
+  void Rebuild();
+  // Fills |entry|'s prefix and run, given the entry before it.
+  void Accumulate(const Prefix& prev, const Entry* prev_entry,
+                  Entry* entry) const;
+
+  std::unique_ptr<Entry[]> buf_;
   size_t max_size_;
   size_t size_;
   size_t head_;
+  // Running sums just before the oldest stored event.
+  Prefix base_;
+  double weight_decay_;
   DISALLOW_COPY_AND_ASSIGN(ScrollEventBuffer);
 };
 
 // Circular buffer for storing a rolling backlog of events for analysis
 // as well as accessor functions for using the buffer's contents.
+// The FingerStates of all stored states live in one allocation, with each
+// state's fingers starting on their own cache line.
 class HardwareStateBuffer {
  public:
   explicit HardwareStateBuffer(size_t size);
-  ~HardwareStateBuffer();
 
   size_t Size() const { return size_; }
 
   void Reset(size_t max_finger_cnt);
 
-  // Does a deep copy of state into states_
+  // Does a deep copy of state into states_, unless state is NextState(), in
+  // which case it is already in place and nothing is copied.
   void PushState(const HardwareState& state);
   // Pops most recently pushed state
   void PopState();
 
+  // Returns the slot the next PushState() will use. A caller that builds a
+  // state here and then pushes it avoids copying its fingers.
+  HardwareState* NextState() { return Get(size_ - 1); }
+
   const HardwareState* Get(size_t idx) const {
     return &states_[(idx + newest_index_) % size_];
   }
@@ -138,6 +189,7 @@ class HardwareStateBuffer {
 
  private:
   std::unique_ptr<HardwareState[]> states_;
+  std::unique_ptr<char[]> finger_arena_;
   size_t newest_index_;
   size_t size_;
   size_t max_finger_cnt_;
@@ -157,6 +209,7 @@ struct Point {
 // Helper class for compute scroll and fling.
 class ScrollManager {
   FRIEND_TEST(ImmediateInterpreterTest, FlingDepthTest);
+  FRIEND_TEST(ImmediateInterpreterTest, ScrollEventBufferSumsTest);
   FRIEND_TEST(ImmediateInterpreterTest, ScrollManagerTest);
   FRIEND_TEST(MultitouchMouseInterpreterTest, SimpleTest);
 
@@ -271,6 +324,11 @@ class ScrollManager {
   // When computing a fling, if the fling buffer has an average speed under
   // this threshold, we do not perform a fling. Units are mm/sec.
   DoubleProperty fling_buffer_min_avg_speed_;
+  // When fitting the fling velocity, each scroll event is weighted this much
+  // relative to the next newer one. 1.0 gives an ordinary least squares fit;
+  // smaller values favor the newest events, which helps with deep fling
+  // buffers on high report rate pads.
+  DoubleProperty fling_buffer_weight_decay_;
 };
 
 // Helper class for computing the button type of multi-finger clicks.
@@ -608,8 +666,12 @@ class ImmediateInterpreter : public Interpreter, public PropertyDelegate {
 
   virtual void IntWasWritten(IntProperty* prop);
 
+  // Gives every tracking id a slot for the FingerMaps below. Updated at the
+  // start of each frame.
+  FingerSlotTable finger_slots_;
+
   // Fingers which are prohibited from ever tapping.
-  std::set<short> tap_dead_fingers_;
+  FingerMap tap_dead_fingers_;
 
   // Active gs fingers are the subset of gs_fingers that are actually performing
   // a gesture
@@ -649,7 +711,7 @@ class ImmediateInterpreter : public Interpreter, public PropertyDelegate {
   // When gesturing fingers move after change, we record the time.
   stime_t started_moving_time_;
   // Record which fingers have started moving already.
-  std::set<short> moving_;
+  FingerMap moving_;
 
   // When different fingers are gesturing, we record the time
   stime_t gs_changed_time_;
@@ -676,9 +738,9 @@ class ImmediateInterpreter : public Interpreter, public PropertyDelegate {
   std::map<short, Point> origin_positions_;
 
   // tracking ids of known fingers that are not palms, nor thumbs.
-  std::set<short> pointing_;
+  FingerMap pointing_;
   // tracking ids of known non-palms. But might be thumbs.
-  std::set<short> fingers_;
+  FingerMap fingers_;
   // contacts believed to be thumbs, and when they were inserted into the map
   std::map<short, stime_t> thumb_;
   // Timer of the evaluation period for contacts believed to be thumbs.
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -51,6 +52,14 @@ class Interpreter {
   // and reused for this timeout.
   virtual void SyncInterpret(HardwareState* hwstate, stime_t* timeout);
 
+  // Returns a state the caller may fill in and pass to the next
+  // SyncInterpret() call, which then keeps it instead of copying it, or NULL
+  // if there's no such state. Its fingers have room for max_finger_cnt
+  // fingers, and must not be pointed elsewhere. The caller may change it
+  // until that SyncInterpret() call and read it until it next calls into
+  // the interpreter. Initialize() may free it.
+  virtual HardwareState* NextInputState() { return NULL; }
+
   // Called to handle a timeout.
   // If *timeout is set to >0.0, a timer will be setup to call
   // HandleTimer after *timeout time passes. An interpreter can only
@@ -74,6 +83,9 @@ class Interpreter {
   virtual void ProduceGesture(const Gesture& gesture);
   const char* name() const { return name_; }
 
+  // Appends the counters of this interpreter and the ones it calls.
+  virtual void CollectStageStats(std::vector<GestureStageStats>* out) const;
+
  protected:
   std::unique_ptr<ActivityLog> log_;
   GestureConsumer* consumer_;
@@ -85,6 +97,8 @@ class Interpreter {
 
   void InitName();
   void Trace(const char* message, const char* name);
+  // Encodes the counters from CollectStageStats() for the activity log.
+  Json::Value EncodeStageStats() const;
 
   virtual void SyncInterpretImpl(HardwareState* hwstate,
                                  stime_t* timeout) {}
@@ -96,6 +110,7 @@ class Interpreter {
   const char* name_;
   Tracer* tracer_;
   bool enable_event_logging_ = false;
+  GestureStageStats stats_ = {};
 
   void LogOutputs(const Gesture* result, stime_t* timeout, const char* action);
 };
@@ -0,0 +1,54 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>  // for FRIEND_TEST
+
+#include "include/filter_interpreter.h"
+#include "include/gestures.h"
+#include "include/palm_model.h"
+#include "include/prop_registry.h"
+#include "include/tracer.h"
+
+#ifndef GESTURES_LEARNED_PALM_FILTER_INTERPRETER_H_
+#define GESTURES_LEARNED_PALM_FILTER_INTERPRETER_H_
+
+namespace gestures {
+
+// This filter interpreter scores each contact with a small quantized model
+// (see palm_model.h) over features from its last few frames, and marks it
+// GESTURES_FINGER_PALM or GESTURES_FINGER_POSSIBLE_PALM when the score is
+// over palm_threshold_ or possible_palm_threshold_. It only adds flags, so
+// it can run alongside the heuristic palm classifiers. It sits right after
+// scaling, so that it sees the same input as ExportPalmTrainingData() gives
+// a model in training.
+
+class LearnedPalmFilterInterpreter : public FilterInterpreter {
+  FRIEND_TEST(LearnedPalmFilterInterpreterTest, DisabledTest);
+  FRIEND_TEST(LearnedPalmFilterInterpreterTest, EdgeTest);
+  FRIEND_TEST(LearnedPalmFilterInterpreterTest, PressureTest);
+ public:
+  // Takes ownership of |next|:
+  LearnedPalmFilterInterpreter(PropRegistry* prop_reg, Interpreter* next,
+                               Tracer* tracer);
+  virtual ~LearnedPalmFilterInterpreter() {}
+
+  // Replaces the model, which must outlive this interpreter.
+  void SetModel(const PalmModelWeights* model) { model_ = model; }
+
+ protected:
+  virtual void SyncInterpretImpl(HardwareState* hwstate, stime_t* timeout);
+
+ private:
+  PalmFeatureExtractor features_;
+  const PalmModelWeights* model_;
+
+  BoolProperty enabled_;
+  // Scores at or over these mark a contact as a palm, or a possible palm.
+  DoubleProperty palm_threshold_;
+  DoubleProperty possible_palm_threshold_;
+};
+
+}  // namespace gestures
+
+#endif  // GESTURES_LEARNED_PALM_FILTER_INTERPRETER_H_
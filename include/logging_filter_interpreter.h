@@ -31,6 +31,8 @@ class LoggingFilterInterpreter : public FilterInterpreter,
   virtual void BoolWasWritten(BoolProperty* prop);
   virtual void IntWasWritten(IntProperty* prop);
 
+  // The encoded log also has a block with every interpreter's counters.
+  Json::Value EncodeCommonInfo();
   std::string EncodeActivityLog();
 
  private:
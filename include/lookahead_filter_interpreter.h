@@ -21,8 +21,12 @@
 namespace gestures {
 
 class LookaheadFilterInterpreter : public FilterInterpreter {
+  FRIEND_TEST(LookaheadFilterInterpreterTest, AdaptiveDelayTest);
+  FRIEND_TEST(LookaheadFilterInterpreterTest, BypassLatencyTest);
+  FRIEND_TEST(LookaheadFilterInterpreterTest, BypassTest);
   FRIEND_TEST(LookaheadFilterInterpreterTest, CyapaQuickTwoFingerMoveTest);
   FRIEND_TEST(LookaheadFilterInterpreterTest, DrumrollTest);
+  FRIEND_TEST(LookaheadFilterInterpreterTest, HandOffTest);
   FRIEND_TEST(LookaheadFilterInterpreterTest, InterpolateHwStateTest);
   FRIEND_TEST(LookaheadFilterInterpreterTest, InterpolateTest);
   FRIEND_TEST(LookaheadFilterInterpreterTest, InterpolationOverdueTest);
@@ -39,6 +43,10 @@ class LookaheadFilterInterpreter : public FilterInterpreter {
                              Tracer* tracer);
   virtual ~LookaheadFilterInterpreter() {}
 
+  // Hands out the state of the next queue node, so input filled in there
+  // isn't copied into the queue.
+  virtual HardwareState* NextInputState();
+
  protected:
   virtual void SyncInterpretImpl(HardwareState* hwstate,
                                  stime_t* timeout);
@@ -68,6 +76,14 @@ class LookaheadFilterInterpreter : public FilterInterpreter {
 
   void LogVectors();
 
+  // Inserts a node into queue_ before |pos| and returns it. The node is
+  // reused from free_nodes_ when possible, so steady state operation doesn't
+  // allocate. Its state is a copy of |state|, or cleared for the caller to
+  // fill in if |state| is NULL. The caller must fill in its due time.
+  QState* NewNode(List<QState>::iterator pos, const HardwareState* state);
+  // Moves the front node of queue_ to free_nodes_.
+  void RecycleFront();
+
   // Produces a tapdown fling gesture if we just got a new hardware state
   // with a finger missing from the previous, or a null gesture otherwise.
   void TapDownOccurringGesture(stime_t now);
@@ -78,8 +94,13 @@ class LookaheadFilterInterpreter : public FilterInterpreter {
   void AttemptInterpolation();
 
   // Reassigns tracking IDs, assigning them in such a way to avoid problems
-  // of drumroll.
-  void AssignTrackingIds();
+  // of drumroll. Returns true if the newest state may still need its IDs
+  // corrected, in which case it was given extra delay.
+  bool AssignTrackingIds();
+
+  // Returns true if the newest state continues a run of one finger states
+  // that can't need drumroll or liftoff correction.
+  bool SteadyPointing(bool may_need_correction);
 
   // For drumroll. Edits a QState node's fingerstate to have a new tracking id.
   void SeparateFinger(QState* node, FingerState* fs, short input_id);
@@ -104,9 +125,17 @@ class LookaheadFilterInterpreter : public FilterInterpreter {
                             stime_t* timeout);
   void ConsumeGesture(const Gesture& gesture);
 
+  // The delay applied to every state: min_delay_, or less in adaptive mode.
+  stime_t Delay() const;
+  // The delay added to states that may need drumroll or liftoff correction,
+  // up to a total of max_delay_.
   stime_t ExtraVariableDelay() const;
+  // Updates the report interval estimate with a new state's timestamp.
+  void UpdateReportInterval(stime_t timestamp);
 
   List<QState> queue_;
+  // Nodes that have left queue_, kept to avoid allocating new ones.
+  List<QState> free_nodes_;
 
   // The last id assigned to a contact (part of drumroll suppression)
   short last_id_;
@@ -121,6 +150,16 @@ class LookaheadFilterInterpreter : public FilterInterpreter {
 
   Gesture result_;
 
+  // Running estimates of the time between reports and of its mean absolute
+  // deviation, over report_samples_ reports.
+  stime_t last_report_time_ = -1.0;
+  stime_t report_interval_ = 0.0;
+  stime_t report_interval_dev_ = 0.0;
+  size_t report_samples_ = 0;
+
+  // Length of the current run of steady one finger states.
+  size_t steady_frames_ = 0;
+
   DoubleProperty min_nonsuppress_speed_;
   DoubleProperty min_delay_;
   // On some platforms, min_delay_ is very small, and sometimes we would like
@@ -156,6 +195,18 @@ class LookaheadFilterInterpreter : public FilterInterpreter {
   // If looking for a possible liftoff-move, the speed a finger is moving
   // relative to the previous speed, such that it's a possible leave.
   DoubleProperty liftoff_speed_increase_threshold_;
+  // If set, the delay is lowered from min_delay_ to the measured report
+  // interval plus adaptive_delay_jitter_factor_ times its deviation. That is
+  // enough for the next report to arrive before a state is passed on, which
+  // is what drumroll and quick move correction need.
+  BoolProperty adaptive_delay_enable_;
+  DoubleProperty adaptive_delay_jitter_factor_;
+  // Read-only: the delay currently applied to every state.
+  DoubleProperty current_delay_;
+  // If set, states of a single finger that has been moving steadily for a
+  // few reports skip the queue. A second contact, a button change, or a
+  // possible drumroll or liftoff puts the queue back in use.
+  BoolProperty single_finger_bypass_;
 };
 
 }  // namespace gestures
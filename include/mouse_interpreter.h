@@ -16,14 +16,20 @@ namespace gestures {
 
 class MouseInterpreter : public Interpreter, public PropertyDelegate {
   FRIEND_TEST(MouseInterpreterTest, SimpleTest);
+  FRIEND_TEST(MouseInterpreterTest, HandOffTest);
   FRIEND_TEST(MouseInterpreterTest, HighResolutionVerticalScrollTest);
   FRIEND_TEST(MouseInterpreterTest, JankyScrollTest);
   FRIEND_TEST(MouseInterpreterTest, WheelTickReportingHighResTest);
   FRIEND_TEST(MouseInterpreterTest, WheelTickReportingLowResTest);
+  FRIEND_TEST(MouseInterpreterTest, ScrollAccelTableTest);
  public:
   MouseInterpreter(PropRegistry* prop_reg, Tracer* tracer);
   virtual ~MouseInterpreter() {};
 
+  // Hands out the state not holding prev_state_. It has no room for
+  // fingers.
+  virtual HardwareState* NextInputState();
+
  protected:
   virtual void SyncInterpretImpl(HardwareState* hwstate, stime_t* timeout);
   // These functions interpret mouse events, which include button clicking and
@@ -37,9 +43,8 @@ class MouseInterpreter : public Interpreter, public PropertyDelegate {
 
   void InterpretMouseMotionEvent(const HardwareState& prev_state,
                                  const HardwareState& hwstate);
-  // Check for scroll wheel events and produce scroll gestures.
-  void InterpretScrollWheelEvent(const HardwareState& hwstate,
-                                 bool is_vertical);
+  // Check for scroll wheel events on both axes and produce scroll gestures.
+  void InterpretScrollWheelEvents(const HardwareState& hwstate);
   bool EmulateScrollWheel(const HardwareState& hwstate);
  private:
   struct WheelRecord {
@@ -49,14 +54,45 @@ class MouseInterpreter : public Interpreter, public PropertyDelegate {
     stime_t timestamp;
   };
 
+  // A scroll of one wheel axis, before acceleration.
+  struct WheelScroll {
+    stime_t start_time;
+    stime_t end_time;
+    float value;
+    float velocity;
+    int ticks;
+    bool is_vertical;
+  };
+
+  // Fills in |scroll| and returns true if the wheel on the given axis of
+  // |hwstate| moved.
+  bool ReadScrollWheel(const HardwareState& hwstate, bool is_vertical,
+                       WheelScroll* scroll);
+
+  void ProduceWheelScroll(const WheelScroll& scroll, double accel_factor);
+
   // Accelerate mouse scroll offsets so that it is larger when the user scroll
-  // the mouse wheel faster.
+  // the mouse wheel faster. Interpolates scroll_accel_table_.
   double ComputeScrollAccelFactor(double input_speed);
+  // The same for |count| speeds at once.
+  void ComputeScrollAccelFactors(const double* input_speeds, size_t count,
+                                 double* factors);
+
+  // Evaluates the scroll acceleration curve at |speed|.
+  double ScrollAccelCurve(double speed) const;
+
+  // Refills scroll_accel_table_ from the curve and the max input speed, if
+  // either changed since it was last filled.
+  void UpdateScrollAccelTable();
 
   Gesture CreateWheelGesture(stime_t start, stime_t end, float dx, float dy,
                              int tick_120ths_dx, int tick_120ths_dy);
 
-  HardwareState prev_state_;
+  // The last state, and a spare one for NextInputState(). The two are
+  // swapped when the spare is passed in, instead of copying it.
+  HardwareState states_[2];
+  HardwareState* prev_state_;
+  HardwareState* next_state_;
 
   // Records last scroll wheel event.
   WheelRecord last_wheel_, last_hwheel_;
@@ -71,6 +107,17 @@ class MouseInterpreter : public Interpreter, public PropertyDelegate {
   // f_approximated = a0 + a1*v + a2*v^2 + a3*v^3 + a4*v^4
   double scroll_accel_curve_[5];
 
+  // The curve sampled at evenly spaced speeds from 0 to the max input speed,
+  // so wheel events don't evaluate the polynomial. Linear interpolation
+  // between the samples stays within 0.02 of the default curve.
+  static const size_t kScrollAccelTableSize = 257;
+  float scroll_accel_table_[kScrollAccelTableSize];
+  // Table entries per unit of speed.
+  double scroll_accel_table_scale_;
+  // The curve and max input speed the table was sampled from.
+  double scroll_accel_table_curve_[5];
+  double scroll_accel_table_max_speed_;
+
   // Reverse wheel scrolling.
   BoolProperty reverse_scrolling_;
 
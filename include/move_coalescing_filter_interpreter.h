@@ -0,0 +1,62 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <gtest/gtest.h>  // for FRIEND_TEST
+
+#include "include/filter_interpreter.h"
+#include "include/gestures.h"
+#include "include/prop_registry.h"
+#include "include/tracer.h"
+
+#ifndef GESTURES_MOVE_COALESCING_FILTER_INTERPRETER_H_
+#define GESTURES_MOVE_COALESCING_FILTER_INTERPRETER_H_
+
+namespace gestures {
+
+// This filter interpreter merges the move gestures of high report rate mice,
+// so that at most one move is sent per coalescing_budget_ seconds (usually
+// a display frame). It sits right after acceleration, so each move it
+// merges has already been accelerated on its own, and the merged move is
+// the sum of them. The first move after a quiet budget is sent right away;
+// moves that follow within the budget are held and sent together when it
+// ends. Held motion is sent before any other gesture, to keep ordering.
+
+class MoveCoalescingFilterInterpreter : public FilterInterpreter {
+  FRIEND_TEST(MoveCoalescingFilterInterpreterTest, CoalesceTest);
+  FRIEND_TEST(MoveCoalescingFilterInterpreterTest, ButtonFlushTest);
+  FRIEND_TEST(MoveCoalescingFilterInterpreterTest, TimerTest);
+ public:
+  // Takes ownership of |next|:
+  MoveCoalescingFilterInterpreter(PropRegistry* prop_reg, Interpreter* next,
+                                  Tracer* tracer);
+  virtual ~MoveCoalescingFilterInterpreter() {}
+
+  virtual void ConsumeGesture(const Gesture& gesture);
+
+ protected:
+  virtual void SyncInterpretImpl(HardwareState* hwstate, stime_t* timeout);
+  virtual void HandleTimerImpl(stime_t now, stime_t* timeout);
+
+ private:
+  // Sends the held move, if any.
+  void Flush();
+  // Sends the held move if its budget is over, and returns the time at which
+  // it should be sent otherwise.
+  stime_t FlushIfDue(stime_t now);
+
+  // The time of the current SyncInterpret or HandleTimer call.
+  stime_t now_;
+  // When the last move was sent.
+  stime_t last_move_time_;
+  bool has_pending_;
+  Gesture pending_;
+
+  // Minimum time between two move gestures, in seconds. 0 disables the
+  // filter.
+  DoubleProperty coalescing_budget_;
+};
+
+}  // namespace gestures
+
+#endif  // GESTURES_MOVE_COALESCING_FILTER_INTERPRETER_H_
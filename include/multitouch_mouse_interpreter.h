@@ -31,11 +31,16 @@ class Origin {
 };
 
 class MultitouchMouseInterpreter : public MouseInterpreter {
+  FRIEND_TEST(MultitouchMouseInterpreterTest, HandOffTest);
   FRIEND_TEST(MultitouchMouseInterpreterTest, SimpleTest);
  public:
   MultitouchMouseInterpreter(PropRegistry* prop_reg, Tracer* tracer);
   virtual ~MultitouchMouseInterpreter() {}
 
+  // Hands out the next slot of state_buffer_, so the state is built in
+  // place instead of being copied into it.
+  virtual HardwareState* NextInputState();
+
  protected:
   virtual void SyncInterpretImpl(HardwareState* hwstate, stime_t* timeout);
   virtual void Initialize(const HardwareProperties* hw_props,
@@ -52,6 +57,8 @@ class MultitouchMouseInterpreter : public MouseInterpreter {
   HardwareState prev_state_;
   ScrollEventBuffer scroll_buffer_;
 
+  // Gives every tracking id a slot for the FingerMaps below.
+  FingerSlotTable finger_slots_;
   FingerMap prev_gs_fingers_;
   FingerMap gs_fingers_;
 
@@ -71,7 +78,7 @@ class MultitouchMouseInterpreter : public MouseInterpreter {
   std::map<short, Vector2> start_position_;
 
   // These fingers have started moving and should cause gestures.
-  std::set<short> moving_;
+  FingerMap moving_;
 
   // Depth of recent scroll event buffer used to compute click.
   IntProperty click_buffer_depth_;
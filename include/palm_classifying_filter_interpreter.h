@@ -2,12 +2,12 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include <map>
-#include <set>
+#include <stdint.h>
 
 #include <gtest/gtest.h>  // for FRIEND_TEST
 
 #include "include/filter_interpreter.h"
+#include "include/finger_map.h"
 #include "include/finger_metrics.h"
 #include "include/gestures.h"
 #include "include/macros.h"
@@ -28,6 +28,7 @@ class PalmClassifyingFilterInterpreter : public FilterInterpreter {
   FRIEND_TEST(PalmClassifyingFilterInterpreterTest, PalmAtEdgeTest);
   FRIEND_TEST(PalmClassifyingFilterInterpreterTest, PalmReevaluateTest);
   FRIEND_TEST(PalmClassifyingFilterInterpreterTest, PalmTest);
+  FRIEND_TEST(PalmClassifyingFilterInterpreterTest, ReturningIdTest);
   FRIEND_TEST(PalmClassifyingFilterInterpreterTest, StationaryPalmTest);
  public:
   // Takes ownership of |next|:
@@ -39,9 +40,42 @@ class PalmClassifyingFilterInterpreter : public FilterInterpreter {
   virtual void SyncInterpretImpl(HardwareState* hwstate, stime_t* timeout);
 
  private:
-  void FillOriginInfo(const HardwareState& hwstate);
-  void FillPrevInfo(const HardwareState& hwstate);
-  void FillMaxPressureWidthInfo(const HardwareState& hwstate);
+  // Everything tracked about one contact. Reset when its tracking id
+  // arrives, and kept while the id stays on the pad.
+  struct Contact {
+    // Time when the contact arrived, and its FingerState then.
+    stime_t origin_time;
+    FingerState origin;
+    // The FingerState from the previous HardwareState.
+    FingerState prev;
+    // Max reported pressure and width.
+    float max_pressure;
+    float max_width;
+    // Accumulated distance travelled.
+    // distance_positive[0]  -->  positive direction along x axis
+    // distance_positive[1]  -->  positive direction along y axis
+    // distance_negative[0]  -->  negative direction along x axis
+    // distance_negative[1]  -->  negative direction along y axis
+    float distance_positive[2];
+    float distance_negative[2];
+    // Known palm.
+    bool palm;
+    // Palm because of a large contact size. Implies palm.
+    bool large_palm;
+    // Has moved significantly and shouldn't be considered a stationary palm.
+    bool non_stationary_palm;
+    // Reasons (kPoint* bits) this is a known finger that is not a palm, or 0
+    // if it isn't known to be one.
+    unsigned pointing;
+    // Was ever close to other fingers.
+    bool was_near_other_fingers;
+    // Has ever travelled out of the palm envelope or bottom area.
+    bool not_in_edge;
+  };
+
+  // Finds the Contact of each finger, resetting those of new contacts, and
+  // updates their origin, max pressure/width and distance travelled.
+  void UpdateContacts(const HardwareState& hwstate);
 
   // Part of palm detection. Returns true if the finger indicated by
   // |finger_idx| is near another finger, which must not be a palm, in the
@@ -58,65 +92,38 @@ class PalmClassifyingFilterInterpreter : public FilterInterpreter {
   // Returns true iff fs represents a contact that is in the bottom area.
   bool FingerInBottomArea(const FingerState& fs);
 
-  // Updates *palm_, pointing_ below.
+  // Updates the palm and pointing state of the contacts.
   void UpdatePalmState(const HardwareState& hwstate);
 
   // Updates the hwstate based on the local state.
   void UpdatePalmFlags(HardwareState* hwstate);
 
-  // Updates the distance travelled for each finger along +- x/y direction.
-  void UpdateDistanceInfo(const HardwareState& hwstate);
-
-  // Returns the length of time the contact has been on the pad. Returns -1
-  // on error.
-  stime_t FingerAge(short finger_id, stime_t now) const;
-
-  // Time when a contact arrived. Persists even when fingers change.
-  std::map<short, stime_t> origin_timestamps_;
-  // FingerStates from when a contact first arrived. Persists even when fingers
-  // change.
-  std::map<short, FingerState> origin_fingerstates_;
-
-  // FingerStates from the previous HardwareState.
-  std::map<short, FingerState> prev_fingerstates_;
-
-  // Max reported pressure for present fingers.
-  std::map<short, float> max_pressure_;
-
-  // Max reported width for present fingers.
-  std::map<short, float> max_width_;
-
-  // Accumulated distance travelled by each finger.
-  // _positive[0]  -->  positive direction along x axis
-  // _positive[1]  -->  positive direction along y axis
-  // _negative[0]  -->  negative direction along x axis
-  // _negative[1]  -->  negative direction along y axis
-  std::map<short, float> distance_positive_[2];
-  std::map<short, float> distance_negative_[2];
-
-  // Same fingers state. This state is accumulated as fingers remain the same
-  // and it's reset when fingers change.
-  std::set<short> palm_;  // tracking ids of known palms
-  // These contacts are a subset of palms_ which are marked as palms because
-  // they have a large contact size.
-  std::set<short> large_palm_;
-  // These contacts have moved significantly and shouldn't be considered
-  // stationary palms:
-  std::set<short> non_stationary_palm_;
+  // Returns the length of time the contact has been on the pad.
+  stime_t FingerAge(const Contact& contact, stime_t now) const {
+    return now - contact.origin_time;
+  }
+
+  // Returns the Contact of |id| if it's on the pad, or NULL.
+  const Contact* ContactForId(short id) const;
+  bool IsPalm(short id) const;
+  bool IsPointing(short id) const;
 
   static const unsigned kPointCloseToFinger = 1;
   static const unsigned kPointNotInEdge = 2;
   static const unsigned kPointMoving = 4;
-  // tracking ids of known fingers that are not palms, along with the reason(s)
-  std::map<short, unsigned> pointing_;
-
-
-  // tracking ids that were ever close to other fingers.
-  std::set<short> was_near_other_fingers_;
 
-  // tracking ids that have ever travelled out of the palm envelope or bottom
-  // area.
-  std::set<short> fingers_not_in_edge_;
+  // Gives every tracking id a slot in contacts_.
+  FingerSlotTable finger_slots_;
+  Contact contacts_[kMaxFingerSlots];
+  // Slots of the contacts in the previous and current HardwareState.
+  uint64_t prev_present_;
+  uint64_t present_;
+  // The Contact of each finger in the current HardwareState, by finger
+  // index, or NULL past kMaxFingerSlots fingers.
+  Contact* finger_contacts_[kMaxFingerSlots];
+
+  // Pairwise finger distances for the current hwstate.
+  FingerDistances finger_distances_;
 
   // Previously input timestamp
   stime_t prev_time_;
@@ -0,0 +1,136 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GESTURES_PALM_MODEL_H_
+#define GESTURES_PALM_MODEL_H_
+
+#include <stdint.h>
+
+#include "include/finger_map.h"
+#include "include/gestures.h"
+
+// A tiny quantized classifier that scores how much a contact looks like a
+// palm, and the per-contact features it reads. PalmFeatureExtractor turns
+// the last few frames of each contact into kPalmFeatureCount floats, and
+// EvaluatePalmModel() runs a one hidden layer perceptron with int8 weights
+// and int32 accumulators on them. The same extractor is used to export
+// training data (see palm_training_exporter.h), so a trained model sees the
+// same features in the field as it did in training.
+
+namespace gestures {
+
+enum PalmFeature {
+  kPalmFeaturePressure,
+  kPalmFeatureTouchMajor,
+  kPalmFeatureTouchMinor,
+  // Largest values since the contact arrived.
+  kPalmFeatureMaxPressure,
+  kPalmFeatureMaxTouchMajor,
+  // Distance to the nearest side edge, the bottom edge and the top edge.
+  kPalmFeatureSideEdgeDist,
+  kPalmFeatureBottomEdgeDist,
+  kPalmFeatureTopEdgeDist,
+  // Over the frames in the history: average speed, change in pressure and
+  // width, and distance travelled beyond the net displacement (zig-zag).
+  kPalmFeatureSpeed,
+  kPalmFeaturePressureChange,
+  kPalmFeatureTouchMajorChange,
+  kPalmFeatureJitter,
+  // Seconds since the contact arrived, and distance from where it did.
+  kPalmFeatureAge,
+  kPalmFeatureTravel,
+  kPalmFeatureFingerCount,
+  // Distance to the closest other contact, or kPalmNoNeighborDist.
+  kPalmFeatureNearestDist,
+  kPalmFeatureCount
+};
+
+static const size_t kPalmModelHidden = 8;
+// Frames of history kept per contact.
+static const size_t kPalmHistorySize = 8;
+// kPalmFeatureNearestDist of a contact that is alone on the pad.
+static const float kPalmNoNeighborDist = 100.0;
+
+// Weights of the model, kept as a plain aggregate so a trained model can be
+// compiled in as an initializer. The score of a feature vector f is:
+//   q[i] = sat(round((f[i] - input_offset[i]) * input_scale[i]))
+//   h[j] = sat(max(0, hidden_bias[j] + sum_i hidden_weights[j][i] * q[i])
+//              >> hidden_shift)
+//   score = (output_bias + sum_j output_weights[j] * h[j]) * output_scale
+// where sat() saturates to [-127, 127].
+struct PalmModelWeights {
+  float input_offset[kPalmFeatureCount];
+  float input_scale[kPalmFeatureCount];
+  int8_t hidden_weights[kPalmModelHidden][kPalmFeatureCount];
+  int32_t hidden_bias[kPalmModelHidden];
+  int hidden_shift;
+  int8_t output_weights[kPalmModelHidden];
+  int32_t output_bias;
+  float output_scale;
+};
+
+// A hand-set model that reproduces the main heuristics of
+// PalmClassifyingFilterInterpreter: contacts that ever pressed with 200 or
+// more or were 21.2 mm or wider score 2, and contacts resting within a few
+// mm of the bottom or side edges score between 0.5 and 1.
+extern const PalmModelWeights kDefaultPalmModel;
+
+// Quantizes |features| (kPalmFeatureCount of them) for |weights| into |out|.
+void QuantizePalmFeatures(const PalmModelWeights& weights,
+                          const float* features, int8_t* out);
+
+// Returns the score of the quantized features |q|.
+float ScorePalmFeatures(const PalmModelWeights& weights, const int8_t* q);
+
+// Returns the score of |features|.
+float EvaluatePalmModel(const PalmModelWeights& weights,
+                        const float* features);
+
+// Keeps the recent history of each contact and computes its features.
+class PalmFeatureExtractor {
+ public:
+  PalmFeatureExtractor();
+
+  // Adds |hwstate| to the history of its contacts. Call once per frame,
+  // before Features().
+  void Update(const HardwareState& hwstate);
+
+  // Forgets all contacts, so every contact in the next Update() is new.
+  void Clear() { present_ = 0; }
+
+  // Fills |out| with the kPalmFeatureCount features of finger |finger_idx|
+  // of |hwstate|, which must be the state last passed to Update(). Returns
+  // false if the finger has no history, which only happens past
+  // kMaxFingerSlots fingers.
+  bool Features(const HardwareProperties& hwprops,
+                const HardwareState& hwstate, size_t finger_idx,
+                float* out) const;
+
+ private:
+  struct Contact {
+    stime_t origin_time;
+    float origin_x;
+    float origin_y;
+    float max_pressure;
+    float max_touch_major;
+    // Ring buffer of the last |size| frames; |head| is the newest.
+    stime_t time[kPalmHistorySize];
+    float x[kPalmHistorySize];
+    float y[kPalmHistorySize];
+    float pressure[kPalmHistorySize];
+    float touch_major[kPalmHistorySize];
+    size_t head;
+    size_t size;
+  };
+
+  FingerSlotTable finger_slots_;
+  Contact contacts_[kMaxFingerSlots];
+  // Slots of the contacts in the previous and current HardwareState.
+  uint64_t prev_present_;
+  uint64_t present_;
+};
+
+}  // namespace gestures
+
+#endif  // GESTURES_PALM_MODEL_H_
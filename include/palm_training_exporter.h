@@ -0,0 +1,27 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GESTURES_PALM_TRAINING_EXPORTER_H_
+#define GESTURES_PALM_TRAINING_EXPORTER_H_
+
+#include <string>
+
+// Offline tooling to train the model of LearnedPalmFilterInterpreter from
+// touchpad activity logs.
+
+namespace gestures {
+
+// Replays the hardware states of the activity log |log_data| through the
+// scaling the touchpad chain does, with the logged properties, and returns
+// CSV training data for a palm model. After a header line, there is one row
+// per contact per state: the timestamp, the tracking id, the
+// kPalmFeatureCount features that LearnedPalmFilterInterpreter would see,
+// and a label. The label is what PalmClassifyingFilterInterpreter makes of
+// the contact (0 finger, 1 possible palm, 2 palm), as a starting point for
+// hand labeling. Returns an empty string if the log can't be parsed.
+std::string ExportPalmTrainingData(const std::string& log_data);
+
+}  // namespace gestures
+
+#endif  // GESTURES_PALM_TRAINING_EXPORTER_H_
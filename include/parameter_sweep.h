@@ -0,0 +1,92 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GESTURES_PARAMETER_SWEEP_H_
+#define GESTURES_PARAMETER_SWEEP_H_
+
+#include <string>
+#include <vector>
+
+#include <json/value.h>
+
+#include "include/activity_replay.h"
+#include "include/gesture_differ.h"
+#include "include/gestures.h"
+
+// ParameterSweep replays one activity log under many property configurations.
+// The log is parsed once and shared read-only. Each configuration gets its own
+// interpreter chain, and the chains run concurrently on worker threads.
+
+namespace gestures {
+
+struct SweepConfig {
+  std::string name;
+  // Dict of property name to value, applied on top of the logged properties.
+  // Logged changes to these properties are ignored during the replay.
+  Json::Value overrides;
+};
+
+struct SweepResult {
+  std::string name;
+  // False if some override couldn't be applied.
+  bool ok = true;
+  // Everything the chain produced, in order.
+  std::vector<Gesture> gestures;
+
+  // Comparison against the gestures in the log, matched in order the way
+  // ActivityReplay::Replay() does.
+  size_t matched = 0;
+  size_t missing = 0;  // Logged, but not produced
+  size_t unexpected = 0;  // Produced, but not logged
+  // Time-aligned comparison of the produced and logged gestures, which
+  // tolerates small timing shifts and measures how far values moved.
+  GestureDiff diff;
+
+  // Summary metrics of the output.
+  size_t buttons_changes = 0;
+  size_t flings = 0;
+  double move_distance = 0.0;
+  double scroll_distance = 0.0;
+};
+
+class ParameterSweep {
+ public:
+  ParameterSweep();
+
+  // Parses the log. Returns true on success.
+  bool Parse(const std::string& data);
+
+  // By default a produced gesture must equal the logged one. With a
+  // tolerance, times may differ by |time_tolerance| seconds, and values by
+  // |value_tolerance| times their magnitude (at least 1).
+  void SetTolerance(double time_tolerance, double value_tolerance) {
+    time_tolerance_ = time_tolerance;
+    value_tolerance_ = value_tolerance;
+  }
+
+  // Replays the log once per config on chains built for |cls|, using up to
+  // |max_threads| threads (0 means one per core). Results are in the order
+  // of |configs|.
+  std::vector<SweepResult> Run(const std::vector<SweepConfig>& configs,
+                               GestureInterpreterDeviceClass cls,
+                               size_t max_threads);
+
+ private:
+  void RunOne(const SweepConfig& config, GestureInterpreterDeviceClass cls,
+              SweepResult* result);
+
+  ActivityReplay replay_;
+  double time_tolerance_;
+  double value_tolerance_;
+};
+
+// Returns true if |a| and |b| are the same kind of gesture, and their times
+// and values are within the given tolerances, as described for
+// ParameterSweep::SetTolerance().
+bool GesturesNear(const Gesture& a, const Gesture& b, double time_tolerance,
+                  double value_tolerance);
+
+}  // namespace gestures
+
+#endif  // GESTURES_PARAMETER_SWEEP_H_
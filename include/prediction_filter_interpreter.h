@@ -0,0 +1,84 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <map>
+
+#include <gtest/gtest.h>  // for FRIEND_TEST
+
+#include "include/filter_interpreter.h"
+#include "include/finger_metrics.h"
+#include "include/gestures.h"
+#include "include/prop_registry.h"
+#include "include/tracer.h"
+
+#ifndef GESTURES_PREDICTION_FILTER_INTERPRETER_H_
+#define GESTURES_PREDICTION_FILTER_INTERPRETER_H_
+
+namespace gestures {
+
+// This filter interpreter moves each finger ahead along its recent path, to
+// make up for the time input spends in the lookahead queue and in smoothing
+// filters. For each tracking id it fits a line, per axis, through the
+// positions of the last prediction_window_ seconds, and reports the position
+// prediction_lead_ seconds ahead on that line.
+//
+// Prediction is only trusted while the finger moves steadily: it is turned
+// off for a finger that is warping, is a palm, moves slower than
+// min_speed_ or has just reversed direction (its latest step points away
+// from the fitted velocity). After that, it is faded back in over a few
+// reports. The offset actually applied follows the prediction by at most half
+// the finger's step per report, so neither turning prediction on nor off
+// makes the finger jump.
+
+class PredictionFilterInterpreter : public FilterInterpreter {
+  FRIEND_TEST(PredictionFilterInterpreterTest, LatencyTest);
+  FRIEND_TEST(PredictionFilterInterpreterTest, ReversalTest);
+  FRIEND_TEST(PredictionFilterInterpreterTest, WarpTest);
+ public:
+  // Takes ownership of |next|:
+  PredictionFilterInterpreter(PropRegistry* prop_reg, Interpreter* next,
+                              Tracer* tracer);
+  virtual ~PredictionFilterInterpreter() {}
+
+ protected:
+  virtual void SyncInterpretImpl(HardwareState* hwstate, stime_t* timeout);
+
+ private:
+  // Recent input positions of one finger, oldest first, how much of the
+  // prediction is currently trusted and the offset currently applied.
+  struct History {
+    static const size_t kSize = 8;
+    stime_t time[kSize];
+    float x[kSize];
+    float y[kSize];
+    size_t size = 0;
+    float confidence = 0.0;
+    float offset_x = 0.0;
+    float offset_y = 0.0;
+
+    void Push(stime_t now, float pos_x, float pos_y);
+  };
+
+  // Predicts |fs| from |history|, which must already contain |fs|.
+  void Predict(History* history, FingerState* fs);
+
+  // Sets |dx|, |dy| to how far ahead of its last position |history| says
+  // the finger will be, and returns true, unless prediction isn't trusted.
+  bool FitOffset(History* history, unsigned flags, double* dx, double* dy);
+
+  std::map<short, History> histories_;
+
+  // How far ahead to predict, in seconds. 0 disables the filter.
+  DoubleProperty prediction_lead_;
+  // How far back positions are used to fit the finger's motion, in seconds.
+  DoubleProperty prediction_window_;
+  // Fingers moving slower than this, in mm/s, aren't predicted.
+  DoubleProperty min_speed_;
+  // Predictions are at most this far from the reported position, in mm.
+  DoubleProperty max_distance_;
+};
+
+}  // namespace gestures
+
+#endif  // GESTURES_PREDICTION_FILTER_INTERPRETER_H_
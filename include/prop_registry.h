@@ -5,8 +5,14 @@
 #ifndef GESTURES_PROP_REGISTRY_H__
 #define GESTURES_PROP_REGISTRY_H__
 
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <json/value.h>
 
@@ -20,16 +26,63 @@ class Property;
 
 class PropRegistry {
  public:
-  PropRegistry() : prop_provider_(NULL), activity_log_(NULL) {}
+  PropRegistry()
+      : prop_provider_(NULL), activity_log_(NULL), defer_creation_(false),
+        staged_writes_(false), write_epoch_(0), published_epoch_(0) {}
 
   void Register(Property* prop);
   void Unregister(Property* prop);
 
+  // While deferred creation is on, properties are not created with the prop
+  // provider when they are registered, or when the provider is set. They keep
+  // their defaults and are queued until CreateDeferredProps(). Turning it off
+  // creates the queued properties.
+  void SetDeferredCreation(bool defer);
+  bool deferred_creation() const { return defer_creation_; }
+
+  // Creates all queued properties with the prop provider, in the order they
+  // were queued. Cheap when the queue is empty.
+  void CreateDeferredProps();
+  // Creates just |prop| now, if it is queued. For properties whose
+  // provider value is needed right away.
+  void CreateDeferredProp(Property* prop);
+
+  // In staged mode, the prop provider writes each property into a staging
+  // copy instead of the live value. A written notification copies the staged
+  // value aside, and the live values and *WasWritten delegates are only
+  // updated by PublishStagedWrites(). This lets another thread write
+  // properties without tearing values that an interpreter is using
+  // mid-frame. Must be set before the prop provider.
+  void SetStagedWrites(bool staged);
+  bool staged_writes() const { return staged_writes_; }
+
+  // Applies the property writes staged since the last call, then runs their
+  // notifications. Call it on the input thread between frames. It costs one
+  // atomic load when nothing was written.
+  void PublishStagedWrites();
+
+  // Called when the provider has written |prop| in staged mode.
+  void StageWrite(Property* prop);
+  // Called before the provider reads |prop| in staged mode. Copies the live
+  // value to the staging copy, unless a write to it is still to be
+  // published. Returns true if the staging copy changed.
+  bool RefreshStagedValue(Property* prop);
+
   void SetPropProvider(GesturesPropProvider* prop_provider, void* data);
   GesturesPropProvider* PropProvider() const { return prop_provider_; }
   void* PropProviderData() const { return prop_provider_data_; }
   const std::set<Property*>& props() const { return props_; }
 
+  // Returns the earliest registered property named |name|, or NULL. This is
+  // a binary search of the name index.
+  Property* FindProperty(const char* name) const;
+
+  // Applies a dict of property name to value, such as a device profile, in
+  // one pass. After all values are set, each property whose value changed
+  // gets a single written notification. Names with no registered property
+  // are skipped. Returns false if any value couldn't be set.
+  bool ApplyProperties(const Json::Value& values);
+
   void set_activity_log(ActivityLog* activity_log) {
     activity_log_ = activity_log;
   }
@@ -39,7 +92,27 @@ class PropRegistry {
   GesturesPropProvider* prop_provider_;
   void* prop_provider_data_;
   std::set<Property*> props_;
+  // The registered properties sorted by name. Properties with the same name
+  // stay in registration order.
+  std::vector<Property*> props_by_name_;
   ActivityLog* activity_log_;
+
+  // Creates |prop| with the prop provider, or queues it in deferred mode.
+  void CreateOrDefer(Property* prop);
+
+  bool defer_creation_;
+  // Properties waiting to be created with the prop provider.
+  std::vector<Property*> deferred_props_;
+
+  bool staged_writes_;
+  // Guards the pending values of staged properties and pending_props_.
+  // Only taken when a property is written or published.
+  std::mutex staging_lock_;
+  std::vector<Property*> pending_props_;
+  // Bumped for every staged write. PublishStagedWrites() returns early if it
+  // matches the epoch it last published.
+  std::atomic<uint64_t> write_epoch_;
+  uint64_t published_epoch_;
 };
 
 class PropertyDelegate;
@@ -57,6 +130,12 @@ class Property {
   void CreateProp();
   virtual void CreatePropImpl() = 0;
   void DestroyProp();
+  // Creates this property with the prop provider now, if its creation was
+  // deferred. Call it before reading the provider's value or overriding it.
+  void CreateDeferred() {
+    if (parent_)
+      parent_->CreateDeferredProp(this);
+  }
 
   void SetDelegate(PropertyDelegate* delegate) {
     delegate_ = delegate;
@@ -73,20 +152,43 @@ class Property {
         reinterpret_cast<Property*>(data)->HandleGesturesPropWillRead();
     return ret;
   }
-  // TODO(adlr): pass on will-read notifications
-  virtual GesturesPropBool HandleGesturesPropWillRead() { return 0; }
+  // Called before the provider reads the value. Returns non-zero if it
+  // changed the value the provider is about to read.
+  virtual GesturesPropBool HandleGesturesPropWillRead();
   static void StaticHandleGesturesPropWritten(void* data) {
     reinterpret_cast<Property*>(data)->HandleGesturesPropWritten();
   }
-  virtual void HandleGesturesPropWritten() = 0;
+  // Called after the provider writes a new value. Notifies right away, or
+  // stages the write if the registry is in staged mode.
+  void HandleGesturesPropWritten();
 
  protected:
+  friend class PropRegistry;
+
+  // Returns true if the provider writes to the staging copy of this property.
+  bool Staged() const {
+    return gprop_ && parent_ && parent_->staged_writes();
+  }
+  // Logs the new value and tells the delegate about it.
+  virtual void NotifyWritten() = 0;
+  // In staged mode, copies the value written by the provider to the pending
+  // value, and the pending value to the live value. RefreshStaged() copies
+  // the live value back to the value the provider reads, and returns true if
+  // that changed it. All are called with the registry's staging lock held.
+  virtual void StageWrite() = 0;
+  virtual void ApplyStagedWrite() = 0;
+  virtual bool RefreshStaged() = 0;
+
   GesturesProp* gprop_ = NULL;
   PropRegistry* parent_;
   PropertyDelegate* delegate_ = NULL;
 
  private:
   const char* name_;
+  // Set while this property is in the registry's pending_props_.
+  bool staged_pending_ = false;
+  // Set while this property is in the registry's deferred_props_.
+  bool create_deferred_ = false;
 };
 
 class BoolProperty : public Property {
@@ -99,9 +201,23 @@ class BoolProperty : public Property {
   virtual void CreatePropImpl();
   virtual Json::Value NewValue() const;
   virtual bool SetValue(const Json::Value& value);
-  virtual void HandleGesturesPropWritten();
 
   GesturesPropBool val_;
+
+ protected:
+  virtual void NotifyWritten();
+  virtual void StageWrite() { pending_val_ = staged_val_; }
+  virtual void ApplyStagedWrite() { val_ = pending_val_; }
+  virtual bool RefreshStaged() {
+    if (staged_val_ == val_)
+      return false;
+    staged_val_ = val_;
+    return true;
+  }
+
+ private:
+  GesturesPropBool staged_val_;
+  GesturesPropBool pending_val_;
 };
 
 class BoolArrayProperty : public Property {
@@ -115,10 +231,26 @@ class BoolArrayProperty : public Property {
   virtual void CreatePropImpl();
   virtual Json::Value NewValue() const;
   virtual bool SetValue(const Json::Value& list);
-  virtual void HandleGesturesPropWritten();
 
   GesturesPropBool* vals_;
   size_t count_;
+
+ protected:
+  virtual void NotifyWritten();
+  virtual void StageWrite() { pending_vals_ = staged_vals_; }
+  virtual void ApplyStagedWrite() {
+    std::copy(pending_vals_.begin(), pending_vals_.end(), vals_);
+  }
+  virtual bool RefreshStaged() {
+    if (std::equal(vals_, vals_ + count_, staged_vals_.begin()))
+      return false;
+    std::copy(vals_, vals_ + count_, staged_vals_.begin());
+    return true;
+  }
+
+ private:
+  std::vector<GesturesPropBool> staged_vals_;
+  std::vector<GesturesPropBool> pending_vals_;
 };
 
 class DoubleProperty : public Property {
@@ -131,9 +263,23 @@ class DoubleProperty : public Property {
   virtual void CreatePropImpl();
   virtual Json::Value NewValue() const;
   virtual bool SetValue(const Json::Value& value);
-  virtual void HandleGesturesPropWritten();
 
   double val_;
+
+ protected:
+  virtual void NotifyWritten();
+  virtual void StageWrite() { pending_val_ = staged_val_; }
+  virtual void ApplyStagedWrite() { val_ = pending_val_; }
+  virtual bool RefreshStaged() {
+    if (staged_val_ == val_)
+      return false;
+    staged_val_ = val_;
+    return true;
+  }
+
+ private:
+  double staged_val_;
+  double pending_val_;
 };
 
 class DoubleArrayProperty : public Property {
@@ -147,10 +293,26 @@ class DoubleArrayProperty : public Property {
   virtual void CreatePropImpl();
   virtual Json::Value NewValue() const;
   virtual bool SetValue(const Json::Value& list);
-  virtual void HandleGesturesPropWritten();
 
   double* vals_;
   size_t count_;
+
+ protected:
+  virtual void NotifyWritten();
+  virtual void StageWrite() { pending_vals_ = staged_vals_; }
+  virtual void ApplyStagedWrite() {
+    std::copy(pending_vals_.begin(), pending_vals_.end(), vals_);
+  }
+  virtual bool RefreshStaged() {
+    if (std::equal(vals_, vals_ + count_, staged_vals_.begin()))
+      return false;
+    std::copy(vals_, vals_ + count_, staged_vals_.begin());
+    return true;
+  }
+
+ private:
+  std::vector<double> staged_vals_;
+  std::vector<double> pending_vals_;
 };
 
 class IntProperty : public Property {
@@ -163,9 +325,23 @@ class IntProperty : public Property {
   virtual void CreatePropImpl();
   virtual Json::Value NewValue() const;
   virtual bool SetValue(const Json::Value& value);
-  virtual void HandleGesturesPropWritten();
 
   int val_;
+
+ protected:
+  virtual void NotifyWritten();
+  virtual void StageWrite() { pending_val_ = staged_val_; }
+  virtual void ApplyStagedWrite() { val_ = pending_val_; }
+  virtual bool RefreshStaged() {
+    if (staged_val_ == val_)
+      return false;
+    staged_val_ = val_;
+    return true;
+  }
+
+ private:
+  int staged_val_;
+  int pending_val_;
 };
 
 class IntArrayProperty : public Property {
@@ -179,10 +355,26 @@ class IntArrayProperty : public Property {
   virtual void CreatePropImpl();
   virtual Json::Value NewValue() const;
   virtual bool SetValue(const Json::Value& list);
-  virtual void HandleGesturesPropWritten();
 
   int* vals_;
   size_t count_;
+
+ protected:
+  virtual void NotifyWritten();
+  virtual void StageWrite() { pending_vals_ = staged_vals_; }
+  virtual void ApplyStagedWrite() {
+    std::copy(pending_vals_.begin(), pending_vals_.end(), vals_);
+  }
+  virtual bool RefreshStaged() {
+    if (std::equal(vals_, vals_ + count_, staged_vals_.begin()))
+      return false;
+    std::copy(vals_, vals_ + count_, staged_vals_.begin());
+    return true;
+  }
+
+ private:
+  std::vector<int> staged_vals_;
+  std::vector<int> pending_vals_;
 };
 
 class StringProperty : public Property {
@@ -195,10 +387,31 @@ class StringProperty : public Property {
   virtual void CreatePropImpl();
   virtual Json::Value NewValue() const;
   virtual bool SetValue(const Json::Value& value);
-  virtual void HandleGesturesPropWritten();
 
   std::string parsed_val_;
   const char* val_;
+
+ protected:
+  virtual void NotifyWritten();
+  virtual void StageWrite() { pending_val_ = staged_val_ ? staged_val_ : ""; }
+  virtual void ApplyStagedWrite() {
+    parsed_val_ = pending_val_;
+    val_ = parsed_val_.c_str();
+  }
+  virtual bool RefreshStaged() {
+    if (staged_val_ && !strcmp(staged_val_, val_))
+      return false;
+    // The live value may be freed by the next ApplyStagedWrite(), so the
+    // provider reads a copy.
+    refreshed_val_ = val_;
+    staged_val_ = refreshed_val_.c_str();
+    return true;
+  }
+
+ private:
+  const char* staged_val_ = NULL;
+  std::string pending_val_;
+  std::string refreshed_val_;
 };
 
 class PropertyDelegate {
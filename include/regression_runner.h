@@ -0,0 +1,75 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GESTURES_REGRESSION_RUNNER_H_
+#define GESTURES_REGRESSION_RUNNER_H_
+
+#include <string>
+#include <vector>
+
+#include <json/value.h>
+
+#include "include/gestures.h"
+
+// RegressionRunner replays a corpus of activity logs, each through the chain
+// for its device, and checks the produced gestures against the ones recorded
+// in the log. Logs run in parallel on a pool of threads. The report has the
+// same schema as tools/touchtests-report.json: a dict from test name to
+// {description, disabled, error, result, score}.
+
+namespace gestures {
+
+class RegressionRunner {
+ public:
+  RegressionRunner();
+
+  // Adds every file under |dir| whose name ends in |suffix|, recursively, to
+  // be replayed on the chain for |cls|. The test name is the path relative to
+  // |dir|, less the suffix. Returns false if |dir| can't be read.
+  bool AddLogsInDirectory(const std::string& dir, const std::string& suffix,
+                          GestureInterpreterDeviceClass cls);
+  // Adds a single log.
+  void AddLog(const std::string& name, const std::string& path,
+              GestureInterpreterDeviceClass cls);
+
+  // Allowed differences between produced and logged gestures. See
+  // ParameterSweep::SetTolerance().
+  void SetTolerance(double time_tolerance, double value_tolerance) {
+    time_tolerance_ = time_tolerance;
+    value_tolerance_ = value_tolerance;
+  }
+
+  // Runs every added log, using up to |max_threads| threads (0 means one per
+  // core), and returns the report. The report doesn't depend on the number
+  // of threads.
+  Json::Value Run(size_t max_threads);
+
+  // Parses a device class name: touchpad, mouse, multitouch_mouse,
+  // pointing_stick or touchscreen. Returns false for anything else.
+  static bool DeviceClassFromName(const std::string& name,
+                                  GestureInterpreterDeviceClass* out);
+
+  // Returns the names of tests that succeed in |reference| but not in
+  // |report|, in name order.
+  static std::vector<std::string> Regressions(const Json::Value& reference,
+                                              const Json::Value& report);
+
+ private:
+  struct Case {
+    std::string name;
+    std::string path;
+    GestureInterpreterDeviceClass cls;
+  };
+
+  // Returns the report entry for one log.
+  Json::Value RunCase(const Case& test_case) const;
+
+  std::vector<Case> cases_;
+  double time_tolerance_;
+  double value_tolerance_;
+};
+
+}  // namespace gestures
+
+#endif  // GESTURES_REGRESSION_RUNNER_H_
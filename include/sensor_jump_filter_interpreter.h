@@ -2,11 +2,12 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include <map>
+#include <stdint.h>
 
 #include <gtest/gtest.h>  // For FRIEND_TEST
 
 #include "include/filter_interpreter.h"
+#include "include/finger_map.h"
 #include "include/finger_metrics.h"
 #include "include/gestures.h"
 #include "include/prop_registry.h"
@@ -23,6 +24,11 @@ namespace gestures {
 
 // When a suspicious jump is detected, the finger is flagged with a warp
 // flag for the axis in which the jump occurred.
+//
+// The last two inputs of each contact are kept in arrays indexed by the
+// contact's FingerSlotTable slot. Each input, the deltas of the contacts are
+// gathered into arrays so that one loop without branches per check tests
+// every contact, and the flags are then applied per finger.
 
 class SensorJumpFilterInterpreter : public FilterInterpreter,
                                     public PropertyDelegate {
@@ -38,17 +44,33 @@ class SensorJumpFilterInterpreter : public FilterInterpreter,
   virtual void SyncInterpretImpl(HardwareState* hwstate, stime_t* timeout);
 
  private:
-  // Fingers from the previous two SyncInterpret calls. previous_input_[0]
-  // is the more recent.
-  std::map<short, FingerState> previous_input_[2];
+  // The checks made on each contact, indexing first_flags_ bits.
+  enum Check {
+    kCheckXNonMove,
+    kCheckYNonMove,
+    kCheckXMove,
+    kCheckYMove,
+    kNumChecks
+  };
+  static const size_t kHistorySize = 2;
+
+  // Returns the row of input_ that is |idx| frames old, 0 being the previous
+  // frame.
+  size_t InputRow(size_t idx) const {
+    return (input_head_ + idx) % kHistorySize;
+  }
+
+  FingerSlotTable finger_slots_;
+  // Slots of the contacts in the previous two SyncInterpret calls.
+  // present_[0] is the more recent.
+  uint64_t present_[kHistorySize];
+  // The previous two input positions, by axis and slot.
+  float input_[2][kHistorySize][kMaxFingerSlots];
+  size_t input_head_;
 
   // When a finger is flagged with a warp flag for the first time, we note it
-  // here.
-  // first_flag_[0] for WARP_X_NON_MOVE;
-  // first_flag_[1] for WARP_Y_NON_MOVE;
-  // first_flag_[2] for WARP_X_MOVE;
-  // first_flag_[3] for WARP_Y_MOVE.
-  std::set<short> first_flag_[4];
+  // here, with bit (1 << Check) of its slot.
+  uint8_t first_flags_[kMaxFingerSlots];
 
   // Whether or not this filter is enabled. If disabled, it behaves as a
   // simple passthrough.
@@ -0,0 +1,78 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "include/filter_interpreter.h"
+#include "include/finger_map.h"
+#include "include/gestures.h"
+#include "include/iir_filter_interpreter.h"
+#include "include/macros.h"
+#include "include/prop_registry.h"
+#include "include/tracer.h"
+
+#ifndef GESTURES_SMOOTHING_FILTER_INTERPRETER_H_
+#define GESTURES_SMOOTHING_FILTER_INTERPRETER_H_
+
+namespace gestures {
+
+// The steps a SmoothingFilterInterpreter can run. Those that stand in for a
+// filter interpreter register the same properties, and give the same output,
+// as it does.
+enum SmoothingStage {
+  // StationaryWiggleFilterInterpreter: sets the warp flags of fingers whose
+  // position carries too little signal energy to be moving.
+  kSmoothingStationaryWiggle,
+  // BoxFilterInterpreter: box hysteresis on the position.
+  kSmoothingBox,
+  // IirFilterInterpreter, on the same IirFilterBank: a biquad on position
+  // and pressure, followed by up to kSmoothingExtraSections more, set with
+  // the "IIR Extra Sections" property, for higher order filters.
+  kSmoothingBiquad,
+  // A 1€ filter on the position: a low-pass filter whose cutoff frequency
+  // rises with the speed of the finger, so slow movement is smoothed and
+  // fast movement isn't delayed. Off by default.
+  kSmoothingOneEuro,
+};
+
+// Biquad sections the kSmoothingBiquad stage runs after the IIR one.
+static const size_t kSmoothingExtraSections =
+    IirFilterBank::kMaxExtraSections;
+
+class SmoothingStageFilter;
+
+// This filter interpreter runs a cascade of smoothing steps on the fingers
+// of each HardwareState, in the order they were given to the constructor.
+// Every step keeps what it knows about a contact in arrays indexed by the
+// contact's FingerSlotTable slot, so the contacts are looked up once per
+// state for all of them, rather than once per step in a map of each.
+//
+// The touchpad chain runs the stationary wiggle, 1€ and box steps ahead of
+// LookaheadFilterInterpreter, and the biquad after it, where the separate
+// interpreters used to be.
+
+class SmoothingFilterInterpreter : public FilterInterpreter {
+ public:
+  // Takes ownership of |next|. A step may appear in |stages| at most once.
+  SmoothingFilterInterpreter(PropRegistry* prop_reg, Interpreter* next,
+                             Tracer* tracer,
+                             const std::vector<SmoothingStage>& stages);
+  virtual ~SmoothingFilterInterpreter();
+
+ protected:
+  virtual void SyncInterpretImpl(HardwareState* hwstate, stime_t* timeout);
+
+ private:
+  FingerSlotTable finger_slots_;
+  std::vector<std::unique_ptr<SmoothingStageFilter>> stages_;
+
+  DISALLOW_COPY_AND_ASSIGN(SmoothingFilterInterpreter);
+};
+
+}  // namespace gestures
+
+#endif  // GESTURES_SMOOTHING_FILTER_INTERPRETER_H_
@@ -59,6 +59,8 @@ class SplitCorrectingFilterInterpreter : public FilterInterpreter {
 
  private:
   void RemoveMissingUnmergedContacts(const HardwareState& hwstate);
+  // Merges fingers new in |hwstate| into unmerged contacts they look split
+  // from, picking the pairs together rather than one contact at a time.
   void MergeFingers(const HardwareState& hwstate);
   void UnmergeFingers(const HardwareState& hwstate);
   void UpdateUnmergedLocations(const HardwareState& hwstate);
@@ -75,10 +77,12 @@ class SplitCorrectingFilterInterpreter : public FilterInterpreter {
   // Tests to see if new_contact, when paired w/ existing_contact
   // are a good match for the unmerged contact, merge_recipient.
   // new_contact is the current state of the finger in merge_recipient.
+  // |sep_sq| is the squared distance between the two contacts.
   // Returns < 0 if this is not a good match, or an error value if it's good.
   // The smaller the error, the better.
   float AreMergePair(const FingerState& existing_contact,
                      const FingerState& new_contact,
+                     float sep_sq,
                      const UnmergedContact& merge_recipient) const;
 
   void AppendMergedContact(const FingerState& input_a,
@@ -2,13 +2,16 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include <map>
+#include <stdint.h>
+
 #include <gtest/gtest.h>  // for FRIEND_TEST
 
 #include "include/filter_interpreter.h"
+#include "include/finger_map.h"
 #include "include/finger_metrics.h"
 #include "include/gestures.h"
 #include "include/macros.h"
+#include "include/prop_registry.h"
 #include "include/tracer.h"
 
 #ifndef GESTURES_STATIONARY_WIGGLE_FILTER_INTERPRETER_H_
@@ -61,7 +64,13 @@ namespace gestures {
 //      se5 = p1^2 + p2^2 ... + p5^2
 //
 
-#define SIGNAL_SAMPLES 5  // number of signal samples
+// Rather than summing up the window for each sample, the history keeps
+// running sums of the position, mixed signal and energy, adding each new
+// sample and taking out the one that falls out of the window, so a sample
+// costs the same whatever the window size.
+
+#define SIGNAL_SAMPLES 5  // default number of signal samples
+#define MAX_SIGNAL_SAMPLES 32  // most signal samples a window can hold
 
 struct FingerEnergy {
   float x;  // original position_x
@@ -84,12 +93,9 @@ struct FingerEnergy {
 
 class FingerEnergyHistory {
  public:
-  FingerEnergyHistory()
-      : size_(0),
-        head_(0),
-        moving_(false),
-        idle_time_(0.1),
-        prev_(0) {}
+  // |window| is the number of samples, up to MAX_SIGNAL_SAMPLES, that the
+  // averages and signal energy are taken over.
+  explicit FingerEnergyHistory(size_t window = SIGNAL_SAMPLES);
 
   // Push the current finger data into the history buffer
   void PushFingerState(const FingerState &fs, const stime_t timestamp);
@@ -113,17 +119,53 @@ class FingerEnergyHistory {
   bool operator!=(const FingerEnergyHistory& that) const;
 
  private:
-  FingerEnergy history_[SIGNAL_SAMPLES];  // the finger energy buffer
-  size_t max_size_ = arraysize(history_);
+  FingerEnergy history_[MAX_SIGNAL_SAMPLES];  // the finger energy buffer
+  size_t max_size_;
   size_t size_;
   size_t head_;
   bool moving_;
   stime_t idle_time_;  // timeout for finger without state change
   stime_t prev_;
+
+  // Sums of the fields of the samples in the buffer.
+  double sum_x_;
+  double sum_y_;
+  double sum_mixed_x_;
+  double sum_mixed_y_;
+  double sum_energy_x_;
+  double sum_energy_y_;
+};
+
+// Keeps the energy history of each contact in the slot FingerSlotTable
+// gives it, and flags the fingers of each HardwareState as stationary or
+// moving. Shared by StationaryWiggleFilterInterpreter and the stationary
+// wiggle step of SmoothingFilterInterpreter.
+class StationaryWiggleDetector {
+ public:
+  StationaryWiggleDetector() : tracked_(0) {}
+
+  // Forgets the contacts not in |present|, a bitmask of slots. Their slots
+  // may be given to new contacts.
+  void RemoveMissing(uint64_t present) { tracked_ &= present; }
+
+  // Pushes the first |finger_cnt| fingers of |hwstate| into their
+  // histories, slots[i] being the slot of finger i, or -1 if it has none.
+  // Fingers with enough history are flagged as warps if their signal
+  // energy is at most |threshold|, or |hysteresis| if they were moving,
+  // and as moving otherwise. Contacts new to the detector get a history of
+  // |window| samples.
+  void Update(const int* slots, size_t finger_cnt, float threshold,
+              float hysteresis, size_t window, HardwareState* hwstate);
+
+ private:
+  FingerEnergyHistory histories_[kMaxFingerSlots];
+  // Slots with a history.
+  uint64_t tracked_;
 };
 
 class StationaryWiggleFilterInterpreter : public FilterInterpreter {
   FRIEND_TEST(StationaryWiggleFilterInterpreterTest, SimpleTest);
+  FRIEND_TEST(StationaryWiggleFilterInterpreterTest, WindowTest);
 
  public:
   // Takes ownership of |next|:
@@ -136,13 +178,8 @@ class StationaryWiggleFilterInterpreter : public FilterInterpreter {
   virtual void SyncInterpretImpl(HardwareState* hwstate, stime_t* timeout);
 
  private:
-  // Calculate signal energy from input data and update finger flag if
-  // a finger is stationary
-  void UpdateStationaryFlags(HardwareState* hwstate);
-
-  // Map of finger energy histories
-  typedef std::map<short, FingerEnergyHistory> FingerEnergyHistoryMap;
-  FingerEnergyHistoryMap histories_;
+  FingerSlotTable finger_slots_;
+  StationaryWiggleDetector detector_;
 
   // True if this interpreter is effective
   BoolProperty enabled_;
@@ -151,6 +188,10 @@ class StationaryWiggleFilterInterpreter : public FilterInterpreter {
   DoubleProperty threshold_;
   DoubleProperty hysteresis_;
 
+  // Number of samples the signal energy is taken over. A change applies to
+  // contacts that arrive after it.
+  IntProperty window_;
+
   DISALLOW_COPY_AND_ASSIGN(StationaryWiggleFilterInterpreter);
 };
 
@@ -0,0 +1,123 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GESTURES_TOUCH_STREAM_GENERATOR_H_
+#define GESTURES_TOUCH_STREAM_GENERATOR_H_
+
+#include <stdint.h>
+
+#include <random>
+#include <vector>
+
+#include "include/finger_metrics.h"
+#include "include/gestures.h"
+
+// TouchStreamGenerator synthesizes touchpad input for load and stress tests:
+// a sequence of scripted segments (moves, multi-finger scrolls, pinches,
+// palms, drumrolls) sampled at a fixed rate, with optional position noise
+// and irregular delivery times. DriveGestureInterpreter() feeds such a
+// stream to a GestureInterpreter and measures how long each frame takes.
+
+namespace gestures {
+
+enum TouchSegmentKind {
+  kTouchSegmentMove,  // One finger moving right
+  kTouchSegmentScroll,  // Fingers side by side moving down together
+  kTouchSegmentPinch,  // Two fingers moving apart
+  kTouchSegmentPalm,  // A resting palm at the bottom edge, plus moving fingers
+  kTouchSegmentDrumroll,  // Fingers taking turns tapping, each tap a new id
+};
+
+struct TouchStreamConfig {
+  // Frames per second of the device clock (msc_timestamp).
+  double rate = 240.0;
+  // Standard deviation of the noise added to contact positions, in mm.
+  double position_noise = 0.0;
+  // Delivery time (timestamp) is msc_timestamp plus this latency, plus up
+  // to |delivery_jitter| seconds of uniform jitter.
+  double delivery_latency = 0.002;
+  double delivery_jitter = 0.0;
+  // Chance that a frame is held back and delivered together with the next
+  // one, like a batched USB or I2C read.
+  double burst_probability = 0.0;
+  uint32_t seed = 1;
+};
+
+class TouchStreamGenerator {
+ public:
+  TouchStreamGenerator(const HardwareProperties& hwprops,
+                       const TouchStreamConfig& config);
+
+  // Appends a segment that lasts |duration| seconds with up to |fingers|
+  // contacts. Each segment is followed by a short gap with no contacts.
+  void AddSegment(TouchSegmentKind kind, size_t fingers, double duration);
+
+  // Returns the next frame, or NULL when all segments are done. The state
+  // and its fingers are valid until the next call, and may be modified.
+  HardwareState* Next();
+
+  const HardwareProperties& hwprops() const { return hwprops_; }
+  double rate() const { return config_.rate; }
+
+ private:
+  struct Segment {
+    TouchSegmentKind kind;
+    size_t fingers;
+    double duration;
+  };
+
+  // Gives every slot a new tracking id.
+  void StartSegment();
+  // Fills fingers_ for |segment| at |elapsed| seconds into it.
+  void FillFingers(const Segment& segment, double elapsed);
+  // Adds a contact at (x, y) mm from the pad center, for slot |slot|.
+  void AddFinger(size_t slot, double x, double y, float size, float pressure);
+
+  HardwareProperties hwprops_;
+  TouchStreamConfig config_;
+  std::vector<Segment> segments_;
+  std::mt19937 rng_;
+
+  size_t segment_;
+  double segment_start_;
+  uint64_t frame_;
+  stime_t last_timestamp_;
+
+  // Tracking id of each slot, and the tap that id belongs to in drumrolls.
+  short slot_ids_[kMaxFingers];
+  int64_t slot_taps_[kMaxFingers];
+  short next_id_;
+
+  HardwareState hwstate_;
+  FingerState fingers_[kMaxFingers];
+};
+
+struct TouchLoadReport {
+  size_t frames = 0;
+  size_t timer_callbacks = 0;
+  size_t gestures = 0;
+  // Wall time spent in the interpreter, in seconds.
+  double busy_seconds = 0.0;
+  // Frames per second of busy time.
+  double throughput = 0.0;
+  // Percentiles of the time PushHardwareState() took, in microseconds.
+  double p50_us = 0.0;
+  double p90_us = 0.0;
+  double p99_us = 0.0;
+  double max_us = 0.0;
+  // Frames that took longer than one frame period at the stream's rate.
+  size_t missed_deadlines = 0;
+};
+
+// Sets |gi|'s hardware properties to the generator's, then pushes every
+// frame of |generator| into it. Timers requested by the interpreter fire on
+// the stream's clock, right before the first frame delivered after their
+// deadline. |gi| must be initialized, and must not have a timer provider or
+// callback of its own.
+TouchLoadReport DriveGestureInterpreter(GestureInterpreter* gi,
+                                        TouchStreamGenerator* generator);
+
+}  // namespace gestures
+
+#endif  // GESTURES_TOUCH_STREAM_GENERATOR_H_
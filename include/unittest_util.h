@@ -5,6 +5,8 @@
 #ifndef GESTURES_UNITTEST_UTIL_H_
 #define GESTURES_UNITTEST_UTIL_H_
 
+#include <string>
+
 #include "include/finger_metrics.h"
 #include "include/gestures.h"
 #include "include/interpreter.h"
@@ -43,6 +45,10 @@ HardwareState make_hwstate(stime_t timestamp, int buttons_down,
                            unsigned short finger_cnt, unsigned short touch_cnt,
                            struct FingerState* fingers);
 
+// Returns the activity log of a mouse chain that was sent |frames| moves to
+// the right.
+std::string RecordMouseActivityLog(size_t frames);
+
 }  // namespace gestures
 
 #endif  // GESTURES_UNITTEST_UTIL_H_
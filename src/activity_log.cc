@@ -555,5 +555,16 @@ const char ActivityLog::kKeyHardwarePropHasWheel[] = "hasWheel";
 
 const char ActivityLog::kKeyProperties[] = "properties";
 
+const char ActivityLog::kKeyStageStats[] = "stageStats";
+const char ActivityLog::kKeyStageStatsSyncCalls[] = "syncCalls";
+const char ActivityLog::kKeyStageStatsSyncNs[] = "syncNs";
+const char ActivityLog::kKeyStageStatsSyncMaxNs[] = "syncMaxNs";
+const char ActivityLog::kKeyStageStatsTimerCalls[] = "timerCalls";
+const char ActivityLog::kKeyStageStatsTimerNs[] = "timerNs";
+const char ActivityLog::kKeyStageStatsTimerMaxNs[] = "timerMaxNs";
+const char ActivityLog::kKeyStageStatsTimerRequests[] = "timerRequests";
+const char ActivityLog::kKeyStageStatsGesturesConsumed[] = "gesturesConsumed";
+const char ActivityLog::kKeyStageStatsGesturesProduced[] = "gesturesProduced";
+
 
 }  // namespace gestures
@@ -23,6 +23,18 @@ using std::string;
 
 namespace gestures {
 
+namespace {
+
+// TODO(clchiou): This is just a emporary workaround for property changes.
+// I will work out a solution for this kind of changes.
+bool IsIgnoredProperty(const char* name) {
+  return !strcmp(name, "Compute Surface Area from Pressure") ||
+      !strcmp(name, "Touchpad Device Output Bias on X-Axis") ||
+      !strcmp(name, "Touchpad Device Output Bias on Y-Axis");
+}
+
+}  // namespace {}
+
 ActivityReplay::ActivityReplay(PropRegistry* prop_reg)
     : log_(NULL), prop_reg_(prop_reg) {}
 
@@ -35,6 +47,7 @@ bool ActivityReplay::Parse(const string& data,
                            const std::set<string>& honor_props) {
   log_.Clear();
   names_.clear();
+  properties_ = Json::Value(Json::objectValue);
 
   string error_msg;
   Json::Value root;
@@ -62,6 +75,14 @@ bool ActivityReplay::Parse(const string& data,
     Err("Unable to parse properties.");
     return false;
   }
+  if (props_dict.isObject()) {
+    properties_ = props_dict;
+    for (const string& name : props_dict.getMemberNames()) {
+      if (IsIgnoredProperty(name.c_str()) ||
+          (!honor_props.empty() && !SetContainsValue(honor_props, name)))
+        properties_.removeMember(name);
+    }
+  }
   // Get and apply hardware properties
   if (!root.isMember(ActivityLog::kKeyHardwarePropRoot)) {
     Err("Unable to get hwprops dict.");
@@ -102,18 +123,13 @@ bool ActivityReplay::ParseProperties(const Json::Value& dict,
                                      const std::set<string>& honor_props) {
   if (!prop_reg_)
     return true;
-  ::set<Property*> props = prop_reg_->props();
+  const ::set<Property*>& props = prop_reg_->props();
   for (::set<Property*>::const_iterator it = props.begin(), e = props.end();
        it != e; ++it) {
     const char* key = (*it)->name();
 
-    // TODO(clchiou): This is just a emporary workaround for property changes.
-    // I will work out a solution for this kind of changes.
-    if (!strcmp(key, "Compute Surface Area from Pressure") ||
-        !strcmp(key, "Touchpad Device Output Bias on X-Axis") ||
-        !strcmp(key, "Touchpad Device Output Bias on Y-Axis")) {
+    if (IsIgnoredProperty(key))
       continue;
-    }
 
     if (!honor_props.empty() && !SetContainsValue(honor_props, string(key)))
       continue;
@@ -142,7 +158,9 @@ bool ActivityReplay::ParseProperties(const Json::Value& dict,
 
 bool ActivityReplay::ParseHardwareProperties(const Json::Value& obj,
                                              HardwareProperties* out_props) {
-  HardwareProperties props;
+  // Logs don't record every field (e.g. is_haptic_pad), so zero the rest
+  // rather than replaying on whatever was on the stack.
+  HardwareProperties props = {};
   PARSE_HP(obj, ActivityLog::kKeyHardwarePropLeft, isDouble, asDouble,
            props.left, float, true);
   PARSE_HP(obj, ActivityLog::kKeyHardwarePropTop, isDouble, asDouble,
@@ -248,7 +266,7 @@ bool ActivityReplay::ParseHardwareState(const Json::Value& entry) {
       Err("Unable to parse hardware state rel_y");
       return false;
     }
-    hs.rel_x = entry[ActivityLog::kKeyHardwareStateRelY].asDouble();
+    hs.rel_y = entry[ActivityLog::kKeyHardwareStateRelY].asDouble();
     if (!entry.isMember(ActivityLog::kKeyHardwareStateRelWheel)) {
       Err("Unable to parse hardware state rel_wheel");
       return false;
@@ -721,19 +739,18 @@ bool ActivityReplay::ReplayPropChange(
     Err("Missing prop registry.");
     return false;
   }
-  ::set<Property*> props = prop_reg_->props();
-  Property* prop = NULL;
-  for (::set<Property*>::iterator it = props.begin(), e = props.end(); it != e;
-       ++it) {
-    prop = *it;
-    if (strcmp(prop->name(), entry.name) == 0)
-      break;
-    prop = NULL;
-  }
+  Property* prop = prop_reg_->FindProperty(entry.name);
   if (!prop) {
     Err("Unable to find prop %s to set.", entry.name);
     return false;
   }
+  prop->SetValue(PropChangeValue(entry));
+  prop->HandleGesturesPropWritten();
+  return true;
+}
+
+Json::Value ActivityReplay::PropChangeValue(
+    const ActivityLog::PropChangeEntry& entry) {
   Json::Value value;
   switch (entry.type) {
     case ActivityLog::PropChangeEntry::kBoolProp:
@@ -749,9 +766,7 @@ bool ActivityReplay::ReplayPropChange(
       value = Json::Value(entry.value.short_val);
       break;
   }
-  prop->SetValue(value);
-  prop->HandleGesturesPropWritten();
-  return true;
+  return value;
 }
 
 }  // namespace gestures
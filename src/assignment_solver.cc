@@ -0,0 +1,102 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "include/assignment_solver.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace gestures {
+
+size_t SolveAssignment(const float cost[][kMaxAssignmentSize],
+                       size_t rows, size_t cols, int* row_to_col) {
+  rows = std::min(rows, kMaxAssignmentSize);
+  cols = std::min(cols, kMaxAssignmentSize);
+  std::fill(row_to_col, row_to_col + rows, -1);
+
+  // Leaving a row or column out costs more than all the pairs that can be
+  // made put together, so the fewest are left out. The matrix is padded to
+  // a square with that cost, too.
+  double leave_out = 1.0;
+  size_t can_pair = 0;
+  for (size_t i = 0; i < rows; i++)
+    for (size_t j = 0; j < cols; j++)
+      if (cost[i][j] < INFINITY) {
+        leave_out += fabs(cost[i][j]);
+        can_pair++;
+      }
+  if (!can_pair)
+    return 0;
+  const size_t n = std::max(rows, cols);
+  double a[kMaxAssignmentSize][kMaxAssignmentSize];
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = 0; j < n; j++)
+      a[i][j] = i < rows && j < cols && cost[i][j] < INFINITY ?
+          cost[i][j] : leave_out;
+
+  // Row and column potentials, which never exceed the cost of any entry
+  // when added; the entries where they match make up the pairing. Rows are
+  // added one at a time, each along the cheapest path of alternating
+  // unpaired and paired entries to a free column. Column 0 stands for the
+  // row being added, so rows and columns here are numbered from 1.
+  double row_pot[kMaxAssignmentSize + 1] = { 0.0 };
+  double col_pot[kMaxAssignmentSize + 1] = { 0.0 };
+  size_t col_row[kMaxAssignmentSize + 1] = { 0 };  // 0 if free
+  size_t prev_col[kMaxAssignmentSize + 1] = { 0 };
+  for (size_t row = 1; row <= n; row++) {
+    double min_slack[kMaxAssignmentSize + 1];
+    bool visited[kMaxAssignmentSize + 1];
+    std::fill(min_slack, min_slack + n + 1, INFINITY);
+    std::fill(visited, visited + n + 1, false);
+    col_row[0] = row;
+    size_t col = 0;
+    do {
+      visited[col] = true;
+      size_t from = col_row[col];
+      double delta = INFINITY;
+      size_t next = 0;
+      for (size_t j = 1; j <= n; j++) {
+        if (visited[j])
+          continue;
+        double slack = a[from - 1][j - 1] - row_pot[from] - col_pot[j];
+        if (slack < min_slack[j]) {
+          min_slack[j] = slack;
+          prev_col[j] = col;
+        }
+        if (min_slack[j] < delta) {
+          delta = min_slack[j];
+          next = j;
+        }
+      }
+      for (size_t j = 0; j <= n; j++) {
+        if (visited[j]) {
+          row_pot[col_row[j]] += delta;
+          col_pot[j] -= delta;
+        } else {
+          min_slack[j] -= delta;
+        }
+      }
+      col = next;
+    } while (col_row[col]);
+    // Flip the path.
+    do {
+      size_t prev = prev_col[col];
+      col_row[col] = col_row[prev];
+      col = prev;
+    } while (col);
+  }
+
+  size_t pairs = 0;
+  for (size_t j = 1; j <= cols; j++) {
+    size_t i = col_row[j] - 1;
+    if (i < rows && cost[i][j - 1] < INFINITY) {
+      row_to_col[i] = j - 1;
+      pairs++;
+    }
+  }
+  return pairs;
+}
+
+}  // namespace gestures
@@ -0,0 +1,133 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <math.h>
+
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "include/assignment_solver.h"
+
+namespace gestures {
+
+class AssignmentSolverTest : public ::testing::Test {};
+
+namespace {
+
+typedef float CostMatrix[kMaxAssignmentSize][kMaxAssignmentSize];
+
+// Tries every way to pair rows |row| on, and keeps the one with the most
+// pairs, then the least cost, in |best_pairs| and |best_cost|.
+void BruteForce(const CostMatrix& cost, size_t rows, size_t cols,
+                size_t row, bool* col_used, size_t pairs, double total,
+                size_t* best_pairs, double* best_cost) {
+  if (row == rows) {
+    if (pairs > *best_pairs || (pairs == *best_pairs && total < *best_cost)) {
+      *best_pairs = pairs;
+      *best_cost = total;
+    }
+    return;
+  }
+  BruteForce(cost, rows, cols, row + 1, col_used, pairs, total, best_pairs,
+             best_cost);
+  for (size_t j = 0; j < cols; j++) {
+    if (col_used[j] || !(cost[row][j] < INFINITY))
+      continue;
+    col_used[j] = true;
+    BruteForce(cost, rows, cols, row + 1, col_used, pairs + 1,
+               total + cost[row][j], best_pairs, best_cost);
+    col_used[j] = false;
+  }
+}
+
+}  // namespace {}
+
+TEST(AssignmentSolverTest, SimpleTest) {
+  // Greedily pairing row 0 with its cheapest column leaves row 1 out.
+  CostMatrix cost = {
+    { 1.0, 2.0 },
+    { 0.5, INFINITY },
+  };
+  int row_to_col[kMaxAssignmentSize];
+  EXPECT_EQ(2, SolveAssignment(cost, 2, 2, row_to_col));
+  EXPECT_EQ(1, row_to_col[0]);
+  EXPECT_EQ(0, row_to_col[1]);
+
+  // More rows than columns, and a NaN.
+  CostMatrix tall = {
+    { 3.0 },
+    { NAN },
+    { 2.0 },
+  };
+  EXPECT_EQ(1, SolveAssignment(tall, 3, 1, row_to_col));
+  EXPECT_EQ(-1, row_to_col[0]);
+  EXPECT_EQ(-1, row_to_col[1]);
+  EXPECT_EQ(0, row_to_col[2]);
+
+  // Nothing can be paired.
+  CostMatrix none = {
+    { INFINITY, INFINITY },
+  };
+  EXPECT_EQ(0, SolveAssignment(none, 1, 2, row_to_col));
+  EXPECT_EQ(-1, row_to_col[0]);
+  EXPECT_EQ(0, SolveAssignment(none, 0, 2, row_to_col));
+}
+
+TEST(AssignmentSolverTest, BruteForceTest) {
+  std::mt19937 gen(2026);
+  std::uniform_real_distribution<float> unit(0.0, 1.0);
+  for (size_t trial = 0; trial < 3000; trial++) {
+    size_t rows = 1 + gen() % 7;
+    size_t cols = 1 + gen() % 7;
+    float blocked = unit(gen);
+    CostMatrix cost;
+    for (size_t i = 0; i < rows; i++)
+      for (size_t j = 0; j < cols; j++)
+        cost[i][j] = unit(gen) < blocked ? INFINITY :
+            floorf(100.0 * unit(gen)) * 0.25;
+
+    size_t best_pairs = 0;
+    double best_cost = INFINITY;
+    bool col_used[kMaxAssignmentSize] = { false };
+    BruteForce(cost, rows, cols, 0, col_used, 0, 0.0, &best_pairs,
+               &best_cost);
+
+    int row_to_col[kMaxAssignmentSize];
+    size_t pairs = SolveAssignment(cost, rows, cols, row_to_col);
+    ASSERT_EQ(best_pairs, pairs) << trial;
+    double total = 0.0;
+    size_t counted = 0;
+    bool seen[kMaxAssignmentSize] = { false };
+    for (size_t i = 0; i < rows; i++) {
+      if (row_to_col[i] < 0)
+        continue;
+      ASSERT_LT(row_to_col[i], cols);
+      ASSERT_FALSE(seen[row_to_col[i]]);
+      seen[row_to_col[i]] = true;
+      ASSERT_LT(cost[i][row_to_col[i]], INFINITY);
+      total += cost[i][row_to_col[i]];
+      counted++;
+    }
+    EXPECT_EQ(pairs, counted) << trial;
+    if (pairs)
+      EXPECT_DOUBLE_EQ(best_cost, total) << trial;
+  }
+}
+
+TEST(AssignmentSolverTest, FullSizeTest) {
+  // A full matrix where the cheapest pairing is the anti-diagonal.
+  CostMatrix cost;
+  for (size_t i = 0; i < kMaxAssignmentSize; i++)
+    for (size_t j = 0; j < kMaxAssignmentSize; j++)
+      cost[i][j] = i + j == kMaxAssignmentSize - 1 ? 0.0 : 1.0 + i * j;
+  int row_to_col[kMaxAssignmentSize];
+  EXPECT_EQ(kMaxAssignmentSize,
+            SolveAssignment(cost, kMaxAssignmentSize, kMaxAssignmentSize,
+                            row_to_col));
+  for (size_t i = 0; i < kMaxAssignmentSize; i++)
+    EXPECT_EQ(kMaxAssignmentSize - 1 - i, row_to_col[i]);
+}
+
+}  // namespace gestures
@@ -0,0 +1,290 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Timing harness for hot paths that the unittests deliberately don't time.
+// Build with "make benchmark" and run "./benchmark [name-substring]"; each
+// benchmark prints its own results. Numbers are only comparable between
+// runs on the same machine, so compare a change against its parent commit.
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include "include/gestures.h"
+#include "include/immediate_interpreter.h"
+#include "include/macros.h"
+#include "include/palm_classifying_filter_interpreter.h"
+#include "include/split_correcting_filter_interpreter.h"
+#include "include/unittest_util.h"
+
+namespace gestures {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double NsPerIteration(Clock::duration elapsed, size_t iterations) {
+  return std::chrono::duration<double, std::nano>(elapsed).count() /
+      iterations;
+}
+
+HardwareProperties TenFingerTouchpadProps() {
+  HardwareProperties hwprops = {
+    0,  // left edge
+    0,  // top edge
+    100,  // right edge
+    60,  // bottom edge
+    1,  // x pixels/TP width
+    1,  // y pixels/TP height
+    25.4,  // x screen DPI
+    25.4,  // y screen DPI
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    kMaxFingers,  // max fingers
+    kMaxFingers,  // max touch
+    0,  // t5r2
+    0,  // semi-mt
+    1,  // is button pad
+    0,  // has_wheel
+    0,  // wheel_is_hi_res
+    0,  // is haptic pad
+  };
+  return hwprops;
+}
+
+// Palm resting on the pad plus nine fingers typing: the frames where the
+// all-pairs finger distance passes cost the most.
+class TenFingerFrames {
+ public:
+  static const size_t kFrames = 1000;
+
+  TenFingerFrames() {
+    for (size_t f = 0; f < kFrames; f++) {
+      for (size_t i = 0; i < kMaxFingers; i++) {
+        FingerState* fs = &fingers_[f][i];
+        memset(fs, 0, sizeof(*fs));
+        bool palm = i == 0;
+        fs->touch_major = palm ? 40 : 8;
+        fs->touch_minor = palm ? 30 : 6;
+        fs->pressure = palm ? 200 : 40;
+        fs->position_x = palm ? 50 : 8 + 10.0 * (i - 1) + (f + i) % 3;
+        fs->position_y = palm ? 50 : 10 + 5.0 * (i % 3) + (f + 2 * i) % 2;
+        fs->tracking_id = i + 1;
+      }
+    }
+  }
+
+  // Fills |hwstate| with frame |f|, taken 80 Hz apart.
+  void Frame(size_t f, HardwareState* hwstate) {
+    size_t frame = f % kFrames;
+    memcpy(copy_, fingers_[frame], sizeof(copy_));
+    *hwstate = make_hwstate(0.0125 * f, 0, kMaxFingers, kMaxFingers, copy_);
+  }
+
+ private:
+  FingerState fingers_[kFrames][kMaxFingers];
+  FingerState copy_[kMaxFingers];
+};
+
+// Runs |frames| through |interpreter| and returns ns per frame.
+double TimeStage(Interpreter* interpreter, size_t frames) {
+  HardwareProperties hwprops = TenFingerTouchpadProps();
+  TestInterpreterWrapper wrapper(interpreter, &hwprops);
+  TenFingerFrames input;
+  HardwareState hwstate;
+  auto start = Clock::now();
+  for (size_t f = 0; f < frames; f++) {
+    input.Frame(f, &hwstate);
+    stime_t timeout = NO_DEADLINE;
+    wrapper.SyncInterpret(&hwstate, &timeout);
+  }
+  return NsPerIteration(Clock::now() - start, frames);
+}
+
+// The three stages that look at all finger pairs each frame, each in front
+// of the ImmediateInterpreter they sit on in the touchpad chain, and the
+// whole touchpad chain.
+void TenFingerFramesBenchmark() {
+  const size_t kFrames = 200000;
+  {
+    ImmediateInterpreter ii(NULL, NULL);
+    printf("  ImmediateInterpreter: %.0f ns/frame\n", TimeStage(&ii, kFrames));
+  }
+  {
+    PalmClassifyingFilterInterpreter pci(
+        NULL, new ImmediateInterpreter(NULL, NULL), NULL);
+    printf("  PalmClassifying + Immediate: %.0f ns/frame\n",
+           TimeStage(&pci, kFrames));
+  }
+  {
+    SplitCorrectingFilterInterpreter sci(
+        NULL, new ImmediateInterpreter(NULL, NULL), NULL);
+    sci.Enable();
+    printf("  SplitCorrecting + Immediate: %.0f ns/frame\n",
+           TimeStage(&sci, kFrames));
+  }
+  {
+    GestureInterpreter gi(GESTURES_VERSION);
+    gi.Initialize(GESTURES_DEVCLASS_TOUCHPAD);
+    gi.SetHardwareProperties(TenFingerTouchpadProps());
+    TenFingerFrames input;
+    HardwareState hwstate;
+    auto start = Clock::now();
+    for (size_t f = 0; f < kFrames; f++) {
+      input.Frame(f, &hwstate);
+      gi.PushHardwareState(&hwstate);
+    }
+    printf("  touchpad chain: %.0f ns/frame\n",
+           NsPerIteration(Clock::now() - start, kFrames));
+  }
+}
+
+// A prop provider that only counts the properties created with it.
+size_t startup_prop_count = 0;
+char startup_prop;
+
+GesturesProp* StartupCreateProp() {
+  startup_prop_count++;
+  return reinterpret_cast<GesturesProp*>(&startup_prop);
+}
+GesturesProp* StartupCreateInt(void*, const char*, int*, size_t,
+                               const int*) {
+  return StartupCreateProp();
+}
+GesturesProp* StartupCreateBool(void*, const char*, GesturesPropBool*, size_t,
+                                const GesturesPropBool*) {
+  return StartupCreateProp();
+}
+GesturesProp* StartupCreateString(void*, const char*, const char**,
+                                  const char* const) {
+  return StartupCreateProp();
+}
+GesturesProp* StartupCreateReal(void*, const char*, double*, size_t,
+                                const double*) {
+  return StartupCreateProp();
+}
+void StartupRegisterHandlers(void*, GesturesProp*, void*,
+                             GesturesPropGetHandler, GesturesPropSetHandler) {}
+void StartupFree(void*, GesturesProp*) {}
+
+size_t startup_props_at_gesture = 0;
+
+void StartupGestureReady(void* data, const Gesture* gesture) {
+  bool* got_gesture = reinterpret_cast<bool*>(data);
+  if (!*got_gesture)
+    startup_props_at_gesture = startup_prop_count;
+  *got_gesture = true;
+}
+
+// The time from NewGestureInterpreter() to the first gesture for each
+// device class, with eager and deferred property creation.
+void StartupBenchmark() {
+  GesturesPropProvider provider = {
+    StartupCreateInt,
+    NULL,
+    StartupCreateBool,
+    StartupCreateString,
+    StartupCreateReal,
+    StartupRegisterHandlers,
+    StartupFree
+  };
+  HardwareProperties hwprops = {
+    0,  // left edge
+    0,  // top edge
+    1000,  // right edge
+    1000,  // bottom edge
+    10,  // pixels/TP width
+    10,  // pixels/TP height
+    96,  // screen DPI x
+    96,  // screen DPI y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5,  // max fingers
+    5,  // max touch
+    0,  // tripletap
+    0,  // semi-mt
+    1,  // is button pad
+    1,  // has_wheel
+    0,  // wheel_is_hi_res
+    0,  // is haptic pad
+  };
+  const struct {
+    GestureInterpreterDeviceClass cls;
+    const char* name;
+  } kClasses[] = {
+    { GESTURES_DEVCLASS_TOUCHPAD, "touchpad" },
+    { GESTURES_DEVCLASS_MOUSE, "mouse" },
+    { GESTURES_DEVCLASS_MULTITOUCH_MOUSE, "multitouch mouse" },
+    { GESTURES_DEVCLASS_POINTING_STICK, "pointing stick" },
+  };
+  const size_t kRuns = 200;
+  const size_t kMaxFrames = 100;
+
+  for (size_t i = 0; i < arraysize(kClasses); i++) {
+    for (int defer = 0; defer < 2; defer++) {
+      size_t frames = 0;
+      auto start = Clock::now();
+      for (size_t run = 0; run < kRuns; run++) {
+        bool got_gesture = false;
+        startup_prop_count = 0;
+        GestureInterpreter* gi = NewGestureInterpreter();
+        gi->SetPropProvider(&provider, NULL);
+        gi->SetDeferPropCreation(defer);
+        gi->SetCallback(StartupGestureReady, &got_gesture);
+        gi->Initialize(kClasses[i].cls);
+        gi->SetHardwareProperties(hwprops);
+        for (size_t f = 0; f < kMaxFrames && !got_gesture; f++) {
+          FingerState fs = {
+            0, 0, 0, 0, 50, 0, 100.0f + 10 * f, 100, 1, 0
+          };
+          bool has_finger = kClasses[i].cls == GESTURES_DEVCLASS_TOUCHPAD ||
+              kClasses[i].cls == GESTURES_DEVCLASS_MULTITOUCH_MOUSE;
+          HardwareState hs = make_hwstate(0.01 * (f + 1), 0, has_finger,
+                                          has_finger, &fs);
+          hs.rel_x = 5;
+          gi->PushHardwareState(&hs);
+          frames++;
+        }
+        DeleteGestureInterpreter(gi);
+      }
+      printf("  %s, %s: %.1f us to first gesture, %.1f frames, "
+             "%zu props created before it\n",
+             kClasses[i].name, defer ? "deferred" : "eager",
+             NsPerIteration(Clock::now() - start, kRuns) / 1000.0,
+             static_cast<double>(frames) / kRuns, startup_props_at_gesture);
+    }
+  }
+}
+
+struct Benchmark {
+  const char* name;
+  void (*run)();
+};
+
+const Benchmark kBenchmarks[] = {
+  { "TenFingerFrames", TenFingerFramesBenchmark },
+  { "Startup", StartupBenchmark },
+};
+
+}  // namespace {}
+
+}  // namespace gestures
+
+int main(int argc, char** argv) {
+  const char* filter = argc > 1 ? argv[1] : "";
+  for (const gestures::Benchmark& benchmark : gestures::kBenchmarks) {
+    if (!strstr(benchmark.name, filter))
+      continue;
+    printf("%s\n", benchmark.name);
+    benchmark.run();
+  }
+  return 0;
+}
+
+extern "C" {
+
+// Drop library logging so it doesn't end up in the timings.
+void gestures_log(int verb, const char* fmt, ...) {}
+
+}
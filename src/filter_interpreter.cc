@@ -30,6 +30,17 @@ void FilterInterpreter::ConsumeGesture(const Gesture& gesture) {
   ProduceGesture(gesture);
 }
 
+void FilterInterpreter::CollectStageStats(
+    std::vector<GestureStageStats>* out) const {
+  Interpreter::CollectStageStats(out);
+  size_t idx = out->size() - 1;
+  if (!next_)
+    return;
+  next_->CollectStageStats(out);
+  // Everything next_ produces goes to this interpreter.
+  (*out)[idx].gestures_consumed = (*out)[idx + 1].gestures_produced;
+}
+
 Json::Value FilterInterpreter::EncodeCommonInfo() {
   Json::Value root = Interpreter::EncodeCommonInfo();
 #ifdef DEEP_LOGS
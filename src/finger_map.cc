@@ -0,0 +1,141 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "include/finger_map.h"
+
+#include <string.h>
+
+#include "include/logging.h"
+
+namespace gestures {
+
+namespace {
+
+uint64_t SlotBit(size_t slot) {
+  return static_cast<uint64_t>(1) << slot;
+}
+
+}  // namespace {}
+
+void FingerSlotTable::Clear() {
+  memset(ids_, 0, sizeof(ids_));
+  memset(released_at_, 0, sizeof(released_at_));
+  release_count_ = 0;
+  assigned_ = 0;
+  live_ = 0;
+  num_assigned_ = 0;
+}
+
+size_t FingerSlotTable::LowerBound(short id) const {
+  size_t lo = 0;
+  size_t hi = num_assigned_;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (ids_[order_[mid]] < id)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+int FingerSlotTable::SlotForId(short id) const {
+  size_t rank = LowerBound(id);
+  if (rank < num_assigned_ && ids_[order_[rank]] == id)
+    return order_[rank];
+  return -1;
+}
+
+int FingerSlotTable::AssignSlot(short id, uint64_t reserved) {
+  uint64_t free_slots = ~(live_ | reserved);
+  if (!free_slots) {
+    Err("No free finger slot for id %d", id);
+    return -1;
+  }
+  // Prefer a slot that never held an id. Otherwise take the one whose id
+  // left the longest time ago.
+  size_t slot;
+  if (free_slots & ~assigned_) {
+    slot = __builtin_ctzll(free_slots & ~assigned_);
+  } else {
+    slot = __builtin_ctzll(free_slots);
+    for (uint64_t rest = free_slots & (free_slots - 1); rest;
+         rest &= rest - 1) {
+      size_t candidate = __builtin_ctzll(rest);
+      if (released_at_[candidate] < released_at_[slot])
+        slot = candidate;
+    }
+    // Drop the old id from order_.
+    size_t rank = LowerBound(ids_[slot]);
+    while (order_[rank] != slot)
+      rank++;
+    memmove(&order_[rank], &order_[rank + 1], num_assigned_ - rank - 1);
+    num_assigned_--;
+  }
+  ids_[slot] = id;
+  assigned_ |= SlotBit(slot);
+  size_t rank = LowerBound(id);
+  memmove(&order_[rank + 1], &order_[rank], num_assigned_ - rank);
+  order_[rank] = slot;
+  num_assigned_++;
+  return slot;
+}
+
+void FingerSlotTable::Update(const HardwareState& hwstate) {
+  uint64_t present = 0;
+  for (size_t i = 0; i < hwstate.finger_cnt; i++) {
+    short id = hwstate.fingers[i].tracking_id;
+    int slot = SlotForId(id);
+    if (slot < 0)
+      slot = AssignSlot(id, present);
+    if (slot >= 0)
+      present |= SlotBit(slot);
+  }
+  for (uint64_t left = live_ & ~present; left; left &= left - 1)
+    released_at_[__builtin_ctzll(left)] = ++release_count_;
+  live_ = present;
+}
+
+FingerMap::const_iterator FingerMap::find(short id) const {
+  if (!count(id))
+    return end();
+  // Count the members ordered before |id| to position the iterator.
+  size_t skipped = 0;
+  size_t rank = 0;
+  while (slots_->IdForSlot(slots_->SlotAtRank(rank)) != id) {
+    skipped += HasSlot(slots_->SlotAtRank(rank));
+    rank++;
+  }
+  return const_iterator(this, rank, size() - skipped);
+}
+
+void FingerMap::insert(short id) {
+  int slot = slots_ ? slots_->SlotForId(id) : -1;
+  if (slot < 0) {
+    Err("No finger slot for id %d", id);
+    return;
+  }
+  bits_ |= SlotBit(slot);
+}
+
+size_t FingerMap::erase(short id) {
+  if (!count(id))
+    return 0;
+  bits_ &= ~SlotBit(slots_->SlotForId(id));
+  return 1;
+}
+
+void FingerMap::RemoveMissingIds(const HardwareState& hwstate) {
+  if (!slots_)
+    return;
+  uint64_t present = 0;
+  for (size_t i = 0; i < hwstate.finger_cnt; i++) {
+    int slot = slots_->SlotForId(hwstate.fingers[i].tracking_id);
+    if (slot >= 0)
+      present |= SlotBit(slot);
+  }
+  bits_ &= present;
+}
+
+}  // namespace gestures
@@ -0,0 +1,175 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "include/finger_map.h"
+#include "include/gestures.h"
+#include "include/unittest_util.h"
+
+namespace gestures {
+
+class FingerMapTest : public ::testing::Test {};
+
+namespace {
+
+std::vector<short> Ids(const FingerMap& map) {
+  std::vector<short> ret;
+  for (short id : map)
+    ret.push_back(id);
+  return ret;
+}
+
+}  // namespace {}
+
+TEST(FingerMapTest, InsertEraseTest) {
+  FingerState fs[] = {
+    // TM, Tm, WM, Wm, Press, Orientation, X, Y, TrID
+    {0, 0, 0, 0, 50, 0, 10, 10, 30, 0},
+    {0, 0, 0, 0, 50, 0, 20, 10, 5, 0},
+    {0, 0, 0, 0, 50, 0, 30, 10, 17, 0},
+  };
+  HardwareState hs = make_hwstate(1.0, 0, 3, 3, fs);
+  FingerSlotTable slots;
+  slots.Update(hs);
+
+  FingerMap map(&slots);
+  EXPECT_TRUE(map.empty());
+  map.insert(30);
+  map.insert(5);
+  map.insert(30);
+  EXPECT_EQ(2, map.size());
+  EXPECT_EQ(1, map.count(5));
+  EXPECT_EQ(0, map.count(17));
+  EXPECT_EQ(0, map.count(99));
+  EXPECT_TRUE(map.find(17) == map.end());
+  EXPECT_EQ(30, *map.find(30));
+
+  map.insert(99);  // No slot, so not inserted.
+  EXPECT_EQ(2, map.size());
+
+  EXPECT_EQ(1, map.erase(5));
+  EXPECT_EQ(0, map.erase(5));
+  EXPECT_EQ(1, map.size());
+  map.clear();
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(FingerMapTest, IterationOrderTest) {
+  FingerState fs[] = {
+    // TM, Tm, WM, Wm, Press, Orientation, X, Y, TrID
+    {0, 0, 0, 0, 50, 0, 10, 10, 30, 0},
+    {0, 0, 0, 0, 50, 0, 20, 10, 5, 0},
+    {0, 0, 0, 0, 50, 0, 30, 10, 17, 0},
+    {0, 0, 0, 0, 50, 0, 40, 10, 8, 0},
+  };
+  HardwareState hs = make_hwstate(1.0, 0, 4, 4, fs);
+  FingerSlotTable slots;
+  slots.Update(hs);
+
+  FingerMap map(&slots);
+  map.insert(30);
+  map.insert(8);
+  map.insert(17);
+  EXPECT_EQ(std::vector<short>({8, 17, 30}), Ids(map));
+  EXPECT_EQ(8, *map.begin());
+  map.erase(*map.begin());
+  EXPECT_EQ(std::vector<short>({17, 30}), Ids(map));
+}
+
+TEST(FingerMapTest, SetOperationsTest) {
+  FingerState fs[] = {
+    // TM, Tm, WM, Wm, Press, Orientation, X, Y, TrID
+    {0, 0, 0, 0, 50, 0, 10, 10, 1, 0},
+    {0, 0, 0, 0, 50, 0, 20, 10, 2, 0},
+    {0, 0, 0, 0, 50, 0, 30, 10, 3, 0},
+  };
+  HardwareState hs = make_hwstate(1.0, 0, 3, 3, fs);
+  FingerSlotTable slots;
+  slots.Update(hs);
+
+  FingerMap a(&slots);
+  FingerMap b(&slots);
+  a.insert(1);
+  a.insert(2);
+  b.insert(2);
+  b.insert(3);
+
+  EXPECT_EQ(std::vector<short>({1}), Ids(a - b));
+
+  FingerMap both = a;
+  both &= b;
+  EXPECT_EQ(std::vector<short>({2}), Ids(both));
+
+  FingerMap either = a;
+  either |= b;
+  EXPECT_EQ(std::vector<short>({1, 2, 3}), Ids(either));
+
+  FingerMap copy = a;
+  EXPECT_TRUE(copy == a);
+  copy.RemoveAll(b);
+  EXPECT_TRUE(copy != a);
+  EXPECT_TRUE(SetContainsValue(a, 1));
+  EXPECT_FALSE(SetContainsValue(b, 1));
+
+  // Drop finger 2 and check RemoveMissingIds.
+  HardwareState hs_lift = make_hwstate(2.0, 0, 1, 1, &fs[2]);
+  slots.Update(hs_lift);
+  RemoveMissingIdsFromSet(&either, hs_lift);
+  EXPECT_EQ(std::vector<short>({3}), Ids(either));
+}
+
+TEST(FingerMapTest, SlotReuseTest) {
+  FingerState fs[] = {
+    // TM, Tm, WM, Wm, Press, Orientation, X, Y, TrID
+    {0, 0, 0, 0, 50, 0, 10, 10, 1, 0},
+    {0, 0, 0, 0, 50, 0, 20, 10, 2, 0},
+  };
+  FingerSlotTable slots;
+  HardwareState hs = make_hwstate(1.0, 0, 2, 2, fs);
+  slots.Update(hs);
+  int slot1 = slots.SlotForId(1);
+  int slot2 = slots.SlotForId(2);
+  EXPECT_GE(slot1, 0);
+  EXPECT_GE(slot2, 0);
+  EXPECT_NE(slot1, slot2);
+
+  // A map from this frame keeps its meaning after finger 1 leaves.
+  FingerMap prev(&slots);
+  prev.insert(1);
+
+  HardwareState hs_one = make_hwstate(2.0, 0, 1, 1, &fs[1]);
+  slots.Update(hs_one);
+  EXPECT_EQ(slot2, slots.SlotForId(2));
+  EXPECT_EQ(slot1, slots.SlotForId(1));
+  EXPECT_EQ(std::vector<short>({1}), Ids(prev));
+
+  // New ids get unused slots instead of the one finger 1 left behind.
+  for (short id = 3; id < 3 + static_cast<short>(kMaxFingerSlots) - 2; id++) {
+    FingerState new_fs[] = {
+      fs[1],
+      {0, 0, 0, 0, 50, 0, 30, 10, id, 0},
+    };
+    HardwareState new_hs = make_hwstate(3.0, 0, 2, 2, new_fs);
+    slots.Update(new_hs);
+    EXPECT_NE(slot1, slots.SlotForId(id));
+  }
+  EXPECT_EQ(slot1, slots.SlotForId(1));
+
+  // Once every slot has been used, the least recently released one is
+  // reused.
+  FingerState last_fs[] = {
+    fs[1],
+    {0, 0, 0, 0, 50, 0, 30, 10, 100, 0},
+  };
+  HardwareState last_hs = make_hwstate(4.0, 0, 2, 2, last_fs);
+  slots.Update(last_hs);
+  EXPECT_EQ(slot1, slots.SlotForId(100));
+  EXPECT_EQ(-1, slots.SlotForId(1));
+  EXPECT_EQ(slot2, slots.SlotForId(2));
+}
+
+}  // namespace gestures
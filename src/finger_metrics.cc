@@ -4,6 +4,8 @@
 
 #include "include/finger_metrics.h"
 
+#include <algorithm>
+
 namespace gestures {
 
 Vector2 Add(const Vector2& left, const Vector2& right) {
@@ -18,6 +20,34 @@ float Dot(const Vector2& left, const Vector2& right) {
   return left.x * right.x +  left.y * right.y;
 }
 
+void FingerDistances::Update(const HardwareState& hwstate) {
+  finger_cnt_ = hwstate.finger_cnt;
+  fingers_ = hwstate.fingers;
+  size_t count = std::min(finger_cnt_, kMaxFingers);
+  // Gather the positions into flat arrays first, so the inner loop below is
+  // a straight run over contiguous floats that the compiler can vectorize.
+  float pos_x[kMaxFingers];
+  float pos_y[kMaxFingers];
+  for (size_t i = 0; i < count; i++) {
+    pos_x[i] = fingers_[i].position_x;
+    pos_y[i] = fingers_[i].position_y;
+  }
+  for (size_t i = 0; i < count; i++) {
+    float x = pos_x[i];
+    float y = pos_y[i];
+    float* delta_x = delta_x_[i];
+    float* delta_y = delta_y_[i];
+    float* dist_sq = dist_sq_[i];
+    for (size_t j = 0; j < count; j++) {
+      float dx = x - pos_x[j];
+      float dy = y - pos_y[j];
+      delta_x[j] = dx;
+      delta_y[j] = dy;
+      dist_sq[j] = dx * dx + dy * dy;
+    }
+  }
+}
+
 MetricsProperties::MetricsProperties(PropRegistry* prop_reg)
     : two_finger_close_horizontal_distance_thresh(
           prop_reg,
@@ -2,10 +2,14 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string.h>
+
 #include <gtest/gtest.h>
 
 #include "include/finger_metrics.h"
 #include "include/gestures.h"
+#include "include/unittest_util.h"
+#include "include/util.h"
 
 namespace gestures {
 
@@ -52,4 +56,29 @@ TEST(FingerMetricsTest, SimpleTest) {
   EXPECT_EQ(Vector2(0.0, 0.0), fm.start_delta());
 }
 
+TEST(FingerMetricsTest, FingerDistancesTest) {
+  // One more finger than the table holds, to cover the fallback path.
+  const size_t kFingerCnt = kMaxFingers + 1;
+  FingerState fs[kFingerCnt];
+  for (size_t i = 0; i < kFingerCnt; i++) {
+    memset(&fs[i], 0, sizeof(fs[i]));
+    fs[i].position_x = 3.5 * i;
+    fs[i].position_y = 40.0 - 1.25 * i * i;
+    fs[i].tracking_id = i;
+  }
+  HardwareState hs = make_hwstate(1.0, 0, kFingerCnt, kFingerCnt, fs);
+  FingerDistances distances;
+  distances.Update(hs);
+  EXPECT_EQ(kFingerCnt, distances.finger_cnt());
+  for (size_t i = 0; i < kFingerCnt; i++) {
+    for (size_t j = 0; j < kFingerCnt; j++) {
+      EXPECT_EQ(fs[i].position_x - fs[j].position_x,
+                distances.DeltaX(i, j));
+      EXPECT_EQ(fs[i].position_y - fs[j].position_y,
+                distances.DeltaY(i, j));
+      EXPECT_EQ(DistSq(fs[i], fs[j]), distances.DistSq(i, j));
+    }
+  }
+}
+
 }  // namespace gestures
@@ -0,0 +1,211 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "include/gesture_differ.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "include/activity_log.h"
+#include "include/string_util.h"
+
+using std::string;
+
+namespace gestures {
+
+namespace {
+
+const char* TypeName(size_t type) {
+  switch (type) {
+    case kGestureTypeContactInitiated:
+      return ActivityLog::kValueGestureTypeContactInitiated;
+    case kGestureTypeMove:
+      return ActivityLog::kValueGestureTypeMove;
+    case kGestureTypeScroll:
+      return ActivityLog::kValueGestureTypeScroll;
+    case kGestureTypeButtonsChange:
+      return ActivityLog::kValueGestureTypeButtonsChange;
+    case kGestureTypeFling:
+      return ActivityLog::kValueGestureTypeFling;
+    case kGestureTypeSwipe:
+      return ActivityLog::kValueGestureTypeSwipe;
+    case kGestureTypePinch:
+      return ActivityLog::kValueGestureTypePinch;
+    case kGestureTypeSwipeLift:
+      return ActivityLog::kValueGestureTypeSwipeLift;
+    case kGestureTypeMetrics:
+      return ActivityLog::kValueGestureTypeMetrics;
+    case kGestureTypeFourFingerSwipe:
+      return ActivityLog::kValueGestureTypeFourFingerSwipe;
+    case kGestureTypeFourFingerSwipeLift:
+      return ActivityLog::kValueGestureTypeFourFingerSwipeLift;
+    case kGestureTypeMouseWheel:
+      return ActivityLog::kValueGestureTypeMouseWheel;
+  }
+  return "unknown";
+}
+
+// Sets (x, y) to the value of |gesture| that deviations are measured on.
+// Returns false if the gesture type has no such value.
+bool GestureValue(const Gesture& gesture, double* x, double* y) {
+  *y = 0.0;
+  switch (gesture.type) {
+    case kGestureTypeMove:
+      *x = gesture.details.move.dx;
+      *y = gesture.details.move.dy;
+      return true;
+    case kGestureTypeScroll:
+      *x = gesture.details.scroll.dx;
+      *y = gesture.details.scroll.dy;
+      return true;
+    case kGestureTypeMouseWheel:
+      *x = gesture.details.wheel.dx;
+      *y = gesture.details.wheel.dy;
+      return true;
+    case kGestureTypeFling:
+      *x = gesture.details.fling.vx;
+      *y = gesture.details.fling.vy;
+      return true;
+    case kGestureTypeSwipe:
+      *x = gesture.details.swipe.dx;
+      *y = gesture.details.swipe.dy;
+      return true;
+    case kGestureTypeFourFingerSwipe:
+      *x = gesture.details.four_finger_swipe.dx;
+      *y = gesture.details.four_finger_swipe.dy;
+      return true;
+    case kGestureTypePinch:
+      *x = gesture.details.pinch.dz;
+      return true;
+    default:
+      *x = 0.0;
+      return false;
+  }
+}
+
+bool ValidType(const Gesture& gesture) {
+  return gesture.type >= 0 &&
+      static_cast<size_t>(gesture.type) < kNumGestureTypes;
+}
+
+void AddPair(const Gesture& expected, const Gesture& actual,
+             GestureTypeDiff* diff) {
+  diff->matched++;
+  double offset = fabs(expected.end_time - actual.end_time);
+  diff->total_time_offset += offset;
+  diff->max_time_offset = std::max(diff->max_time_offset, offset);
+
+  double ex, ey, ax, ay;
+  if (!GestureValue(expected, &ex, &ey) || !GestureValue(actual, &ax, &ay))
+    return;
+  double deviation = hypot(ex - ax, ey - ay);
+  diff->total_deviation += deviation;
+  diff->max_deviation = std::max(diff->max_deviation, deviation);
+  diff->expected_magnitude += hypot(ex, ey);
+  diff->actual_magnitude += hypot(ax, ay);
+}
+
+}  // namespace {}
+
+size_t GestureDiff::matched() const {
+  size_t ret = 0;
+  for (const GestureTypeDiff& diff : types)
+    ret += diff.matched;
+  return ret;
+}
+
+size_t GestureDiff::missing() const {
+  size_t ret = 0;
+  for (const GestureTypeDiff& diff : types)
+    ret += diff.missing();
+  return ret;
+}
+
+size_t GestureDiff::extra() const {
+  size_t ret = 0;
+  for (const GestureTypeDiff& diff : types)
+    ret += diff.extra();
+  return ret;
+}
+
+double GestureDiff::max_deviation() const {
+  double ret = 0.0;
+  for (const GestureTypeDiff& diff : types)
+    ret = std::max(ret, diff.max_deviation);
+  return ret;
+}
+
+double GestureDiff::max_time_offset() const {
+  double ret = 0.0;
+  for (const GestureTypeDiff& diff : types)
+    ret = std::max(ret, diff.max_time_offset);
+  return ret;
+}
+
+string GestureDiff::Summary() const {
+  string ret;
+  for (size_t type = 0; type < kNumGestureTypes; type++) {
+    const GestureTypeDiff& diff = types[type];
+    if (!diff.expected && !diff.actual)
+      continue;
+    ret += StringPrintf(
+        "%s: %zu expected, %zu actual, %zu matched, %zu missing, %zu extra",
+        TypeName(type), diff.expected, diff.actual, diff.matched,
+        diff.missing(), diff.extra());
+    if (diff.matched) {
+      ret += StringPrintf(
+          ", deviation mean %g max %g, magnitude %g vs %g"
+          ", time offset mean %g max %g",
+          diff.total_deviation / diff.matched, diff.max_deviation,
+          diff.expected_magnitude, diff.actual_magnitude,
+          diff.total_time_offset / diff.matched, diff.max_time_offset);
+    }
+    ret += "\n";
+  }
+  ret += StringPrintf("total: %zu matched, %zu missing, %zu extra, "
+                      "max deviation %g, max time offset %g\n",
+                      matched(), missing(), extra(), max_deviation(),
+                      max_time_offset());
+  return ret;
+}
+
+GestureDiff DiffGestures(const std::vector<Gesture>& expected,
+                         const std::vector<Gesture>& actual,
+                         const GestureDiffOptions& options) {
+  GestureDiff ret;
+  // The actual gestures of each type, and the next one that can be matched.
+  std::vector<const Gesture*> by_type[kNumGestureTypes];
+  size_t next[kNumGestureTypes] = { 0 };
+  for (const Gesture& gesture : actual) {
+    if (!ValidType(gesture))
+      continue;
+    by_type[gesture.type].push_back(&gesture);
+    ret.types[gesture.type].actual++;
+  }
+
+  for (const Gesture& gesture : expected) {
+    if (!ValidType(gesture))
+      continue;
+    GestureTypeDiff* diff = &ret.types[gesture.type];
+    const std::vector<const Gesture*>& candidates = by_type[gesture.type];
+    size_t* cursor = &next[gesture.type];
+    diff->expected++;
+    // Actual gestures that ended too long before this one can't be matched
+    // by it or any later expected gesture, so they are extra.
+    while (*cursor < candidates.size() &&
+           candidates[*cursor]->end_time <
+               gesture.end_time - options.time_window)
+      ++*cursor;
+    if (*cursor < candidates.size() &&
+        fabs(candidates[*cursor]->end_time - gesture.end_time) <=
+            options.time_window) {
+      AddPair(gesture, *candidates[*cursor], diff);
+      ++*cursor;
+    }
+  }
+  return ret;
+}
+
+}  // namespace gestures
@@ -0,0 +1,98 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "include/gesture_differ.h"
+#include "include/gestures.h"
+
+namespace gestures {
+
+class GestureDifferTest : public ::testing::Test {};
+
+namespace {
+
+std::vector<Gesture> Moves(size_t count, double time_shift, float dx) {
+  std::vector<Gesture> ret;
+  for (size_t i = 0; i < count; i++) {
+    double t = 0.01 * i + time_shift;
+    ret.push_back(Gesture(kGestureMove, t, t + 0.01, dx, 0));
+  }
+  return ret;
+}
+
+}  // namespace {}
+
+TEST(GestureDifferTest, IdenticalTest) {
+  std::vector<Gesture> moves = Moves(5, 0.0, 1.0);
+  GestureDiff diff = DiffGestures(moves, moves, GestureDiffOptions());
+  EXPECT_TRUE(diff.Identical());
+  EXPECT_EQ(5, diff.matched());
+  EXPECT_EQ(5.0, diff.types[kGestureTypeMove].expected_magnitude);
+  EXPECT_EQ(0.0, diff.max_time_offset());
+}
+
+TEST(GestureDifferTest, TimeShiftTest) {
+  GestureDiffOptions options;
+  options.time_window = 0.005;
+  GestureDiff diff =
+      DiffGestures(Moves(5, 0.0, 1.0), Moves(5, 0.004, 1.5), options);
+  EXPECT_FALSE(diff.Identical());
+  EXPECT_EQ(5, diff.matched());
+  EXPECT_NEAR(0.004, diff.max_time_offset(), 1e-9);
+  EXPECT_FLOAT_EQ(0.5, diff.max_deviation());
+  EXPECT_FLOAT_EQ(7.5, diff.types[kGestureTypeMove].actual_magnitude);
+
+  // Pairs are made by time, so a shift by most of a frame lines each move up
+  // with the next expected one.
+  diff = DiffGestures(Moves(5, 0.0, 1.0), Moves(5, 0.006, 1.0), options);
+  EXPECT_EQ(4, diff.matched());
+  EXPECT_NEAR(0.004, diff.max_time_offset(), 1e-9);
+
+  // Outside of the window nothing lines up.
+  diff = DiffGestures(Moves(5, 0.0, 1.0), Moves(5, 1.0, 1.0), options);
+  EXPECT_EQ(0, diff.matched());
+  EXPECT_EQ(5, diff.missing());
+  EXPECT_EQ(5, diff.extra());
+}
+
+TEST(GestureDifferTest, DroppedAndExtraTest) {
+  std::vector<Gesture> expected = Moves(6, 0.0, 1.0);
+  std::vector<Gesture> actual = expected;
+  // Drop one move, and add a button change in the middle of the stream.
+  actual.erase(actual.begin() + 2);
+  actual.insert(actual.begin() + 3,
+                Gesture(kGestureButtonsChange, 0.03, 0.035,
+                        GESTURES_BUTTON_LEFT, 0, false));
+  GestureDiff diff = DiffGestures(expected, actual, GestureDiffOptions());
+  EXPECT_EQ(5, diff.matched());
+  EXPECT_EQ(1, diff.missing());
+  EXPECT_EQ(1, diff.extra());
+  EXPECT_EQ(0.0, diff.max_deviation());
+  EXPECT_EQ(1, diff.types[kGestureTypeMove].missing());
+  EXPECT_EQ(1, diff.types[kGestureTypeButtonsChange].extra());
+
+  std::string summary = diff.Summary();
+  EXPECT_NE(std::string::npos,
+            summary.find("move: 6 expected, 5 actual, 5 matched, 1 missing"));
+  EXPECT_NE(std::string::npos, summary.find("buttonsChange: 0 expected"));
+  EXPECT_NE(std::string::npos, summary.find("total: 5 matched"));
+}
+
+TEST(GestureDifferTest, FlingTest) {
+  std::vector<Gesture> expected(1, Gesture(kGestureFling, 1.0, 1.0, 30, 40,
+                                           GESTURES_FLING_START));
+  std::vector<Gesture> actual(1, Gesture(kGestureFling, 1.0, 1.01, 0, 40,
+                                         GESTURES_FLING_START));
+  GestureDiff diff = DiffGestures(expected, actual, GestureDiffOptions());
+  const GestureTypeDiff& fling = diff.types[kGestureTypeFling];
+  EXPECT_EQ(1, fling.matched);
+  EXPECT_FLOAT_EQ(30.0, fling.max_deviation);
+  EXPECT_FLOAT_EQ(50.0, fling.expected_magnitude);
+  EXPECT_FLOAT_EQ(40.0, fling.actual_magnitude);
+}
+
+}  // namespace gestures
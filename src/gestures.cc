@@ -4,6 +4,7 @@
 
 #include "include/gestures.h"
 
+#include <algorithm>
 #include <cstring>
 #include <sys/time.h>
 
@@ -14,22 +15,24 @@
 #include "include/finger_metrics.h"
 #include "include/fling_stop_filter_interpreter.h"
 #include "include/haptic_button_generator_filter_interpreter.h"
-#include "include/iir_filter_interpreter.h"
 #include "include/immediate_interpreter.h"
 #include "include/integral_gesture_filter_interpreter.h"
+#include "include/learned_palm_filter_interpreter.h"
 #include "include/logging.h"
 #include "include/logging_filter_interpreter.h"
 #include "include/lookahead_filter_interpreter.h"
 #include "include/metrics_filter_interpreter.h"
 #include "include/mouse_interpreter.h"
+#include "include/move_coalescing_filter_interpreter.h"
 #include "include/multitouch_mouse_interpreter.h"
 #include "include/non_linearity_filter_interpreter.h"
 #include "include/palm_classifying_filter_interpreter.h"
+#include "include/prediction_filter_interpreter.h"
 #include "include/prop_registry.h"
 #include "include/scaling_filter_interpreter.h"
 #include "include/sensor_jump_filter_interpreter.h"
+#include "include/smoothing_filter_interpreter.h"
 #include "include/split_correcting_filter_interpreter.h"
-#include "include/stationary_wiggle_filter_interpreter.h"
 #include "include/string_util.h"
 #include "include/stuck_button_inhibitor_filter_interpreter.h"
 #include "include/t5r2_correcting_filter_interpreter.h"
@@ -368,6 +371,11 @@ void GestureInterpreterPushHardwareState(GestureInterpreter* obj,
   obj->PushHardwareState(hwstate);
 }
 
+struct HardwareState* GestureInterpreterNextHardwareState(
+    GestureInterpreter* obj) {
+  return obj->NextHardwareState();
+}
+
 void GestureInterpreterSetHardwareProperties(
     GestureInterpreter* obj,
     const struct HardwareProperties* hwprops) {
@@ -397,6 +405,28 @@ void GestureInterpreterInitialize(GestureInterpreter* obj,
   obj->Initialize(cls);
 }
 
+void GestureInterpreterSetDeferPropCreation(GestureInterpreter* obj,
+                                            GesturesPropBool defer) {
+  obj->SetDeferPropCreation(defer);
+}
+
+void GestureInterpreterCreateDeferredProps(GestureInterpreter* obj) {
+  obj->CreateDeferredProps();
+}
+
+void GestureInterpreterSetStagedPropWrites(GestureInterpreter* obj,
+                                           GesturesPropBool staged) {
+  obj->SetStagedPropWrites(staged);
+}
+
+size_t GestureInterpreterGetStageStats(GestureInterpreter* obj,
+                                       struct GestureStageStats* stats,
+                                       size_t max_stats) {
+  std::vector<GestureStageStats> all = obj->GetStageStats();
+  std::copy_n(all.begin(), std::min(all.size(), max_stats), stats);
+  return all.size();
+}
+
 // C++ API:
 namespace gestures {
 class GestureInterpreterConsumer : public GestureConsumer {
@@ -456,6 +486,7 @@ void GestureInterpreter::PushHardwareState(HardwareState* hwstate) {
     Err("Filters are not composed yet!");
     return;
   }
+  prop_reg_->PublishStagedWrites();
   stime_t timeout = NO_DEADLINE;
   interpreter_->SyncInterpret(hwstate, &timeout);
   if (timer_provider_ && interpret_timer_) {
@@ -472,6 +503,15 @@ void GestureInterpreter::PushHardwareState(HardwareState* hwstate) {
   } else {
     ErrOnce("No timer provider has been set, so some features won't work.");
   }
+  prop_reg_->CreateDeferredProps();
+}
+
+HardwareState* GestureInterpreter::NextHardwareState() {
+  if (!interpreter_.get()) {
+    Err("Filters are not composed yet!");
+    return NULL;
+  }
+  return interpreter_->NextInputState();
 }
 
 void GestureInterpreter::SetHardwareProperties(
@@ -490,6 +530,7 @@ void GestureInterpreter::TimerCallback(stime_t now, stime_t* timeout) {
     Err("Filters are not composed yet!");
     return;
   }
+  prop_reg_->PublishStagedWrites();
   interpreter_->HandleTimer(now, timeout);
 }
 
@@ -514,6 +555,18 @@ void GestureInterpreter::SetPropProvider(GesturesPropProvider* pp,
   prop_reg_->SetPropProvider(pp, data);
 }
 
+void GestureInterpreter::SetDeferPropCreation(bool defer) {
+  prop_reg_->SetDeferredCreation(defer);
+}
+
+void GestureInterpreter::CreateDeferredProps() {
+  prop_reg_->CreateDeferredProps();
+}
+
+void GestureInterpreter::SetStagedPropWrites(bool staged) {
+  prop_reg_->SetStagedWrites(staged);
+}
+
 void GestureInterpreter::SetCallback(GestureReadyFunction callback,
                                      void* client_data) {
   callback_ = callback;
@@ -531,6 +584,8 @@ void GestureInterpreter::set_callback(GestureReadyFunction callback,
 void GestureInterpreter::InitializeTouchpad(void) {
   if (prop_reg_.get()) {
     IntProperty stack_version(prop_reg_.get(), "Touchpad Stack Version", 2);
+    // The provider's value picks the chain, so it can't wait.
+    prop_reg_->CreateDeferredProp(&stack_version);
     if (stack_version.val_ == 2) {
       InitializeTouchpad2();
       return;
@@ -541,13 +596,16 @@ void GestureInterpreter::InitializeTouchpad(void) {
   temp = new FlingStopFilterInterpreter(prop_reg_.get(), temp, tracer_.get(),
                                         GESTURES_DEVCLASS_TOUCHPAD);
   temp = new ClickWiggleFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
+  temp = new PredictionFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
   temp = new PalmClassifyingFilterInterpreter(prop_reg_.get(), temp,
                                               tracer_.get());
-  temp = new IirFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
+  temp = new SmoothingFilterInterpreter(prop_reg_.get(), temp, tracer_.get(),
+                                        { kSmoothingBiquad });
   temp = new LookaheadFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
-  temp = new BoxFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
-  temp = new StationaryWiggleFilterInterpreter(prop_reg_.get(), temp,
-                                               tracer_.get());
+  temp = new SmoothingFilterInterpreter(prop_reg_.get(), temp, tracer_.get(),
+                                        { kSmoothingStationaryWiggle,
+                                          kSmoothingOneEuro,
+                                          kSmoothingBox });
   temp = new SensorJumpFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
   temp = new AccelFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
   temp = new SplitCorrectingFilterInterpreter(prop_reg_.get(), temp,
@@ -556,6 +614,7 @@ void GestureInterpreter::InitializeTouchpad(void) {
                                                tracer_.get());
   temp = new MetricsFilterInterpreter(prop_reg_.get(), temp, tracer_.get(),
                                       GESTURES_DEVCLASS_TOUCHPAD);
+  temp = new LearnedPalmFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
   temp = new ScalingFilterInterpreter(prop_reg_.get(), temp, tracer_.get(),
                                       GESTURES_DEVCLASS_TOUCHPAD);
   temp = new FingerMergeFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
@@ -578,17 +637,20 @@ void GestureInterpreter::InitializeTouchpad2(void) {
   temp = new FlingStopFilterInterpreter(prop_reg_.get(), temp, tracer_.get(),
                                         GESTURES_DEVCLASS_TOUCHPAD);
   temp = new ClickWiggleFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
+  temp = new PredictionFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
   temp = new PalmClassifyingFilterInterpreter(prop_reg_.get(), temp,
                                               tracer_.get());
   temp = new LookaheadFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
-  temp = new BoxFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
-  temp = new StationaryWiggleFilterInterpreter(prop_reg_.get(), temp,
-                                               tracer_.get());
+  temp = new SmoothingFilterInterpreter(prop_reg_.get(), temp, tracer_.get(),
+                                        { kSmoothingStationaryWiggle,
+                                          kSmoothingOneEuro,
+                                          kSmoothingBox });
   temp = new AccelFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
   temp = new TrendClassifyingFilterInterpreter(prop_reg_.get(), temp,
                                                tracer_.get());
   temp = new MetricsFilterInterpreter(prop_reg_.get(), temp, tracer_.get(),
                                       GESTURES_DEVCLASS_TOUCHPAD);
+  temp = new LearnedPalmFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
   temp = new ScalingFilterInterpreter(prop_reg_.get(), temp, tracer_.get(),
                                       GESTURES_DEVCLASS_TOUCHPAD);
   temp = new FingerMergeFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
@@ -606,6 +668,8 @@ void GestureInterpreter::InitializeMouse(GestureInterpreterDeviceClass cls) {
   Interpreter* temp = new MouseInterpreter(prop_reg_.get(), tracer_.get());
   // TODO(clchiou;chromium-os:36321): Use mouse acceleration algorithm for mice
   temp = new AccelFilterInterpreter(prop_reg_.get(), temp, tracer_.get());
+  temp = new MoveCoalescingFilterInterpreter(prop_reg_.get(), temp,
+                                             tracer_.get());
   temp = new ScalingFilterInterpreter(prop_reg_.get(), temp, tracer_.get(),
                                       cls);
   temp = new MetricsFilterInterpreter(prop_reg_.get(), temp, tracer_.get(),
@@ -662,6 +726,13 @@ std::string GestureInterpreter::EncodeActivityLog() {
   return loggingFilter_->EncodeActivityLog();
 }
 
+std::vector<GestureStageStats> GestureInterpreter::GetStageStats() const {
+  std::vector<GestureStageStats> ret;
+  if (interpreter_)
+    interpreter_->CollectStageStats(&ret);
+  return ret;
+}
+
 const GestureMove kGestureMove = { 0, 0, 0, 0 };
 const GestureScroll kGestureScroll = { 0, 0, 0, 0, 0 };
 const GestureMouseWheel kGestureMouseWheel = { 0, 0, 0, 0 };
@@ -3,11 +3,16 @@
 // found in the LICENSE file.
 
 #include <gtest/gtest.h>
+#include <json/reader.h>
+#include <json/value.h>
 #include <memory>
 #include <stdio.h>
+#include <string.h>
 
+#include "include/activity_log.h"
 #include "include/gestures.h"
 #include "include/macros.h"
+#include "include/prop_registry.h"
 #include "include/unittest_util.h"
 
 namespace gestures {
@@ -527,4 +532,206 @@ TEST(GesturesTest, HardwareStateToStringTest) {
   return;
 }
 
+TEST(GesturesTest, StageStatsTest) {
+  HardwareProperties hwprops = {
+    0, 0, 100, 100,  // left, top, right, bottom
+    10, 10,  // x res, y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1, 2,  // orientation minimum, maximum
+    2, 5,  // max fingers, max_touch
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  GestureInterpreter* gi = NewGestureInterpreter();
+  gi->Initialize(GESTURES_DEVCLASS_TOUCHPAD);
+  gi->SetHardwareProperties(hwprops);
+  for (int i = 0; i < 10; i++) {
+    FingerState fs = { 0, 0, 0, 0, 50, 0, 10.0f + 5 * i, 50, 1, 0 };
+    HardwareState hs = make_hwstate(1.0 + 0.01 * i, 0, 1, 1, &fs);
+    gi->PushHardwareState(&hs);
+  }
+
+  std::vector<GestureStageStats> stats = gi->GetStageStats();
+  ASSERT_GT(stats.size(), 2);
+  EXPECT_STREQ("LoggingFilterInterpreter", stats.front().name);
+  EXPECT_STREQ("ImmediateInterpreter", stats.back().name);
+  for (const GestureStageStats& stage : stats)
+    EXPECT_EQ(10, stage.sync_calls) << stage.name;
+  for (size_t i = 0; i + 1 < stats.size(); i++)
+    EXPECT_EQ(stats[i + 1].gestures_produced, stats[i].gestures_consumed);
+
+  GestureStageStats c_stats[2];
+  EXPECT_EQ(stats.size(), GestureInterpreterGetStageStats(gi, c_stats, 2));
+  EXPECT_STREQ(stats[1].name, c_stats[1].name);
+  EXPECT_EQ(stats[1].sync_calls, c_stats[1].sync_calls);
+
+  Json::Value root;
+  Json::Reader reader;
+  ASSERT_TRUE(reader.parse(gi->EncodeActivityLog(), root, false));
+  const Json::Value& encoded = root[ActivityLog::kKeyStageStats];
+  ASSERT_EQ(stats.size(), encoded.size());
+  EXPECT_EQ("ImmediateInterpreter",
+            encoded[encoded.size() - 1]
+                [ActivityLog::kKeyInterpreterName].asString());
+  EXPECT_EQ(10, encoded[0][ActivityLog::kKeyStageStatsSyncCalls].asInt());
+  DeleteGestureInterpreter(gi);
+}
+
+namespace {
+
+// A prop provider that creates nothing the tests look at.
+char stub_prop;
+
+GesturesProp* StubCreateProp() {
+  return reinterpret_cast<GesturesProp*>(&stub_prop);
+}
+GesturesProp* StubCreateInt(void*, const char*, int*, size_t, const int*) {
+  return StubCreateProp();
+}
+GesturesProp* StubCreateString(void*, const char*, const char**,
+                               const char* const) {
+  return StubCreateProp();
+}
+GesturesProp* StubCreateReal(void*, const char*, double*, size_t,
+                             const double*) {
+  return StubCreateProp();
+}
+void StubRegisterHandlers(void*, GesturesProp*, void*,
+                          GesturesPropGetHandler, GesturesPropSetHandler) {}
+void StubFree(void*, GesturesProp*) {}
+
+}  // namespace {}
+
+namespace {
+
+void CountMoves(void* data, const Gesture* gesture) {
+  if (gesture->type == kGestureTypeMove)
+    (*reinterpret_cast<int*>(data))++;
+}
+
+}  // namespace {}
+
+TEST(GesturesTest, NextHardwareStateTest) {
+  HardwareProperties hwprops = {
+    0, 0, 0, 0,  // left, top, right, bottom
+    0, 0,  // x res, y res
+    0, 0,  // scrn DPI X, Y
+    -1, 2,  // orientation minimum, maximum
+    0, 0,  // max fingers, max_touch
+    0, 0, 0,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  std::unique_ptr<GestureInterpreter> gi(NewGestureInterpreter());
+  gi->Initialize(GESTURES_DEVCLASS_MOUSE);
+  gi->SetHardwareProperties(hwprops);
+  int moves = 0;
+  gi->SetCallback(CountMoves, &moves);
+  for (int i = 0; i < 4; i++) {
+    // Every filter of the mouse chain passes states on, so the mouse
+    // interpreter's spare state is handed out.
+    HardwareState* hs = GestureInterpreterNextHardwareState(gi.get());
+    ASSERT_NE(reinterpret_cast<HardwareState*>(NULL), hs);
+    *hs = make_hwstate(1.0 + 0.01 * i, 0, 0, 0, NULL);
+    hs->rel_x = 2;
+    gi->PushHardwareState(hs);
+  }
+  EXPECT_EQ(4, moves);
+  gi->SetCallback(NULL, NULL);
+
+  // The touchpad chain fills in the lookahead filter's next queue node, once
+  // there is one.
+  gi.reset(NewGestureInterpreter());
+  gi->Initialize(GESTURES_DEVCLASS_TOUCHPAD);
+  EXPECT_EQ(reinterpret_cast<HardwareState*>(NULL), gi->NextHardwareState());
+  hwprops.right = 100;
+  hwprops.bottom = 60;
+  hwprops.res_x = 1;
+  hwprops.res_y = 1;
+  hwprops.max_finger_cnt = 2;
+  hwprops.max_touch_cnt = 5;
+  gi->SetHardwareProperties(hwprops);
+  moves = 0;
+  gi->SetCallback(CountMoves, &moves);
+  for (int i = 0; i < 20; i++) {
+    HardwareState* hs = gi->NextHardwareState();
+    ASSERT_NE(reinterpret_cast<HardwareState*>(NULL), hs);
+    FingerState* fingers = hs->fingers;
+    ASSERT_NE(reinterpret_cast<FingerState*>(NULL), fingers);
+    FingerState fs = { 0, 0, 0, 0, 50, 0, 20.0f + i, 20, 1, 0 };
+    *hs = make_hwstate(2.0 + 0.01 * i, 0, 1, 1, fingers);
+    fingers[0] = fs;
+    gi->PushHardwareState(hs);
+  }
+  EXPECT_GT(moves, 0);
+  gi->SetCallback(NULL, NULL);
+}
+
+namespace {
+
+// A prop provider configured to turn on properties that some hardware
+// overrides.
+GesturesProp* HapticCreateBool(void*, const char* name, GesturesPropBool* loc,
+                               size_t, const GesturesPropBool*) {
+  if (!strcmp(name, "Compute Surface Area from Pressure") ||
+      !strcmp(name, "Compute Surface Area from Touch Size for Haptic Pads") ||
+      !strcmp(name, "Zero Finger Click Enable"))
+    *loc = 1;
+  return StubCreateProp();
+}
+
+}  // namespace {}
+
+// The overrides interpreters derive from the hardware properties outlive a
+// deferred creation of the properties they override.
+TEST(GesturesTest, DeferredHardwareOverrideTest) {
+  GesturesPropProvider provider = {
+    StubCreateInt,
+    NULL,
+    HapticCreateBool,
+    StubCreateString,
+    StubCreateReal,
+    StubRegisterHandlers,
+    StubFree
+  };
+  HardwareProperties hwprops = {
+    0, 0, 100, 60,  // left, top, right, bottom
+    1, 1,  // x res, y res
+    133, 133,  // scrn DPI X, Y
+    -1, 2,  // orientation minimum, maximum
+    5, 5,  // max fingers, max_touch
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    1,  // haptic pad
+  };
+  GestureInterpreter* gi = NewGestureInterpreter();
+  GestureInterpreterSetPropProvider(gi, &provider, NULL);
+  GestureInterpreterSetDeferPropCreation(gi, 1);
+  GestureInterpreterInitialize(gi, GESTURES_DEVCLASS_TOUCHPAD);
+  GestureInterpreterSetHardwareProperties(gi, &hwprops);
+  HardwareState hs = make_hwstate(1.0, 0, 0, 0, NULL);
+  GestureInterpreterPushHardwareState(gi, &hs);
+  GestureInterpreterCreateDeferredProps(gi);
+
+  PropRegistry* prop_reg = gi->prop_reg();
+  EXPECT_EQ(Json::Value(true), prop_reg->FindProperty(
+      "Compute Surface Area from Touch Size for Haptic Pads")->NewValue());
+  EXPECT_EQ(Json::Value(false), prop_reg->FindProperty(
+      "Compute Surface Area from Pressure")->NewValue());
+  // A button pad has no zero finger clicks.
+  EXPECT_EQ(Json::Value(false), prop_reg->FindProperty(
+      "Zero Finger Click Enable")->NewValue());
+  GestureInterpreterSetPropProvider(gi, NULL, NULL);
+  DeleteGestureInterpreter(gi);
+}
+
+TEST(GesturesTest, StagedPropWritesTest) {
+  GestureInterpreter* gi = NewGestureInterpreter();
+  EXPECT_FALSE(gi->prop_reg()->staged_writes());
+  GestureInterpreterSetStagedPropWrites(gi, 1);
+  EXPECT_TRUE(gi->prop_reg()->staged_writes());
+  DeleteGestureInterpreter(gi);
+}
+
 }  // namespace gestures
@@ -4,35 +4,25 @@
 
 #include "include/iir_filter_interpreter.h"
 
-#include <utility>
+#include <string.h>
+
+#include <algorithm>
 
 namespace gestures {
 
-void IirFilterInterpreter::IoHistory::Increment() {
-  out_head = NextOutHead();
-  in_head = NextInHead();
-}
+namespace {
 
-// Uses exact comparisions, rather than approximate float comparisions,
-// for operator==
-bool IirFilterInterpreter::IoHistory::operator==(
-    const IirFilterInterpreter::IoHistory& that) const {
-  for (size_t i = 0; i < kInSize; i++)
-    if (in[i] != that.in[i])
-      return false;
-  for (size_t i = 0; i < kOutSize; i++)
-    if (out[i] != that.out[i])
-      return false;
-  return true;
+uint64_t RowBit(size_t row) {
+  return static_cast<uint64_t>(1) << row;
 }
 
+}  // namespace {}
+
 // The default filter is a low-pass 2nd order Butterworth IIR filter with a
 // normalized cutoff frequency of 0.2.
-IirFilterInterpreter::IirFilterInterpreter(PropRegistry* prop_reg,
-                                           Interpreter* next,
-                                           Tracer* tracer)
-    : FilterInterpreter(NULL, next, tracer, false),
-      using_iir_(true),
+IirFilterBank::IirFilterBank(PropRegistry* prop_reg)
+    : using_iir_(true),
+      prev_rows_(0),
       b0_(prop_reg, "IIR b0", 0.0674552738890719),
       b1_(prop_reg, "IIR b1", 0.134910547778144),
       b2_(prop_reg, "IIR b2", 0.0674552738890719),
@@ -40,8 +30,8 @@ IirFilterInterpreter::IirFilterInterpreter(PropRegistry* prop_reg,
       a1_(prop_reg, "IIR a1", -1.1429805025399),
       a2_(prop_reg, "IIR a2", 0.412801598096189),
       iir_dist_thresh_(prop_reg, "IIR Distance Threshold", 10),
-      adjust_iir_on_warp_(prop_reg, "Adjust IIR History On Warp", false) {
-  InitName();
+      adjust_iir_on_warp_(prop_reg, "Adjust IIR History On Warp", false),
+      filter_touch_major_(prop_reg, "IIR Filter Touch Major", false) {
   b0_.SetDelegate(this);
   b1_.SetDelegate(this);
   b2_.SetDelegate(this);
@@ -49,126 +39,197 @@ IirFilterInterpreter::IirFilterInterpreter(PropRegistry* prop_reg,
   a1_.SetDelegate(this);
   a2_.SetDelegate(this);
   iir_dist_thresh_.SetDelegate(this);
+  memset(histories_, 0, sizeof(histories_));
 }
 
-void IirFilterInterpreter::SyncInterpretImpl(HardwareState* hwstate,
-                                             stime_t* timeout) {
-  // Delete old entries from map
-  short dead_ids[histories_.size() + 1];
-  size_t dead_ids_len = 0;
-  for (std::map<short, IoHistory>::iterator it = histories_.begin(),
-           e = histories_.end(); it != e; ++it)
-    if (!hwstate->GetFingerState((*it).first))
-      dead_ids[dead_ids_len++] = (*it).first;
-  for (size_t i = 0; i < dead_ids_len; ++i)
-    histories_.erase(dead_ids[i]);
-
-  // Modify current hwstate
-  for (size_t i = 0; i < hwstate->finger_cnt; i++) {
+void IirFilterBank::Filter(const HardwareProperties* hwprops, const int* rows,
+                           size_t finger_cnt, const double* sections,
+                           size_t section_cnt, HardwareState* hwstate) {
+  // The properties are read once per call rather than cached when written,
+  // as a replayed log sets them without notifying us.
+  const double b0 = b0_.val_, b1 = b1_.val_, b2 = b2_.val_, b3 = b3_.val_;
+  const double a1 = a1_.val_, a2 = a2_.val_;
+  const double dist_thresh_sq = iir_dist_thresh_.val_ * iir_dist_thresh_.val_;
+  const bool adjust_on_warp = adjust_iir_on_warp_.val_;
+  // Channels that skip the filter no matter what, and those that skip it on
+  // a warp along their axis.
+  bool pass[kNumChannels] = { false, false, false, false };
+  // Keep the current pressure reading, so we could make sure the pressure
+  // values will be same if there is two fingers on a SemiMT device.
+  pass[kChannelPressure] = hwprops && hwprops->support_semi_mt;
+  pass[kChannelTouchMajor] = !filter_touch_major_.val_;
+
+  uint64_t used = 0;
+  for (size_t i = 0; i < finger_cnt; i++) {
+    if (rows[i] < 0)
+      continue;
     FingerState* fs = &hwstate->fingers[i];
-    std::map<short, IoHistory>::iterator history =
-        histories_.find(fs->tracking_id);
-    if (history == histories_.end()) {
+    History* hist = &histories_[rows[i]];
+    const uint64_t bit = RowBit(rows[i]);
+    const float x[kNumChannels] = {
+      fs->position_x, fs->position_y, fs->pressure, fs->touch_major
+    };
+    if (!((prev_rows_ | used) & bit)) {
       // new finger
-      IoHistory hist(*fs);
-      histories_[fs->tracking_id] = hist;
+      used |= bit;
+      for (size_t j = 0; j < kInSize; j++)
+        memcpy(hist->in[j], x, sizeof(x));
+      for (size_t j = 0; j < kOutSize; j++)
+        memcpy(hist->out[j], x, sizeof(x));
+      for (size_t sec = 0; sec < kMaxExtraSections; sec++) {
+        for (size_t j = 0; j < kSectionSize; j++) {
+          memcpy(hist->section_in[sec][j], x, sizeof(x));
+          memcpy(hist->section_out[sec][j], x, sizeof(x));
+        }
+      }
       continue;
     }
-    // existing finger, apply filter
-    IoHistory* hist = &(*history).second;
+    used |= bit;
 
     // Finger WARP detected, adjust the IO history
-    if (adjust_iir_on_warp_.val_) {
-      float dx = 0.0, dy = 0.0;
-
-      if (fs->flags & GESTURES_FINGER_WARP_X_MOVE)
-        dx = fs->position_x - hist->PrevIn(0)->position_x;
-      if (fs->flags & GESTURES_FINGER_WARP_Y_MOVE)
-        dy = fs->position_y - hist->PrevIn(0)->position_y;
-
-      hist->WarpBy(dx, dy);
+    bool warped[kNumChannels] = { false, false, false, false };
+    if (adjust_on_warp) {
+      warped[kChannelX] = fs->flags & GESTURES_FINGER_WARP_X_MOVE;
+      warped[kChannelY] = fs->flags & GESTURES_FINGER_WARP_Y_MOVE;
+      float dx = warped[kChannelX] ? x[kChannelX] - hist->in[0][kChannelX] : 0;
+      float dy = warped[kChannelY] ? x[kChannelY] - hist->in[0][kChannelY] : 0;
+      for (size_t j = 0; j < kInSize; j++) {
+        hist->in[j][kChannelX] += dx;
+        hist->in[j][kChannelY] += dy;
+      }
+      for (size_t j = 0; j < kOutSize; j++) {
+        hist->out[j][kChannelX] += dx;
+        hist->out[j][kChannelY] += dy;
+      }
+      for (size_t sec = 0; sec < section_cnt; sec++) {
+        for (size_t j = 0; j < kSectionSize; j++) {
+          hist->section_in[sec][j][kChannelX] += dx;
+          hist->section_in[sec][j][kChannelY] += dy;
+          hist->section_out[sec][j][kChannelX] += dx;
+          hist->section_out[sec][j][kChannelY] += dy;
+        }
+      }
     }
 
-    float dx = fs->position_x - hist->PrevOut(0)->position_x;
-    float dy = fs->position_y - hist->PrevOut(0)->position_y;
+    // Filter all channels at once.
+    float y[kNumChannels];
+    for (size_t c = 0; c < kNumChannels; c++)
+      y[c] = b3 * hist->in[2][c] + b2 * hist->in[1][c] +
+          b1 * hist->in[0][c] + b0 * x[c] - a2 * hist->out[1][c] -
+          a1 * hist->out[0][c];
 
     // IIR filter is too smooth for a quick finger movement. We do a simple
     // rolling average if the position change between current and previous
     // frames is larger than iir_dist_thresh_.
-    if (dx * dx + dy * dy > iir_dist_thresh_.val_ * iir_dist_thresh_.val_)
-      using_iir_ = false;
-    else
-      using_iir_ = true;
-
-    // TODO(adlr): consider applying filter to other fields
-    float FingerState::*fields[] = { &FingerState::position_x,
-                                     &FingerState::position_y,
-                                     &FingerState::pressure };
-    for (size_t f_idx = 0; f_idx < arraysize(fields); f_idx++) {
-      float FingerState::*field = fields[f_idx];
-      // Keep the current pressure reading, so we could make sure the pressure
-      // values will be same if there is two fingers on a SemiMT device.
-      if (hwprops_ && hwprops_->support_semi_mt &&
-          (field == &FingerState::pressure)) {
-        hist->NextOut()->pressure = fs->pressure;
-        continue;
-      }
-
-      if (adjust_iir_on_warp_.val_) {
-        if (field == &FingerState::position_x &&
-            (fs->flags & GESTURES_FINGER_WARP_X_MOVE)) {
-          hist->NextOut()->position_x = fs->position_x;
-          continue;
-        }
-
-        if (field == &FingerState::position_y &&
-            (fs->flags & GESTURES_FINGER_WARP_Y_MOVE)) {
-          hist->NextOut()->position_y = fs->position_y;
-          continue;
-        }
-      }
-
-      if (using_iir_) {
-        hist->NextOut()->*field =
-            b3_.val_ * hist->PrevIn(2)->*field +
-            b2_.val_ * hist->PrevIn(1)->*field +
-            b1_.val_ * hist->PrevIn(0)->*field +
-            b0_.val_ * fs->*field -
-            a2_.val_ * hist->PrevOut(1)->*field -
-            a1_.val_ * hist->PrevOut(0)->*field;
-      } else {
-        hist->NextOut()->*field = 0.5 * (fs->*field + hist->PrevOut(0)->*field);
-      }
+    float dx = x[kChannelX] - hist->out[0][kChannelX];
+    float dy = x[kChannelY] - hist->out[0][kChannelY];
+    using_iir_ = !(dx * dx + dy * dy > dist_thresh_sq);
+    if (!using_iir_)
+      for (size_t c = 0; c < kNumChannels; c++)
+        y[c] = 0.5 * (x[c] + hist->out[0][c]);
+    for (size_t c = 0; c < kNumChannels; c++)
+      if (pass[c] || warped[c])
+        y[c] = x[c];
+
+    memcpy(hist->in[2], hist->in[1], sizeof(x));
+    memcpy(hist->in[1], hist->in[0], sizeof(x));
+    memcpy(hist->in[0], x, sizeof(x));
+    memcpy(hist->out[1], hist->out[0], sizeof(y));
+    memcpy(hist->out[0], y, sizeof(y));
+
+    // Run the extra sections, each on the output of the one before.
+    for (size_t sec = 0; sec < section_cnt; sec++) {
+      const double* coeffs = &sections[sec * kSectionCoefficients];
+      const double sb0 = coeffs[0], sb1 = coeffs[1], sb2 = coeffs[2];
+      const double sa1 = coeffs[3], sa2 = coeffs[4];
+      float (*sec_in)[kNumChannels] = hist->section_in[sec];
+      float (*sec_out)[kNumChannels] = hist->section_out[sec];
+      float sy[kNumChannels];
+      for (size_t c = 0; c < kNumChannels; c++)
+        sy[c] = sb0 * y[c] + sb1 * sec_in[0][c] + sb2 * sec_in[1][c] -
+            sa1 * sec_out[0][c] - sa2 * sec_out[1][c];
+      for (size_t c = 0; c < kNumChannels; c++)
+        if (pass[c] || warped[c])
+          sy[c] = y[c];
+      memcpy(sec_in[1], sec_in[0], sizeof(y));
+      memcpy(sec_in[0], y, sizeof(y));
+      memcpy(sec_out[1], sec_out[0], sizeof(y));
+      memcpy(sec_out[0], sy, sizeof(y));
+      memcpy(y, sy, sizeof(y));
     }
-    float FingerState::*pass_fields[] = { &FingerState::touch_major,
-                                          &FingerState::touch_minor,
-                                          &FingerState::width_major,
-                                          &FingerState::width_minor,
-                                          &FingerState::orientation };
-    for (size_t f_idx = 0; f_idx < arraysize(pass_fields); f_idx++)
-      hist->NextOut()->*pass_fields[f_idx] = fs->*pass_fields[f_idx];
-    hist->NextOut()->flags = fs->flags;
-    *hist->NextIn() = *fs;
-    *fs = *hist->NextOut();
-    hist->Increment();
+    fs->position_x = y[kChannelX];
+    fs->position_y = y[kChannelY];
+    fs->pressure = y[kChannelPressure];
+    fs->touch_major = y[kChannelTouchMajor];
   }
-  next_->SyncInterpret(hwstate, timeout);
+  prev_rows_ = used;
 }
 
-void IirFilterInterpreter::DoubleWasWritten(DoubleProperty* prop) {
-  histories_.clear();
+void IirFilterBank::DoubleWasWritten(DoubleProperty* prop) {
+  // Start over with the new filter.
+  Restart();
 }
 
-void IirFilterInterpreter::IoHistory::WarpBy(float dx, float dy) {
-  for (size_t i = 0; i < kInSize; i++) {
-    PrevIn(i)->position_x += dx;
-    PrevIn(i)->position_y += dy;
-  }
+IirFilterInterpreter::IirFilterInterpreter(PropRegistry* prop_reg,
+                                           Interpreter* next,
+                                           Tracer* tracer)
+    : FilterInterpreter(NULL, next, tracer, false),
+      iir_(prop_reg),
+      live_rows_(0),
+      prev_finger_cnt_(0) {
+  InitName();
+  memset(row_ids_, 0, sizeof(row_ids_));
+}
+
+void IirFilterInterpreter::SyncInterpretImpl(HardwareState* hwstate,
+                                             stime_t* timeout) {
+  const size_t finger_cnt =
+      std::min<size_t>(hwstate->finger_cnt, kMaxFingerSlots);
+  int rows[kMaxFingerSlots];
+  AssignRows(*hwstate, finger_cnt, rows);
+  iir_.Filter(hwprops_, rows, finger_cnt, NULL, 0, hwstate);
+  next_->SyncInterpret(hwstate, timeout);
+}
 
-  for (size_t i = 0; i < kOutSize; i++) {
-    PrevOut(i)->position_x += dx;
-    PrevOut(i)->position_y += dy;
+void IirFilterInterpreter::AssignRows(const HardwareState& hwstate,
+                                      size_t finger_cnt, int* rows) {
+  uint64_t taken = 0;
+  size_t new_fingers[kMaxFingerSlots];
+  size_t new_cnt = 0;
+  for (size_t i = 0; i < finger_cnt; i++) {
+    short id = hwstate.fingers[i].tracking_id;
+    int row = -1;
+    if (i < prev_finger_cnt_ && prev_rows_[i] >= 0 &&
+        row_ids_[prev_rows_[i]] == id) {
+      row = prev_rows_[i];
+    } else {
+      for (uint64_t rest = live_rows_; rest; rest &= rest - 1) {
+        size_t candidate = __builtin_ctzll(rest);
+        if (row_ids_[candidate] == id) {
+          row = candidate;
+          break;
+        }
+      }
+    }
+    rows[i] = row;
+    if (row < 0)
+      new_fingers[new_cnt++] = i;
+    else
+      taken |= RowBit(row);
+  }
+  // A new contact gets a row that no contact had last time, so its history
+  // starts over.
+  uint64_t free_rows = ~(live_rows_ | taken);
+  for (size_t i = 0; i < new_cnt && free_rows; i++) {
+    size_t row = __builtin_ctzll(free_rows);
+    free_rows &= free_rows - 1;
+    row_ids_[row] = hwstate.fingers[new_fingers[i]].tracking_id;
+    rows[new_fingers[i]] = row;
+    taken |= RowBit(row);
   }
+  live_rows_ = taken;
+  std::copy(rows, rows + finger_cnt, prev_rows_);
+  prev_finger_cnt_ = finger_cnt;
 }
 
 }  // namespace gestures
@@ -2,8 +2,12 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include "include/activity_log.h"
+#include "include/activity_replay.h"
 #include "include/gestures.h"
 #include "include/iir_filter_interpreter.h"
 #include "include/unittest_util.h"
@@ -97,9 +101,90 @@ TEST(IirFilterInterpreterTest, DisableIIRTest) {
     // After hs[3], the actual output of hs[i] is approaching hs[i] so
     // IIR filter will be re-enabled.
     if (i >= 2 && i <= 3)
-      EXPECT_EQ(interpreter.using_iir_, false);
+      EXPECT_EQ(interpreter.iir_.using_iir_, false);
     else
-      EXPECT_EQ(interpreter.using_iir_, true);
+      EXPECT_EQ(interpreter.iir_.using_iir_, true);
+  }
+}
+
+class IirFilterInterpreterRecordingInterpreter : public Interpreter {
+ public:
+  IirFilterInterpreterRecordingInterpreter()
+      : Interpreter(NULL, NULL, false) {}
+
+  virtual void SyncInterpret(HardwareState* hwstate, stime_t* timeout) {
+    fingers_.assign(hwstate->fingers, hwstate->fingers + hwstate->finger_cnt);
+  }
+
+  virtual void HandleTimer(stime_t now, stime_t* timeout) {}
+
+  std::vector<FingerState> fingers_;
+};
+
+TEST(IirFilterInterpreterTest, CoefficientTest) {
+  IirFilterInterpreterRecordingInterpreter* base_interpreter =
+      new IirFilterInterpreterRecordingInterpreter;
+  IirFilterInterpreter interpreter(NULL, base_interpreter, NULL);
+  TestInterpreterWrapper wrapper(&interpreter);
+
+  // Three fingers arriving at different times and moving slowly; each is
+  // filtered on its own, as if by a plain biquad.
+  IirFilterBank* iir = &interpreter.iir_;
+  const double b[] = { iir->b0_.val_, iir->b1_.val_, iir->b2_.val_ };
+  const double a[] = { 1.0, iir->a1_.val_, iir->a2_.val_ };
+  const size_t kFingers = 3;
+  float in[kFingers][3] = { { 0 } };  // x[n], x[n-1], x[n-2]
+  float out[kFingers][3] = { { 0 } };  // y[n], y[n-1], y[n-2]
+  for (size_t frame = 0; frame < 20; frame++) {
+    FingerState fs[kFingers];
+    size_t finger_cnt = 0;
+    for (size_t f = 0; f < kFingers; f++) {
+      if (frame < 3 * f)
+        continue;
+      float x = 10.0 * f + 0.5 * frame + (frame % 3 ? 0.3 : 0.0);
+      FingerState finger = {
+        0, 0, 0, 0, 30, 0, x, 5, static_cast<short>(f + 1), 0
+      };
+      fs[finger_cnt++] = finger;
+      if (frame == 3 * f) {
+        // New finger: the history starts out as the first input.
+        for (size_t i = 0; i < 3; i++)
+          in[f][i] = out[f][i] = x;
+        continue;
+      }
+      in[f][2] = in[f][1];
+      in[f][1] = in[f][0];
+      in[f][0] = x;
+      out[f][2] = out[f][1];
+      out[f][1] = out[f][0];
+      out[f][0] = b[0] * in[f][0] + b[1] * in[f][1] + b[2] * in[f][2] -
+          a[1] * out[f][1] - a[2] * out[f][2];
+    }
+    HardwareState hs = make_hwstate(0.01 * frame, 0, finger_cnt, finger_cnt,
+                                    fs);
+    wrapper.SyncInterpret(&hs, NULL);
+    ASSERT_EQ(finger_cnt, base_interpreter->fingers_.size());
+    for (size_t i = 0; i < finger_cnt; i++) {
+      size_t f = base_interpreter->fingers_[i].tracking_id - 1;
+      EXPECT_FLOAT_EQ(out[f][0], base_interpreter->fingers_[i].position_x)
+          << "frame " << frame << " finger " << f;
+      EXPECT_FLOAT_EQ(5.0, base_interpreter->fingers_[i].position_y);
+    }
+  }
+
+  // New coefficients take effect when written, and the history restarts.
+  iir->b0_.val_ = 1.0;
+  iir->b1_.val_ = 0.0;
+  iir->b2_.val_ = 0.0;
+  iir->a1_.val_ = 0.0;
+  iir->a2_.val_ = 0.0;
+  iir->DoubleWasWritten(&iir->a2_);
+  for (size_t frame = 0; frame < 3; frame++) {
+    FingerState fs = { 0, 0, 0, 0, 30, 0, 3.0f * frame, 5, 1, 0 };
+    HardwareState hs = make_hwstate(1.0 + 0.01 * frame, 0, 1, 1, &fs);
+    wrapper.SyncInterpret(&hs, NULL);
+    ASSERT_EQ(1, base_interpreter->fingers_.size());
+    EXPECT_FLOAT_EQ(3.0 * frame, base_interpreter->fingers_[0].position_x);
   }
 }
 
@@ -157,4 +242,102 @@ TEST(IirFilterInterpreterTest, SemiMTIIRTest) {
   EXPECT_EQ(fs_semi_mt[n - 1].pressure, kTestPressure);
 }
 
+TEST(IirFilterInterpreterTest, TouchMajorTest) {
+  IirFilterInterpreterRecordingInterpreter* base_interpreter =
+      new IirFilterInterpreterRecordingInterpreter;
+  PropRegistry prop_reg;
+  IirFilterInterpreter interpreter(&prop_reg, base_interpreter, NULL);
+  TestInterpreterWrapper wrapper(&interpreter);
+
+  // Sends finger |id| with the same pressure and touch_major, and returns
+  // what comes out.
+  auto run = [&](size_t frame, short id, float value) {
+    FingerState fs = { value, 0, 0, 0, value, 0, 10, 10, id, 0 };
+    HardwareState hs = make_hwstate(0.01 * frame, 0, 1, 1, &fs);
+    wrapper.SyncInterpret(&hs, NULL);
+    return base_interpreter->fingers_[0];
+  };
+
+  // touch_major passes through by default.
+  for (size_t frame = 0; frame < 6; frame++) {
+    float value = frame % 2 ? 40 : 30;
+    FingerState out = run(frame, 1, value);
+    EXPECT_EQ(value, out.touch_major) << frame;
+    if (frame)
+      EXPECT_NE(value, out.pressure) << frame;
+  }
+
+  // Once enabled, it's filtered the same as the pressure.
+  Property* prop = prop_reg.FindProperty("IIR Filter Touch Major");
+  ASSERT_NE(nullptr, prop);
+  EXPECT_TRUE(prop->SetValue(Json::Value(true)));
+  for (size_t frame = 6; frame < 12; frame++) {
+    float value = frame % 2 ? 40 : 30;
+    FingerState out = run(frame, 2, value);
+    EXPECT_EQ(out.pressure, out.touch_major) << frame;
+    if (frame > 6)
+      EXPECT_NE(value, out.touch_major) << frame;
+  }
+}
+
+// A replayed log restores its properties without notifying their delegates.
+// The filter must still use the logged coefficients.
+TEST(IirFilterInterpreterTest, ReplayPropertiesTest) {
+  HardwareProperties hwprops = {
+    0, 0, 100, 60,  // left, top, right, bottom
+    1.0, 1.0, 25.4, 25.4, // x res, y res, x DPI, y DPI
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    2, 3, 0, 0, 0,  // max_fingers, max_touch, t5r2, semi_mt, is_button_pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // is_haptic_pad
+  };
+
+  // Log a finger moving through a filter that passes it as is.
+  PropRegistry record_reg;
+  IirFilterInterpreter recorder(&record_reg,
+                                new IirFilterInterpreterRecordingInterpreter,
+                                NULL);
+  const char* kZeroCoefficients[] = { "IIR b1", "IIR b2", "IIR a1", "IIR a2" };
+  ASSERT_TRUE(record_reg.FindProperty("IIR b0")->SetValue(Json::Value(1.0)));
+  for (const char* name : kZeroCoefficients)
+    ASSERT_TRUE(record_reg.FindProperty(name)->SetValue(Json::Value(0.0)));
+  ActivityLog log(&record_reg);
+  log.SetHardwareProperties(hwprops);
+  const size_t kFrames = 10;
+  for (size_t frame = 0; frame < kFrames; frame++) {
+    FingerState fs = {
+      0, 0, 0, 0, 30.0f + frame, 0, 10.0f + 0.5f * frame, 5, 1, 0
+    };
+    HardwareState hs = make_hwstate(0.01 * frame, 0, 1, 1, &fs);
+    log.LogHardwareState(hs);
+  }
+
+  IirFilterInterpreterRecordingInterpreter* base_interpreter =
+      new IirFilterInterpreterRecordingInterpreter;
+  PropRegistry replay_reg;
+  IirFilterInterpreter interpreter(&replay_reg, base_interpreter, NULL);
+  TestInterpreterWrapper wrapper(&interpreter, &hwprops);
+  ActivityReplay replay(&replay_reg);
+  ASSERT_TRUE(replay.Parse(log.Encode()));
+  size_t frames = 0;
+  for (size_t i = 0; i < replay.log()->size(); i++) {
+    const ActivityLog::Entry* entry = replay.log()->GetEntry(i);
+    if (entry->type != ActivityLog::kHardwareState)
+      continue;
+    HardwareState hs = entry->details.hwstate;
+    std::vector<FingerState> fingers(hs.fingers, hs.fingers + hs.finger_cnt);
+    hs.fingers = fingers.data();
+    wrapper.SyncInterpret(&hs, NULL);
+    ASSERT_EQ(1, base_interpreter->fingers_.size());
+    const FingerState& logged = entry->details.hwstate.fingers[0];
+    EXPECT_EQ(logged.position_x, base_interpreter->fingers_[0].position_x)
+        << "frame " << frames;
+    EXPECT_EQ(logged.pressure, base_interpreter->fingers_[0].pressure)
+        << "frame " << frames;
+    frames++;
+  }
+  EXPECT_EQ(kFrames, frames);
+}
+
 }  // namespace gestures
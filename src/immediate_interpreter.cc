@@ -8,7 +8,6 @@
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
-#include <functional>
 #include <limits>
 #include <tuple>
 
@@ -16,8 +15,6 @@
 #include "include/logging.h"
 #include "include/util.h"
 
-using std::bind;
-using std::for_each;
 using std::make_pair;
 using std::make_tuple;
 using std::max;
@@ -39,6 +36,17 @@ float MinMag(float a, float b) {
   return b;
 }
 
+enum ScrollDirection { kScrollNone, kScrollUp, kScrollDown, kScrollLeft,
+                       kScrollRight };
+
+ScrollDirection GetScrollDirection(const ScrollEvent& event) {
+  if (FloatEq(event.dx, 0.0) && FloatEq(event.dy, 0.0))
+    return kScrollNone;
+  if (fabsf(event.dx) > fabsf(event.dy))
+    return event.dx > 0 ? kScrollRight : kScrollLeft;
+  return event.dy > 0 ? kScrollDown : kScrollUp;
+}
+
 // A comparator class for use with STL algorithms that sorts FingerStates
 // by their origin timestamp.
 class FingerOriginCompare {
@@ -57,6 +65,16 @@ class FingerOriginCompare {
 
 }  // namespace {}
 
+TapRecord::TapRecord(const ImmediateInterpreter* immediate_interpreter)
+    : released_(&immediate_interpreter->finger_slots_),
+      min_tap_pressure_met_(&immediate_interpreter->finger_slots_),
+      min_cotap_pressure_met_(&immediate_interpreter->finger_slots_),
+      immediate_interpreter_(immediate_interpreter),
+      t5r2_(false),
+      t5r2_touched_size_(0),
+      t5r2_released_size_(0),
+      fingers_below_max_age_(true) {}
+
 void TapRecord::NoteTouch(short the_id, const FingerState& fs) {
   // New finger must be close enough to an existing finger
   if (!touched_.empty()) {
@@ -95,9 +113,9 @@ float TapRecord::CotapMinPressure() const {
 
 void TapRecord::Update(const HardwareState& hwstate,
                        const HardwareState& prev_hwstate,
-                       const std::set<short>& added,
-                       const std::set<short>& removed,
-                       const std::set<short>& dead) {
+                       const FingerMap& added,
+                       const FingerMap& removed,
+                       const FingerMap& dead) {
   if (!t5r2_ && (hwstate.finger_cnt != hwstate.touch_cnt ||
                  prev_hwstate.finger_cnt != prev_hwstate.touch_cnt)) {
     // switch to T5R2 mode
@@ -113,22 +131,18 @@ void TapRecord::Update(const HardwareState& hwstate,
     else if (diff < 0)
       t5r2_released_size_ += -diff;
   }
-  for (std::set<short>::const_iterator it = added.begin(),
-           e = added.end(); it != e; ++it)
-    Log("TapRecord::Update: Added: %d", *it);
-  for (std::set<short>::const_iterator it = removed.begin(),
-           e = removed.end(); it != e; ++it)
-    Log("TapRecord::Update: Removed: %d", *it);
-  for (std::set<short>::const_iterator it = dead.begin(),
-           e = dead.end(); it != e; ++it)
-    Log("TapRecord::Update: Dead: %d", *it);
-  for_each(dead.begin(), dead.end(),
-           bind(&TapRecord::Remove, this, std::placeholders::_1));
-  for (std::set<short>::const_iterator it = added.begin(),
-           e = added.end(); it != e; ++it)
-    NoteTouch(*it, *hwstate.GetFingerState(*it));
-  for_each(removed.begin(), removed.end(),
-           bind(&TapRecord::NoteRelease, this, std::placeholders::_1));
+  for (short id : added)
+    Log("TapRecord::Update: Added: %d", id);
+  for (short id : removed)
+    Log("TapRecord::Update: Removed: %d", id);
+  for (short id : dead)
+    Log("TapRecord::Update: Dead: %d", id);
+  for (short id : dead)
+    Remove(id);
+  for (short id : added)
+    NoteTouch(id, *hwstate.GetFingerState(id));
+  for (short id : removed)
+    NoteRelease(id);
   // Check if min tap/cotap pressure met yet
   const float cotap_min_pressure = CotapMinPressure();
   for (std::map<short, FingerState>::iterator it =
@@ -231,9 +245,8 @@ bool TapRecord::TapComplete() const {
   for (std::map<short, FingerState>::const_iterator
            it = touched_.begin(), e = touched_.end(); it != e; ++it)
     Log("TapRecord::TapComplete: touched_: %d", (*it).first);
-  for (std::set<short>::const_iterator it = released_.begin(),
-           e = released_.end(); it != e; ++it)
-    Log("TapRecord::TapComplete: released_: %d", *it);
+  for (short id : released_)
+    Log("TapRecord::TapComplete: released_: %d", id);
   return ret;
 }
 
@@ -268,16 +281,72 @@ ScrollEvent ScrollEvent::Add(const ScrollEvent& evt_a,
   return ret;
 }
 
+ScrollEventBuffer::ScrollEventBuffer(size_t size)
+    : buf_(new Entry[size]()), max_size_(size), size_(0), head_(0),
+      weight_decay_(1.0) {
+  memset(&base_, 0, sizeof(base_));
+}
+
+void ScrollEventBuffer::Accumulate(const Prefix& prev,
+                                   const Entry* prev_entry,
+                                   Entry* entry) const {
+  const ScrollEvent& event = entry->event_;
+  Prefix* prefix = &entry->prefix_;
+  prefix->t_ = prev.t_ + event.dt;
+  prefix->x_ = prev.x_ + event.dx;
+  prefix->y_ = prev.y_ + event.dy;
+
+  const ScrollRegressionSums& prev_sums = prev.sums_;
+  ScrollRegressionSums* sums = &prefix->sums_;
+  double decay = weight_decay_;
+  sums->w_ = decay * prev_sums.w_ + 1.0;
+  sums->t_ = decay * prev_sums.t_ + prefix->t_;
+  sums->tt_ = decay * prev_sums.tt_ + prefix->t_ * prefix->t_;
+  sums->tx_ = decay * prev_sums.tx_ + prefix->t_ * prefix->x_;
+  sums->ty_ = decay * prev_sums.ty_ + prefix->t_ * prefix->y_;
+  sums->x_ = decay * prev_sums.x_ + prefix->x_;
+  sums->y_ = decay * prev_sums.y_ + prefix->y_;
+
+  ScrollDirection direction = GetScrollDirection(event);
+  if (direction == kScrollNone)
+    entry->run_ = 0;
+  else if (prev_entry && GetScrollDirection(prev_entry->event_) == direction)
+    entry->run_ = prev_entry->run_ + 1;
+  else
+    entry->run_ = 1;
+}
+
+void ScrollEventBuffer::Rebuild() {
+  memset(&base_, 0, sizeof(base_));
+  const Entry* prev_entry = NULL;
+  for (size_t i = size_; i-- > 0;) {
+    Entry* entry = &buf_[(head_ + i) % max_size_];
+    Accumulate(prev_entry ? prev_entry->prefix_ : base_, prev_entry, entry);
+    prev_entry = entry;
+  }
+}
+
 void ScrollEventBuffer::Insert(float dx, float dy, float dt) {
+  Entry prev_entry = buf_[head_];
   head_ = (head_ + max_size_ - 1) % max_size_;
-  buf_[head_].dx = dx;
-  buf_[head_].dy = dy;
-  buf_[head_].dt = dt;
+  if (size_ == max_size_)
+    base_ = buf_[head_].prefix_;  // The oldest event is being overwritten.
+  Entry* entry = &buf_[head_];
+  entry->event_.dx = dx;
+  entry->event_.dy = dy;
+  entry->event_.dt = dt;
+  Accumulate(size_ ? prev_entry.prefix_ : base_, size_ ? &prev_entry : NULL,
+             entry);
   size_ = std::min(size_ + 1, max_size_);
+  // The running sums grow without bound during a long scroll. Move the
+  // origin forward once per trip around the buffer to keep them precise.
+  if (head_ == 0 && size_ == max_size_)
+    Rebuild();
 }
 
 void ScrollEventBuffer::Clear() {
   size_ = 0;
+  memset(&base_, 0, sizeof(base_));
 }
 
 const ScrollEvent& ScrollEventBuffer::Get(size_t offset) const {
@@ -287,23 +356,64 @@ const ScrollEvent& ScrollEventBuffer::Get(size_t offset) const {
     static ScrollEvent dummy_event = { 0.0, 0.0, 0.0 };
     return dummy_event;
   }
-  return buf_[(head_ + offset) % max_size_];
+  return buf_[(head_ + offset) % max_size_].event_;
+}
+
+const ScrollEventBuffer::Prefix& ScrollEventBuffer::PrefixBefore(
+    size_t count) const {
+  if (count >= size_)
+    return base_;
+  return buf_[(head_ + count) % max_size_].prefix_;
 }
 
 void ScrollEventBuffer::GetSpeedSq(size_t num_events, float* dist_sq,
                                    float* dt) const {
-  float dx = 0.0;
-  float dy = 0.0;
-  *dt = 0.0;
-  for (size_t i = 0; i < Size() && i < num_events; i++) {
-    const ScrollEvent& evt = Get(i);
-    dx += evt.dx;
-    dy += evt.dy;
-    *dt += evt.dt;
+  if (!size_ || !num_events) {
+    *dist_sq = 0.0;
+    *dt = 0.0;
+    return;
   }
+  const Prefix& newest = buf_[head_].prefix_;
+  const Prefix& before = PrefixBefore(num_events);
+  float dx = newest.x_ - before.x_;
+  float dy = newest.y_ - before.y_;
+  *dt = newest.t_ - before.t_;
   *dist_sq = dx * dx + dy * dy;
 }
 
+size_t ScrollEventBuffer::SameDirectionCount() const {
+  if (!size_)
+    return 0;
+  return std::min(buf_[head_].run_, size_);
+}
+
+void ScrollEventBuffer::GetRegressionSums(size_t count,
+                                          ScrollRegressionSums* out) const {
+  count = std::min(count, size_);
+  if (!count) {
+    memset(out, 0, sizeof(*out));
+    return;
+  }
+  const ScrollRegressionSums& newest = buf_[head_].prefix_.sums_;
+  const ScrollRegressionSums& before = PrefixBefore(count).sums_;
+  double scale = weight_decay_ == 1.0 ? 1.0 : pow(weight_decay_, count);
+  out->w_ = newest.w_ - scale * before.w_;
+  out->t_ = newest.t_ - scale * before.t_;
+  out->tt_ = newest.tt_ - scale * before.tt_;
+  out->tx_ = newest.tx_ - scale * before.tx_;
+  out->ty_ = newest.ty_ - scale * before.ty_;
+  out->x_ = newest.x_ - scale * before.x_;
+  out->y_ = newest.y_ - scale * before.y_;
+}
+
+void ScrollEventBuffer::SetWeightDecay(double decay) {
+  decay = std::max(std::min(decay, 1.0), 0.001);
+  if (decay == weight_decay_)
+    return;
+  weight_decay_ = decay;
+  Rebuild();
+}
+
 HardwareStateBuffer::HardwareStateBuffer(size_t size)
     : states_(new HardwareState[size]),
       newest_index_(0), size_(size), max_finger_cnt_(0) {
@@ -312,32 +422,34 @@ HardwareStateBuffer::HardwareStateBuffer(size_t size)
   }
 }
 
-HardwareStateBuffer::~HardwareStateBuffer() {
-  for (size_t i = 0; i < size_; i++) {
-    delete[] states_[i].fingers;
-  }
-}
-
 void HardwareStateBuffer::Reset(size_t max_finger_cnt) {
   max_finger_cnt_ = max_finger_cnt;
-  for (size_t i = 0; i < size_; i++) {
-    delete[] states_[i].fingers;
-  }
-  if (max_finger_cnt_) {
-    for (size_t i = 0; i < size_; i++) {
-      states_[i].fingers = new FingerState[max_finger_cnt_];
-      memset(states_[i].fingers, 0, sizeof(FingerState) * max_finger_cnt_);
-    }
-  } else {
+  if (!max_finger_cnt_) {
+    finger_arena_.reset();
     for (size_t i = 0; i < size_; i++) {
       states_[i].fingers = NULL;
     }
+    return;
+  }
+  const size_t kCacheLineSize = 64;
+  size_t stride = max_finger_cnt_ * sizeof(FingerState);
+  stride = (stride + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize;
+  size_t arena_size = stride * size_ + kCacheLineSize - 1;
+  finger_arena_.reset(new char[arena_size]);
+  memset(finger_arena_.get(), 0, arena_size);
+  uintptr_t base = reinterpret_cast<uintptr_t>(finger_arena_.get());
+  base = (base + kCacheLineSize - 1) & ~(kCacheLineSize - 1);
+  for (size_t i = 0; i < size_; i++) {
+    states_[i].fingers = reinterpret_cast<FingerState*>(base + i * stride);
   }
 }
 
 void HardwareStateBuffer::PushState(const HardwareState& state) {
+  HardwareState* next = NextState();
   newest_index_ = (newest_index_ + size_ - 1) % size_;
-  Get(0)->DeepCopy(state, max_finger_cnt_);
+  if (&state == next)
+    return;
+  next->DeepCopy(state, max_finger_cnt_);
 }
 
 void HardwareStateBuffer::PopState() {
@@ -371,7 +483,8 @@ ScrollManager::ScrollManager(PropRegistry* prop_reg)
           prop_reg, "Fling Buffer Suppress Zero Length Scrolls", true),
       fling_buffer_min_avg_speed_(prop_reg,
                                   "Fling Buffer Min Avg Speed",
-                                  10.0) {
+                                  10.0),
+      fling_buffer_weight_decay_(prop_reg, "Fling Buffer Weight Decay", 1.0) {
 }
 
 bool ScrollManager::StationaryFingerPressureChangingSignificantly(
@@ -524,6 +637,7 @@ bool ScrollManager::FillResultScroll(
   }
   if (prev_gesture_type != kGestureTypeScroll || prev_gs_fingers != gs_fingers)
     scroll_buffer->Clear();
+  scroll_buffer->SetWeightDecay(fling_buffer_weight_decay_.val_);
   if (!fling_buffer_suppress_zero_length_scrolls_.val_ ||
       !FloatEq(dx, 0.0) || !FloatEq(dy, 0.0))
     scroll_buffer->Insert(
@@ -542,37 +656,12 @@ size_t ScrollManager::ScrollEventsForFlingCount(
     const ScrollEventBuffer& scroll_buffer) const {
   if (scroll_buffer.Size() <= 1)
     return scroll_buffer.Size();
-  enum Direction { kNone, kUp, kDown, kLeft, kRight };
-  size_t i = 0;
-  Direction prev_direction = kNone;
   size_t fling_buffer_depth = static_cast<size_t>(fling_buffer_depth_.val_);
-  for (; i < scroll_buffer.Size() && i < fling_buffer_depth; i++) {
-    const ScrollEvent& event = scroll_buffer.Get(i);
-    if (FloatEq(event.dx, 0.0) && FloatEq(event.dy, 0.0))
-      break;
-    Direction direction;
-    if (fabsf(event.dx) > fabsf(event.dy))
-      direction = event.dx > 0 ? kRight : kLeft;
-    else
-      direction = event.dy > 0 ? kDown : kUp;
-    if (i > 0 && direction != prev_direction)
-      break;
-    prev_direction = direction;
-  }
-  return i;
+  return std::min(scroll_buffer.SameDirectionCount(), fling_buffer_depth);
 }
 
 void ScrollManager::RegressScrollVelocity(
     const ScrollEventBuffer& scroll_buffer, int count, ScrollEvent* out) const {
-  struct RegressionSums {
-    float tt_;  // Cumulative sum of t^2.
-    float t_;   // Cumulative sum of t.
-    float tx_;  // Cumulative sum of t * x.
-    float ty_;  // Cumulative sum of t * y.
-    float x_;   // Cumulative sum of x.
-    float y_;   // Cumulative sum of y.
-  };
-
   out->dt = 1;
   if (count <= 1) {
     out->dx = 0;
@@ -580,36 +669,23 @@ void ScrollManager::RegressScrollVelocity(
     return;
   }
 
-  RegressionSums sums = {0, 0, 0, 0, 0, 0};
-
-  float time = 0;
-  float x_coord = 0;
-  float y_coord = 0;
-
-  for (int i = count - 1; i >= 0; --i) {
-    const ScrollEvent& event = scroll_buffer.Get(i);
-
-    time += event.dt;
-    x_coord += event.dx;
-    y_coord += event.dy;
-
-    sums.tt_ += time * time;
-    sums.t_ += time;
-    sums.tx_ += time * x_coord;
-    sums.ty_ += time * y_coord;
-    sums.x_ += x_coord;
-    sums.y_ += y_coord;
-  }
+  // The buffer keeps running sums of t, t^2, t * x, etc., where t, x and y
+  // are the cumulative time and position of each event, so the weighted
+  // least squares fit of x(t) and y(t) takes constant time.
+  ScrollRegressionSums sums;
+  scroll_buffer.GetRegressionSums(count, &sums);
 
   // Note the regression determinant only depends on the values of t, and should
   // never be zero so long as (1) count > 1, and (2) dt values are all non-zero.
-  float det = count * sums.tt_ - sums.t_ * sums.t_;
+  // The running sums leave some rounding error in it, so treat tiny values as
+  // zero.
+  double det = sums.w_ * sums.tt_ - sums.t_ * sums.t_;
 
-  if (det) {
-    float det_inv = 1.0 / det;
+  if (det > 1e-12 * sums.w_ * sums.tt_) {
+    double det_inv = 1.0 / det;
 
-    out->dx = (count * sums.tx_ - sums.t_ * sums.x_) * det_inv;
-    out->dy = (count * sums.ty_ - sums.t_ * sums.y_) * det_inv;
+    out->dx = (sums.w_ * sums.tx_ - sums.t_ * sums.x_) * det_inv;
+    out->dy = (sums.w_ * sums.ty_ - sums.t_ * sums.y_) * det_inv;
   } else {
     out->dx = 0;
     out->dy = 0;
@@ -981,13 +1057,21 @@ int FingerButtonClick::EvaluateButtonTypeUsingFigureLocation() {
 ImmediateInterpreter::ImmediateInterpreter(PropRegistry* prop_reg,
                                            Tracer* tracer)
     : Interpreter(NULL, tracer, false),
+      tap_dead_fingers_(&finger_slots_),
+      prev_active_gs_fingers_(&finger_slots_),
+      non_gs_fingers_(&finger_slots_),
+      prev_gs_fingers_(&finger_slots_),
+      prev_tap_gs_fingers_(&finger_slots_),
       button_type_(0),
       finger_button_click_(this),
       sent_button_down_(false),
       button_down_timeout_(0.0),
       started_moving_time_(-1.0),
+      moving_(&finger_slots_),
       gs_changed_time_(-1.0),
       finger_leave_time_(-1.0),
+      pointing_(&finger_slots_),
+      fingers_(&finger_slots_),
       moving_finger_id_(-1),
       tap_to_click_state_(kTtcIdle),
       tap_to_click_state_entered_(-1.0),
@@ -1147,6 +1231,7 @@ void ImmediateInterpreter::SyncInterpretImpl(HardwareState* hwstate,
   }
 
   state_buffer_.PushState(*hwstate);
+  finger_slots_.Update(*hwstate);
 
   FillOriginInfo(*hwstate);
   result_.type = kGestureTypeNull;
@@ -1154,11 +1239,8 @@ void ImmediateInterpreter::SyncInterpretImpl(HardwareState* hwstate,
       (hwstate->buttons_down == state_buffer_.Get(1)->buttons_down);
   if (!same_fingers) {
     // Fingers changed, do nothing this time
-    FingerMap new_gs_fingers;
-    FingerMap gs_fingers = GetGesturingFingers(*hwstate);
-    std::set_difference(gs_fingers.begin(), gs_fingers.end(),
-                        non_gs_fingers_.begin(), non_gs_fingers_.end(),
-                        std::inserter(new_gs_fingers, new_gs_fingers.begin()));
+    FingerMap new_gs_fingers =
+        GetGesturingFingers(*hwstate) - non_gs_fingers_;
     ResetSameFingersState(*hwstate);
     FillStartPositions(*hwstate);
     if (pinch_enable_.val_ &&
@@ -1182,11 +1264,7 @@ void ImmediateInterpreter::SyncInterpretImpl(HardwareState* hwstate,
   UpdateThumbState(*hwstate);
   FingerMap newly_moving_fingers = UpdateMovingFingers(*hwstate);
   UpdateNonGsFingers(*hwstate);
-  FingerMap new_gs_fingers;
   FingerMap gs_fingers = GetGesturingFingers(*hwstate);
-  std::set_difference(gs_fingers.begin(), gs_fingers.end(),
-                      non_gs_fingers_.begin(), non_gs_fingers_.end(),
-                      std::inserter(new_gs_fingers, new_gs_fingers.begin()));
   if (gs_fingers != prev_gs_fingers_)
     gs_changed_time_ = hwstate->timestamp;
   UpdateStartedMovingTime(hwstate->timestamp, gs_fingers, newly_moving_fingers);
@@ -1198,7 +1276,7 @@ void ImmediateInterpreter::SyncInterpretImpl(HardwareState* hwstate,
                    hwstate->timestamp,
                    timeout);
 
-  FingerMap active_gs_fingers;
+  FingerMap active_gs_fingers(&finger_slots_);
   UpdateCurrentGestureType(*hwstate, gs_fingers, &active_gs_fingers);
   GenerateFingerLiftGesture();
   if (result_.type == kGestureTypeNull)
@@ -1215,11 +1293,7 @@ void ImmediateInterpreter::SyncInterpretImpl(HardwareState* hwstate,
   prev_result_ = result_;
   prev_gesture_type_ = current_gesture_type_;
   if (result_.type != kGestureTypeNull) {
-    non_gs_fingers_.clear();
-    std::set_difference(gs_fingers.begin(), gs_fingers.end(),
-                        active_gs_fingers.begin(), active_gs_fingers.end(),
-                        std::inserter(non_gs_fingers_,
-                        non_gs_fingers_.begin()));
+    non_gs_fingers_ = gs_fingers - active_gs_fingers;
     ProduceGesture(result_);
   }
 }
@@ -1230,7 +1304,7 @@ void ImmediateInterpreter::HandleTimerImpl(stime_t now, stime_t* timeout) {
   // don't need to worry about conflicts with these two types of callback.
   UpdateButtonsTimeout(now);
   UpdateTapGesture(NULL,
-                   FingerMap(),
+                   FingerMap(&finger_slots_),
                    false,
                    now,
                    timeout);
@@ -1599,8 +1673,8 @@ void ImmediateInterpreter::UpdateThumbState(const HardwareState& hwstate) {
          fs.pressure > min_pressure * two_finger_pressure_diff_factor_.val_ &&
          fs.position_y > min_fs->position_y);
     bool non_gs = (hwstate.timestamp > changed_time_ &&
-                   (prev_active_gs_fingers_.find(fs.tracking_id) ==
-                    prev_active_gs_fingers_.end()) &&
+                   !SetContainsValue(prev_active_gs_fingers_,
+                                     fs.tracking_id) &&
                    prev_result_.type != kGestureTypeNull);
     non_gs |= moving_finger_id_ >= 0 && moving_finger_id_ != fs.tracking_id;
     likely_thumb |= non_gs;
@@ -1675,11 +1749,7 @@ void ImmediateInterpreter::UpdateThumbState(const HardwareState& hwstate) {
 void ImmediateInterpreter::UpdateNonGsFingers(const HardwareState& hwstate) {
   RemoveMissingIdsFromSet(&non_gs_fingers_, hwstate);
   // moving fingers may be gesturing, so take them out from the set.
-  FingerMap temp;
-  std::set_difference(non_gs_fingers_.begin(), non_gs_fingers_.end(),
-                      moving_.begin(), moving_.end(),
-                      std::inserter(temp, temp.begin()));
-  non_gs_fingers_ = temp;
+  non_gs_fingers_.RemoveAll(moving_);
 }
 
 bool ImmediateInterpreter::KeyboardRecentlyUsed(stime_t now) const {
@@ -1716,7 +1786,7 @@ FingerMap ImmediateInterpreter::GetGesturingFingers(
   // Pull the kMaxSize FingerStates w/ the lowest position_y to the
   // front of fs[].
   GetGesturingFingersCompare compare;
-  FingerMap ret;
+  FingerMap ret(&finger_slots_);
   size_t sorted_cnt;
   if (hwstate.finger_cnt > kMaxGesturingFingers) {
     std::partial_sort(fs, fs + kMaxGesturingFingers, fs + hwstate.finger_cnt,
@@ -2568,7 +2638,7 @@ void ImmediateInterpreter::UpdateTapState(
                                           tap_paused_.val_))
     return;
 
-  FingerMap tap_gs_fingers;
+  FingerMap tap_gs_fingers(&finger_slots_);
 
   if (hwstate)
     RemoveMissingIdsFromSet(&tap_dead_fingers_, *hwstate);
@@ -2590,13 +2660,13 @@ void ImmediateInterpreter::UpdateTapState(
       tap_gs_fingers.insert(*it);
     }
   }
-  std::set<short> added_fingers;
+  FingerMap added_fingers(&finger_slots_);
 
   // Fingers removed from the pad entirely
-  std::set<short> removed_fingers;
+  FingerMap removed_fingers(&finger_slots_);
 
   // Fingers that were gesturing, but now aren't
-  std::set<short> dead_fingers;
+  FingerMap dead_fingers(&finger_slots_);
 
   const bool phys_click_in_progress = hwstate && hwstate->buttons_down != 0 &&
     (zero_finger_click_enable_.val_ || finger_seen_shortly_after_button_down_);
@@ -2635,7 +2705,7 @@ void ImmediateInterpreter::UpdateTapState(
     for (FingerMap::const_iterator it =
              prev_tap_gs_fingers_.begin(), e = prev_tap_gs_fingers_.end();
          it != e; ++it) {
-      if (tap_gs_fingers.find(*it) != tap_gs_fingers.end())
+      if (SetContainsValue(tap_gs_fingers, *it))
         // still gesturing; neither removed nor dead
         continue;
       if (!hwstate->GetFingerState(*it)) {
@@ -2983,7 +3053,7 @@ int ImmediateInterpreter::EvaluateButtonType(
 
 FingerMap ImmediateInterpreter::UpdateMovingFingers(
     const HardwareState& hwstate) {
-  FingerMap newly_moving_fingers;
+  FingerMap newly_moving_fingers(&finger_slots_);
   if (moving_.size() == hwstate.finger_cnt)
     return newly_moving_fingers;  // All fingers already started moving
   const float kMinDistSq =
@@ -3012,18 +3082,17 @@ void ImmediateInterpreter::UpdateStartedMovingTime(
     const FingerMap& gs_fingers,
     const FingerMap& newly_moving_fingers) {
   // Update started moving time if any gesturing finger is newly moving.
-  for (auto it = gs_fingers.begin(), e = gs_fingers.end(); it != e; ++it) {
-    if (SetContainsValue(newly_moving_fingers, *it)) {
-      started_moving_time_ = now;
-      // Extend the thumb evaluation period for any finger that is still under
-      // evaluation as there is a new moving finger.
-      for (std::map<short, stime_t>::iterator it = thumb_.begin();
-           it != thumb_.end(); ++it)
-        if ((*it).second < thumb_eval_timeout_.val_ && (*it).second > 0.0)
-          (*it).second = thumb_eval_timeout_.val_;
-      return;
-    }
-  }
+  FingerMap newly_moving_gs_fingers = gs_fingers;
+  newly_moving_gs_fingers &= newly_moving_fingers;
+  if (newly_moving_gs_fingers.empty())
+    return;
+  started_moving_time_ = now;
+  // Extend the thumb evaluation period for any finger that is still under
+  // evaluation as there is a new moving finger.
+  for (std::map<short, stime_t>::iterator it = thumb_.begin();
+       it != thumb_.end(); ++it)
+    if ((*it).second < thumb_eval_timeout_.val_ && (*it).second > 0.0)
+      (*it).second = thumb_eval_timeout_.val_;
 }
 
 void ImmediateInterpreter::UpdateButtons(const HardwareState& hwstate,
@@ -3397,6 +3466,7 @@ void ImmediateInterpreter::Initialize(const HardwareProperties* hwprops,
   // Zero finger click needs to be disabled for touchpads that
   // integrate their buttons into the pad itself but enabled
   // for any other touchpad in case they have separate buttons.
+  zero_finger_click_enable_.CreateDeferred();
   zero_finger_click_enable_.val_ = !hwprops_->is_button_pad;
 
   is_haptic_pad_ = hwprops_->is_haptic_pad;
@@ -45,6 +45,41 @@ TEST(ImmediateInterpreterTest, HardwareStateBufferTest) {
   EXPECT_EQ(hsb->Size(), 10);
 }
 
+TEST(ImmediateInterpreterTest, HardwareStateBufferPushTest) {
+  HardwareStateBuffer hsb(3);
+  hsb.Reset(2);
+  for (size_t i = 0; i < hsb.Size(); i++) {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(hsb.Get(i)->fingers) % 64);
+  }
+
+  FingerState fs[] = {
+    // TM, Tm, WM, Wm, Press, Orientation, X, Y, TrID
+    {0, 0, 0, 0, 10, 0, 1, 1, 1, 0},
+    {0, 0, 0, 0, 10, 0, 2, 2, 2, 0},
+    {0, 0, 0, 0, 10, 0, 3, 3, 3, 0},
+  };
+  HardwareState hs = make_hwstate(1.0, 0, 3, 3, fs);
+  hsb.PushState(hs);
+  EXPECT_EQ(2, hsb.Get(0)->finger_cnt);  // Truncated to max_finger_cnt.
+  EXPECT_NE(fs, hsb.Get(0)->fingers);
+  EXPECT_EQ(2, hsb.Get(0)->fingers[1].tracking_id);
+
+  // Build the next state in place and push it without a copy.
+  HardwareState* next = hsb.NextState();
+  FingerState* next_fingers = next->fingers;
+  next->timestamp = 2.0;
+  next->finger_cnt = 1;
+  next->fingers[0] = fs[2];
+  hsb.PushState(*next);
+  EXPECT_EQ(next, hsb.Get(0));
+  EXPECT_EQ(next_fingers, hsb.Get(0)->fingers);
+  EXPECT_EQ(3, hsb.Get(0)->fingers[0].tracking_id);
+  EXPECT_EQ(1.0, hsb.Get(1)->timestamp);
+
+  hsb.PopState();
+  EXPECT_EQ(1.0, hsb.Get(0)->timestamp);
+}
+
 TEST(ImmediateInterpreterTest, ScrollManagerTest) {
   PropRegistry* my_prop_reg = new PropRegistry();
   ScrollManager* sm = new ScrollManager(my_prop_reg);
@@ -57,6 +92,89 @@ TEST(ImmediateInterpreterTest, ScrollManagerTest) {
   EXPECT_EQ(1.0, ev.dt);
 }
 
+namespace {
+
+// Weighted least squares slopes of the cumulative position over the newest
+// |count| events, computed directly from the events.
+void SlowRegressScrollVelocity(const ScrollEventBuffer& buf, size_t count,
+                               double decay, double* vx, double* vy) {
+  double w = 0, t = 0, tt = 0, tx = 0, ty = 0, x = 0, y = 0;
+  double time = 0, x_coord = 0, y_coord = 0;
+  for (size_t i = count; i-- > 0;) {
+    const ScrollEvent& event = buf.Get(i);
+    time += event.dt;
+    x_coord += event.dx;
+    y_coord += event.dy;
+    double weight = pow(decay, i);
+    w += weight;
+    t += weight * time;
+    tt += weight * time * time;
+    tx += weight * time * x_coord;
+    ty += weight * time * y_coord;
+    x += weight * x_coord;
+    y += weight * y_coord;
+  }
+  double det = w * tt - t * t;
+  *vx = (w * tx - t * x) / det;
+  *vy = (w * ty - t * y) / det;
+}
+
+}  // namespace {}
+
+TEST(ImmediateInterpreterTest, ScrollEventBufferSumsTest) {
+  PropRegistry prop_reg;
+  ScrollManager sm(&prop_reg);
+  sm.fling_buffer_depth_.val_ = 100;
+  ScrollEventBuffer buf(5);
+
+  for (double decay : {1.0, 0.7}) {
+    buf.Clear();
+    buf.SetWeightDecay(decay);
+    EXPECT_EQ(decay, buf.weight_decay());
+    // Run several times around the buffer so old events get evicted.
+    for (int i = 0; i < 23; i++) {
+      float dy = 1.0 + (i % 3) * 0.5;
+      float dt = 0.01 + (i % 2) * 0.002;
+      buf.Insert(0.1 * (i % 4), dy, dt);
+      for (size_t count = 2; count <= buf.Size(); count++) {
+        double vx, vy;
+        SlowRegressScrollVelocity(buf, count, decay, &vx, &vy);
+        ScrollEvent out;
+        sm.RegressScrollVelocity(buf, count, &out);
+        EXPECT_NEAR(vx, out.dx, 1e-3 * fabs(vx) + 1e-3) << i << " " << count;
+        EXPECT_NEAR(vy, out.dy, 1e-3 * fabs(vy)) << i << " " << count;
+        EXPECT_EQ(1.0, out.dt);
+      }
+    }
+  }
+
+  // GetSpeedSq sums the newest events.
+  buf.Clear();
+  buf.Insert(3.0, 0.0, 0.5);
+  buf.Insert(0.0, 4.0, 0.25);
+  float dist_sq, dt;
+  buf.GetSpeedSq(1, &dist_sq, &dt);
+  EXPECT_FLOAT_EQ(16.0, dist_sq);
+  EXPECT_FLOAT_EQ(0.25, dt);
+  buf.GetSpeedSq(10, &dist_sq, &dt);
+  EXPECT_FLOAT_EQ(25.0, dist_sq);
+  EXPECT_FLOAT_EQ(0.75, dt);
+
+  // The fling only uses the newest run of events in the same direction.
+  buf.Clear();
+  buf.Insert(0.0, -1.0, 0.01);
+  buf.Insert(0.0, 1.0, 0.01);
+  buf.Insert(0.0, 2.0, 0.01);
+  EXPECT_EQ(2, sm.ScrollEventsForFlingCount(buf));
+  buf.Insert(0.0, 0.0, 0.01);
+  EXPECT_EQ(0, sm.ScrollEventsForFlingCount(buf));
+  for (int i = 0; i < 7; i++)
+    buf.Insert(1.0, 0.0, 0.01);
+  EXPECT_EQ(5, sm.ScrollEventsForFlingCount(buf));
+  sm.fling_buffer_depth_.val_ = 3;
+  EXPECT_EQ(3, sm.ScrollEventsForFlingCount(buf));
+}
+
 TEST(ImmediateInterpreterTest, MoveDownTest) {
   ImmediateInterpreter ii(NULL, NULL);
 
@@ -1552,6 +1670,8 @@ TEST(ImmediateInterpreterTest, GetGesturingFingersTest) {
     make_hwstate(200002, 0, 3, 3, &finger_states[0]),
     make_hwstate(200002, 0, 4, 4, &finger_states[0]),
   };
+  ii.finger_slots_.Update(hardware_state[4]);
+
   // few pointing fingers
   ii.ResetSameFingersState(hardware_state[0]);
   ii.UpdatePointingFingers(hardware_state[0]);
@@ -1559,8 +1679,7 @@ TEST(ImmediateInterpreterTest, GetGesturingFingersTest) {
 
   ii.ResetSameFingersState(hardware_state[0]);
   ii.UpdatePointingFingers(hardware_state[1]);
-  std::set<short> ids =
-      ii.GetGesturingFingers(hardware_state[1]);
+  FingerMap ids = ii.GetGesturingFingers(hardware_state[1]);
   EXPECT_EQ(1, ids.size());
   EXPECT_TRUE(ids.end() != ids.find(91));
 
@@ -1621,6 +1740,14 @@ std::set<short> MkSet(short id1, short id2, short id3) {
   ret.insert(id3);
   return ret;
 }
+// The ids must already have slots in |slots|.
+FingerMap MkFingerMap(const FingerSlotTable* slots,
+                      const std::set<short>& ids) {
+  FingerMap ret(slots);
+  for (short id : ids)
+    ret.insert(id);
+  return ret;
+}
 }  // namespace{}
 
 TEST(ImmediateInterpreterTest, TapRecordTest) {
@@ -1656,39 +1783,43 @@ TEST(ImmediateInterpreterTest, TapRecordTest) {
                                                     origin_timestamps_[kF1] = 0;
   const_cast<ImmediateInterpreter*>(tr.immediate_interpreter_)->
                                                     origin_timestamps_[kF2] = 0;
-  tr.Update(hw[0], nullstate, MkSet(kF1), MkSet(), MkSet());
+  ii.finger_slots_.Update(hw[1]);
+  auto ids = [&ii](const std::set<short>& id_set) {
+    return MkFingerMap(&ii.finger_slots_, id_set);
+  };
+  tr.Update(hw[0], nullstate, ids(MkSet(kF1)), ids(MkSet()), ids(MkSet()));
   EXPECT_FALSE(tr.Moving(hw[0], kTapMoveDist));
   EXPECT_FALSE(tr.TapComplete());
-  tr.Update(hw[1], hw[0], MkSet(), MkSet(), MkSet());
+  tr.Update(hw[1], hw[0], ids(MkSet()), ids(MkSet()), ids(MkSet()));
   EXPECT_FALSE(tr.Moving(hw[1], kTapMoveDist));
   EXPECT_FALSE(tr.TapComplete());
-  tr.Update(hw[2], hw[1], MkSet(), MkSet(kF1), MkSet());
+  tr.Update(hw[2], hw[1], ids(MkSet()), ids(MkSet(kF1)), ids(MkSet()));
   EXPECT_FALSE(tr.Moving(hw[2], kTapMoveDist));
   EXPECT_TRUE(tr.TapComplete());
   EXPECT_EQ(GESTURES_BUTTON_LEFT, tr.TapType());
 
   tr.Clear();
   EXPECT_FALSE(tr.TapComplete());
-  tr.Update(hw[2], hw[1], MkSet(kF2), MkSet(), MkSet());
+  tr.Update(hw[2], hw[1], ids(MkSet(kF2)), ids(MkSet()), ids(MkSet()));
   EXPECT_FALSE(tr.Moving(hw[2], kTapMoveDist));
   EXPECT_FALSE(tr.TapComplete());
-  tr.Update(hw[3], hw[2], MkSet(kF1), MkSet(), MkSet(kF2));
+  tr.Update(hw[3], hw[2], ids(MkSet(kF1)), ids(MkSet()), ids(MkSet(kF2)));
   EXPECT_FALSE(tr.Moving(hw[3], kTapMoveDist));
   EXPECT_FALSE(tr.TapComplete());
-  tr.Update(hw[4], hw[3], MkSet(), MkSet(kF1), MkSet());
+  tr.Update(hw[4], hw[3], ids(MkSet()), ids(MkSet(kF1)), ids(MkSet()));
   EXPECT_FALSE(tr.Moving(hw[4], kTapMoveDist));
   EXPECT_TRUE(tr.TapComplete());
 
   tr.Clear();
   EXPECT_FALSE(tr.TapComplete());
-  tr.Update(hw[0], nullstate, MkSet(kF1), MkSet(), MkSet());
-  tr.Update(hw[5], hw[4], MkSet(), MkSet(), MkSet());
+  tr.Update(hw[0], nullstate, ids(MkSet(kF1)), ids(MkSet()), ids(MkSet()));
+  tr.Update(hw[5], hw[4], ids(MkSet()), ids(MkSet()), ids(MkSet()));
   EXPECT_TRUE(tr.Moving(hw[5], kTapMoveDist));
   EXPECT_FALSE(tr.TapComplete());
 
   // This should log an error
   tr.Clear();
-  tr.Update(hw[2], hw[1], MkSet(), MkSet(kF1), MkSet());
+  tr.Update(hw[2], hw[1], ids(MkSet()), ids(MkSet(kF1)), ids(MkSet()));
 }
 
 namespace {
@@ -2173,13 +2304,15 @@ TEST(ImmediateInterpreterTest, TapToClickStateMachineTest) {
       same_fingers = ii->state_buffer_.Get(1)->SameFingersAs(hwsgs_full[i].hws);
     }
 
-    if (hwstate)
+    if (hwstate) {
       ii->state_buffer_.PushState(*hwstate);
+      ii->finger_slots_.Update(*hwstate);
+    }
     for (auto finger: hwsgs_full[i].gs)
       ii->origin_timestamps_.emplace(finger, 0);
-    ii->UpdateTapState(
-        hwstate, hwsgs_full[i].gs, same_fingers, now, &bdown, &bup, &tm);
-    ii->prev_gs_fingers_ = hwsgs_full[i].gs;
+    FingerMap gs = MkFingerMap(&ii->finger_slots_, hwsgs_full[i].gs);
+    ii->UpdateTapState(hwstate, gs, same_fingers, now, &bdown, &bup, &tm);
+    ii->prev_gs_fingers_ = gs;
     EXPECT_EQ(hwsgs_full[i].expected_down, bdown) << desc;
     EXPECT_EQ(hwsgs_full[i].expected_up, bup) << desc;
     if (hwsgs_full[i].timeout)
@@ -2353,8 +2486,10 @@ TEST(ImmediateInterpreterTest, TapToClickKeyboardTest) {
       down = 0;
       up = 0;
       stime_t timeout = NO_DEADLINE;
-      std::set<short> gs =
-          hwstates[i].finger_cnt == 1 ? MkSet(91) : MkSet();
+      ii->finger_slots_.Update(hwstates[i]);
+      FingerMap gs = MkFingerMap(
+          &ii->finger_slots_,
+          hwstates[i].finger_cnt == 1 ? MkSet(91) : MkSet());
       for (auto finger: gs)
         ii->origin_timestamps_.emplace(finger, 0);
       ii->UpdateTapState(
@@ -2493,16 +2628,18 @@ TEST(ImmediateInterpreterTest, TapToClickEnableTest) {
       if (hwstate && hwstate->timestamp == pause_time)
         ii->tap_paused_.val_ = true;
 
-      if (hwstate)
+      if (hwstate) {
         ii->state_buffer_.PushState(*hwstate);
+        ii->finger_slots_.Update(*hwstate);
+      }
       unsigned bdown = 0;
       unsigned bup = 0;
       stime_t tm = NO_DEADLINE;
       for (auto finger: hwsgs.gs)
         ii->origin_timestamps_.emplace(finger, 0);
-      ii->UpdateTapState(
-          hwstate, hwsgs.gs, same_fingers, now, &bdown, &bup, &tm);
-      ii->prev_gs_fingers_ = hwsgs.gs;
+      FingerMap gs = MkFingerMap(&ii->finger_slots_, hwsgs.gs);
+      ii->UpdateTapState(hwstate, gs, same_fingers, now, &bdown, &bup, &tm);
+      ii->prev_gs_fingers_ = gs;
 
       switch (iter) {
         case 0:  // tap should be enabled
@@ -5,6 +5,8 @@
 #include "include/interpreter.h"
 
 #include <cxxabi.h>
+#include <algorithm>
+#include <chrono>
 #include <string>
 
 #include <json/value.h>
@@ -20,6 +22,45 @@ using std::string;
 
 namespace gestures {
 
+namespace {
+
+// Time spent so far in the interpreters called by the current one, so each
+// interpreter's stats only count its own work.
+thread_local uint64_t nested_ns = 0;
+
+uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Adds the time from construction to destruction, minus the time of nested
+// StageTimers, to |total_ns| and |max_ns|.
+class StageTimer {
+ public:
+  StageTimer(uint64_t* total_ns, uint64_t* max_ns)
+      : total_ns_(total_ns),
+        max_ns_(max_ns),
+        outer_nested_ns_(nested_ns),
+        start_ns_(NowNs()) {
+    nested_ns = 0;
+  }
+  ~StageTimer() {
+    uint64_t elapsed = NowNs() - start_ns_;
+    uint64_t own = elapsed - std::min(elapsed, nested_ns);
+    *total_ns_ += own;
+    *max_ns_ = std::max(*max_ns_, own);
+    nested_ns = outer_nested_ns_ + elapsed;
+  }
+
+ private:
+  uint64_t* total_ns_;
+  uint64_t* max_ns_;
+  uint64_t outer_nested_ns_;
+  uint64_t start_ns_;
+};
+
+}  // namespace {}
+
 Interpreter::Interpreter(PropRegistry* prop_reg,
                          Tracer* tracer,
                          bool force_log_creation)
@@ -58,8 +99,14 @@ void Interpreter::SyncInterpret(HardwareState* hwstate,
     own_metrics_->Update(*hwstate);
 
   Trace("SyncInterpret: start: ", name());
-  SyncInterpretImpl(hwstate, timeout);
+  {
+    StageTimer timer(&stats_.sync_ns, &stats_.sync_max_ns);
+    SyncInterpretImpl(hwstate, timeout);
+  }
   Trace("SyncInterpret: end: ", name());
+  stats_.sync_calls++;
+  if (timeout && *timeout >= 0.0)
+    stats_.timer_requests++;
   LogOutputs(NULL, timeout, "SyncLogOutputs");
 }
 
@@ -71,17 +118,30 @@ void Interpreter::HandleTimer(stime_t now, stime_t* timeout) {
     Trace("log: end: ", "LogTimerCallback");
   }
   Trace("HandleTimer: start: ", name());
-  HandleTimerImpl(now, timeout);
+  {
+    StageTimer timer(&stats_.timer_ns, &stats_.timer_max_ns);
+    HandleTimerImpl(now, timeout);
+  }
   Trace("HandleTimer: end: ", name());
+  stats_.timer_calls++;
+  if (timeout && *timeout >= 0.0)
+    stats_.timer_requests++;
   LogOutputs(NULL, timeout, "TimerLogOutputs");
 }
 
 void Interpreter::ProduceGesture(const Gesture& gesture) {
   AssertWithReturn(initialized_);
   LogOutputs(&gesture, NULL, "ProduceGesture");
+  stats_.gestures_produced++;
   consumer_->ConsumeGesture(gesture);
 }
 
+void Interpreter::CollectStageStats(
+    std::vector<GestureStageStats>* out) const {
+  out->push_back(stats_);
+  out->back().name = name();
+}
+
 void Interpreter::Initialize(const HardwareProperties* hwprops,
                              Metrics* metrics,
                              MetricsProperties* mprops,
@@ -119,6 +179,37 @@ std::string Interpreter::Encode() {
   return out;
 }
 
+Json::Value Interpreter::EncodeStageStats() const {
+  std::vector<GestureStageStats> stats;
+  CollectStageStats(&stats);
+  Json::Value ret(Json::arrayValue);
+  for (const GestureStageStats& stage : stats) {
+    Json::Value entry(Json::objectValue);
+    entry[ActivityLog::kKeyInterpreterName] =
+        Json::Value(stage.name ? stage.name : "");
+    entry[ActivityLog::kKeyStageStatsSyncCalls] =
+        Json::Value(static_cast<Json::UInt64>(stage.sync_calls));
+    entry[ActivityLog::kKeyStageStatsSyncNs] =
+        Json::Value(static_cast<Json::UInt64>(stage.sync_ns));
+    entry[ActivityLog::kKeyStageStatsSyncMaxNs] =
+        Json::Value(static_cast<Json::UInt64>(stage.sync_max_ns));
+    entry[ActivityLog::kKeyStageStatsTimerCalls] =
+        Json::Value(static_cast<Json::UInt64>(stage.timer_calls));
+    entry[ActivityLog::kKeyStageStatsTimerNs] =
+        Json::Value(static_cast<Json::UInt64>(stage.timer_ns));
+    entry[ActivityLog::kKeyStageStatsTimerMaxNs] =
+        Json::Value(static_cast<Json::UInt64>(stage.timer_max_ns));
+    entry[ActivityLog::kKeyStageStatsTimerRequests] =
+        Json::Value(static_cast<Json::UInt64>(stage.timer_requests));
+    entry[ActivityLog::kKeyStageStatsGesturesConsumed] =
+        Json::Value(static_cast<Json::UInt64>(stage.gestures_consumed));
+    entry[ActivityLog::kKeyStageStatsGesturesProduced] =
+        Json::Value(static_cast<Json::UInt64>(stage.gestures_produced));
+    ret.append(entry);
+  }
+  return ret;
+}
+
 void Interpreter::InitName() {
   if (!name_) {
     int status;
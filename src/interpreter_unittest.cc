@@ -7,6 +7,7 @@
 #include <gtest/gtest.h>
 
 #include "include/activity_replay.h"
+#include "include/filter_interpreter.h"
 #include "include/gestures.h"
 #include "include/interpreter.h"
 #include "include/prop_registry.h"
@@ -208,4 +209,50 @@ TEST(InterpreterTest, LoggingDisabledByDefault) {
   wrapper.SyncInterpret(&hardware_state, &timeout);
   EXPECT_EQ(base_interpreter->log_->size(), 0);
 }
+
+class StageStatsTestInterpreter : public Interpreter {
+ public:
+  StageStatsTestInterpreter() : Interpreter(NULL, NULL, false) {
+    InitName();
+  }
+ protected:
+  virtual void SyncInterpretImpl(HardwareState* hwstate, stime_t* timeout) {
+    ProduceGesture(Gesture(kGestureMove, 0, hwstate->timestamp, 1, 0));
+    *timeout = 0.01;
+  }
+
+  virtual void HandleTimerImpl(stime_t now, stime_t* timeout) {}
+};
+
+TEST(InterpreterTest, StageStatsTest) {
+  StageStatsTestInterpreter* base_interpreter =
+      new StageStatsTestInterpreter();
+  FilterInterpreter* filter =
+      new FilterInterpreter(NULL, base_interpreter, NULL, false);
+  TestInterpreterWrapper wrapper(filter);
+
+  HardwareState hardware_state = make_hwstate(200000, 0, 0, 0, NULL);
+  for (int i = 0; i < 3; i++) {
+    stime_t timeout = NO_DEADLINE;
+    wrapper.SyncInterpret(&hardware_state, &timeout);
+  }
+  stime_t timeout = NO_DEADLINE;
+  wrapper.HandleTimer(200000.01, &timeout);
+
+  std::vector<GestureStageStats> stats;
+  filter->CollectStageStats(&stats);
+  ASSERT_EQ(2, stats.size());
+  EXPECT_STREQ("StageStatsTestInterpreter", stats[1].name);
+  for (const GestureStageStats& stage : stats) {
+    EXPECT_EQ(3, stage.sync_calls);
+    EXPECT_EQ(1, stage.timer_calls);
+    EXPECT_EQ(3, stage.timer_requests);
+    EXPECT_EQ(3, stage.gestures_produced);
+    EXPECT_LE(stage.sync_max_ns, stage.sync_ns);
+    EXPECT_LE(stage.timer_max_ns, stage.timer_ns);
+  }
+  EXPECT_EQ(3, stats[0].gestures_consumed);
+  EXPECT_EQ(0, stats[1].gestures_consumed);
+}
+
 }  // namespace gestures
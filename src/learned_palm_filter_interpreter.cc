@@ -0,0 +1,42 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "include/learned_palm_filter_interpreter.h"
+
+namespace gestures {
+
+LearnedPalmFilterInterpreter::LearnedPalmFilterInterpreter(
+    PropRegistry* prop_reg, Interpreter* next, Tracer* tracer)
+    : FilterInterpreter(NULL, next, tracer, false),
+      model_(&kDefaultPalmModel),
+      enabled_(prop_reg, "Learned Palm Enable", false),
+      palm_threshold_(prop_reg, "Learned Palm Threshold", 1.0),
+      possible_palm_threshold_(prop_reg, "Learned Possible Palm Threshold",
+                               0.5) {
+  InitName();
+}
+
+void LearnedPalmFilterInterpreter::SyncInterpretImpl(HardwareState* hwstate,
+                                                     stime_t* timeout) {
+  if (!enabled_.val_) {
+    features_.Clear();
+    next_->SyncInterpret(hwstate, timeout);
+    return;
+  }
+  features_.Update(*hwstate);
+  for (size_t i = 0; i < hwstate->finger_cnt; i++) {
+    float features[kPalmFeatureCount];
+    if (!features_.Features(*hwprops_, *hwstate, i, features))
+      continue;
+    float score = EvaluatePalmModel(*model_, features);
+    FingerState* fs = &hwstate->fingers[i];
+    if (score >= palm_threshold_.val_)
+      fs->flags |= GESTURES_FINGER_PALM;
+    else if (score >= possible_palm_threshold_.val_)
+      fs->flags |= GESTURES_FINGER_POSSIBLE_PALM;
+  }
+  next_->SyncInterpret(hwstate, timeout);
+}
+
+}  // namespace gestures
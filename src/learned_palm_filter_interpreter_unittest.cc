@@ -0,0 +1,193 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+#include "include/gestures.h"
+#include "include/learned_palm_filter_interpreter.h"
+#include "include/palm_model.h"
+#include "include/unittest_util.h"
+
+namespace gestures {
+
+class LearnedPalmFilterInterpreterTest : public ::testing::Test {};
+
+class LearnedPalmFilterInterpreterTestInterpreter : public Interpreter {
+ public:
+  LearnedPalmFilterInterpreterTestInterpreter()
+      : Interpreter(NULL, NULL, false), flags_(0) {}
+
+  virtual void SyncInterpret(HardwareState* hwstate, stime_t* timeout) {
+    flags_ = hwstate->finger_cnt ? hwstate->fingers[0].flags : 0;
+  }
+
+  unsigned flags_;
+};
+
+namespace {
+
+const unsigned kPalmFlags =
+    GESTURES_FINGER_PALM | GESTURES_FINGER_POSSIBLE_PALM;
+
+// Sends |frames| 100 Hz reports of one contact moving from (x, y) by
+// (dx, dy) mm per report, and returns the flags of the last one.
+unsigned RunContact(TestInterpreterWrapper* wrapper,
+                    LearnedPalmFilterInterpreterTestInterpreter* base,
+                    stime_t start, short id, float x, float y, float dx,
+                    float dy, float pressure, float touch_major,
+                    size_t frames) {
+  for (size_t i = 0; i < frames; i++) {
+    FingerState fs = {
+      touch_major, touch_major * 0.8f, 0, 0, pressure, 0,
+      x + dx * i, y + dy * i, id, 0
+    };
+    HardwareState hs = make_hwstate(start + 0.01 * i, 0, 1, 1, &fs);
+    wrapper->SyncInterpret(&hs, NULL);
+  }
+  return base->flags_;
+}
+
+}  // namespace {}
+
+TEST(LearnedPalmFilterInterpreterTest, QuantizeTest) {
+  PalmModelWeights weights;
+  memset(&weights, 0, sizeof(weights));
+  for (size_t i = 0; i < kPalmFeatureCount; i++) {
+    weights.input_offset[i] = 10.0;
+    weights.input_scale[i] = 2.0;
+  }
+  float features[kPalmFeatureCount] = { 0.0 };
+  features[0] = 12.0;
+  features[1] = 9.0;
+  features[2] = 1000.0;
+  features[3] = -1000.0;
+  features[4] = 10.2;
+  int8_t q[kPalmFeatureCount];
+  QuantizePalmFeatures(weights, features, q);
+  EXPECT_EQ(4, q[0]);
+  EXPECT_EQ(-2, q[1]);
+  EXPECT_EQ(127, q[2]);  // saturated
+  EXPECT_EQ(-127, q[3]);
+  EXPECT_EQ(0, q[4]);
+  EXPECT_EQ(-20, q[5]);
+
+  // One hidden unit that passes the first feature, shifted down by one, and
+  // one that is always off.
+  weights.hidden_weights[0][0] = 3;
+  weights.hidden_bias[0] = 1;
+  weights.hidden_weights[1][0] = -1;
+  weights.hidden_shift = 1;
+  weights.output_weights[0] = 2;
+  weights.output_weights[1] = 100;
+  weights.output_bias = -3;
+  weights.output_scale = 0.5;
+  // h0 = (3 * 4 + 1) >> 1 = 6, h1 = max(0, -4) = 0.
+  EXPECT_FLOAT_EQ((2 * 6 - 3) * 0.5, ScorePalmFeatures(weights, q));
+  EXPECT_FLOAT_EQ(ScorePalmFeatures(weights, q),
+                  EvaluatePalmModel(weights, features));
+}
+
+TEST(LearnedPalmFilterInterpreterTest, PressureTest) {
+  LearnedPalmFilterInterpreterTestInterpreter* base =
+      new LearnedPalmFilterInterpreterTestInterpreter;
+  LearnedPalmFilterInterpreter interpreter(NULL, base, NULL);
+  HardwareProperties hwprops = {
+    0, 0, 100, 60,  // left, top, right, bottom
+    1, 1,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch,
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TestInterpreterWrapper wrapper(&interpreter, &hwprops);
+  interpreter.enabled_.val_ = true;
+
+  // A finger moving across the middle of the pad.
+  EXPECT_EQ(0, RunContact(&wrapper, base, 1.0, 1, 30, 30, 0.5, 0.0, 60.0,
+                          8.0, 20));
+  // A contact pressing too hard for a finger, even once it lightens.
+  EXPECT_EQ(GESTURES_FINGER_PALM,
+            RunContact(&wrapper, base, 2.0, 2, 30, 30, 0.5, 0.0, 220.0,
+                       8.0, 5) & kPalmFlags);
+  FingerState light = { 8.0, 6.4, 0, 0, 60.0, 0, 33.0, 30.0, 2, 0 };
+  HardwareState hs = make_hwstate(2.05, 0, 1, 1, &light);
+  wrapper.SyncInterpret(&hs, NULL);
+  EXPECT_EQ(GESTURES_FINGER_PALM, base->flags_ & kPalmFlags);
+  // A contact too wide for a finger.
+  EXPECT_EQ(GESTURES_FINGER_PALM,
+            RunContact(&wrapper, base, 3.0, 3, 30, 30, 0.0, 0.0, 60.0,
+                       25.0, 5) & kPalmFlags);
+}
+
+TEST(LearnedPalmFilterInterpreterTest, EdgeTest) {
+  LearnedPalmFilterInterpreterTestInterpreter* base =
+      new LearnedPalmFilterInterpreterTestInterpreter;
+  LearnedPalmFilterInterpreter interpreter(NULL, base, NULL);
+  HardwareProperties hwprops = {
+    0, 0, 100, 60,  // left, top, right, bottom
+    1, 1,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch,
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TestInterpreterWrapper wrapper(&interpreter, &hwprops);
+  interpreter.enabled_.val_ = true;
+
+  // Resting on the bottom edge, and on a side edge.
+  EXPECT_EQ(GESTURES_FINGER_POSSIBLE_PALM,
+            RunContact(&wrapper, base, 1.0, 1, 50, 59.5, 0.0, 0.0, 60.0,
+                       8.0, 10));
+  EXPECT_EQ(GESTURES_FINGER_POSSIBLE_PALM,
+            RunContact(&wrapper, base, 2.0, 2, 0.5, 30, 0.0, 0.0, 60.0,
+                       8.0, 10));
+  // Moving along the bottom edge is not resting on it.
+  EXPECT_EQ(0, RunContact(&wrapper, base, 3.0, 3, 20, 59.5, 0.5, 0.0, 60.0,
+                          8.0, 10));
+  // Neither is being a few mm away from it.
+  EXPECT_EQ(0, RunContact(&wrapper, base, 4.0, 4, 50, 55.0, 0.0, 0.0, 60.0,
+                          8.0, 10));
+}
+
+TEST(LearnedPalmFilterInterpreterTest, DisabledTest) {
+  LearnedPalmFilterInterpreterTestInterpreter* base =
+      new LearnedPalmFilterInterpreterTestInterpreter;
+  LearnedPalmFilterInterpreter interpreter(NULL, base, NULL);
+  HardwareProperties hwprops = {
+    0, 0, 100, 60,  // left, top, right, bottom
+    1, 1,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch,
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TestInterpreterWrapper wrapper(&interpreter, &hwprops);
+
+  EXPECT_EQ(0, RunContact(&wrapper, base, 1.0, 1, 30, 30, 0.0, 0.0, 250.0,
+                          30.0, 5));
+  // Turning it on mid-contact treats the contact as new, and a later model
+  // replaces the default one.
+  interpreter.enabled_.val_ = true;
+  EXPECT_EQ(GESTURES_FINGER_PALM,
+            RunContact(&wrapper, base, 1.05, 1, 30, 30, 0.0, 0.0, 250.0,
+                       30.0, 1));
+  PalmModelWeights never_palm;
+  memset(&never_palm, 0, sizeof(never_palm));
+  interpreter.SetModel(&never_palm);
+  EXPECT_EQ(0, RunContact(&wrapper, base, 1.06, 1, 30, 30, 0.0, 0.0, 250.0,
+                          30.0, 1));
+}
+
+}  // namespace gestures
@@ -47,6 +47,12 @@ void LoggingFilterInterpreter::BoolWasWritten(BoolProperty* prop) {
   }
 }
 
+Json::Value LoggingFilterInterpreter::EncodeCommonInfo() {
+  Json::Value root = FilterInterpreter::EncodeCommonInfo();
+  root[ActivityLog::kKeyStageStats] = EncodeStageStats();
+  return root;
+}
+
 std::string LoggingFilterInterpreter::EncodeActivityLog() {
   return Encode();
 }
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <math.h>
+#include <string.h>
 
 #include "include/tracer.h"
 #include "include/util.h"
@@ -17,6 +18,15 @@ namespace gestures {
 
 namespace {
 static const stime_t kMaxDelay = 0.09;  // 90ms
+// Gaps between reports longer than this are pauses in reporting, and aren't
+// used to estimate the report interval.
+static const stime_t kMaxReportInterval = 0.05;
+// Weight of each new report in the interval estimate.
+static const double kIntervalWeight = 1.0 / 16;
+// Reports needed before the adaptive delay is used.
+static const size_t kMinIntervalSamples = 16;
+// Consecutive steady single finger states needed before bypassing the queue.
+static const size_t kMinSteadyFrames = 3;
 }
 
 LookaheadFilterInterpreter::LookaheadFilterInterpreter(
@@ -39,19 +49,28 @@ LookaheadFilterInterpreter::LookaheadFilterInterpreter(
       co_move_ratio_(prop_reg, "Drumroll Co Move Ratio", 1.2),
       suppress_immediate_tapdown_(prop_reg, "Suppress Immediate Tapdown", true),
       delay_on_possible_liftoff_(prop_reg, "Delay On Possible Liftoff", false),
-      liftoff_speed_increase_threshold_(prop_reg, "Liftoff Speed Factor", 5.0) {
+      liftoff_speed_increase_threshold_(prop_reg, "Liftoff Speed Factor", 5.0),
+      adaptive_delay_enable_(prop_reg, "Input Queue Adaptive Delay Enable",
+                             false),
+      adaptive_delay_jitter_factor_(prop_reg,
+                                    "Input Queue Adaptive Delay Jitter Factor",
+                                    3.0),
+      current_delay_(prop_reg, "Input Queue Current Delay", 0.0),
+      single_finger_bypass_(prop_reg, "Input Queue Single Finger Bypass",
+                            false) {
   InitName();
 }
 
 void LookaheadFilterInterpreter::SyncInterpretImpl(HardwareState* hwstate,
                                                        stime_t* timeout) {
+  UpdateReportInterval(hwstate->timestamp);
+  current_delay_.val_ = Delay();
   // Keep track of where the last node is in the current queue_
   auto const queue_was_not_empty = !queue_.empty();
   QState* old_back_node = queue_was_not_empty ? &queue_.back() : nullptr;
   // Allocate and initialize a new node on the end of the queue_
-  auto& new_node = queue_.emplace_back(hwprops_->max_finger_cnt);
-  new_node.set_state(*hwstate);
-  double delay = max(0.0, min<stime_t>(kMaxDelay, min_delay_.val_));
+  auto& new_node = *NewNode(queue_.end(), hwstate);
+  double delay = max(0.0, min<stime_t>(kMaxDelay, Delay()));
   new_node.due_ = hwstate->timestamp + delay;
   if (queue_was_not_empty)
     new_node.output_ids_ = old_back_node->output_ids_;
@@ -66,13 +85,22 @@ void LookaheadFilterInterpreter::SyncInterpretImpl(HardwareState* hwstate,
       if (!(*q_node_iter).completed_)
         next_->SyncInterpret(&(*q_node_iter).state_, &next_timeout);
       ++q_node_iter;
-      queue_.pop_front();
+      RecycleFront();
     } while (queue_.size() > 1);
     interpreter_due_ = -1.0;
     last_interpreted_time_ = -1.0;
   }
-  AssignTrackingIds();
+  bool may_need_correction = AssignTrackingIds();
+  bool bypass = single_finger_bypass_.val_ &&
+      SteadyPointing(may_need_correction);
   AttemptInterpolation();
+  if (bypass) {
+    // Everything still queued is older than this state, so passing it all
+    // on now keeps timestamps in order.
+    for (auto& elem : queue_)
+      if (!elem.completed_)
+        elem.due_ = hwstate->timestamp;
+  }
   UpdateInterpreterDue(interpreter_due_ < 0.0 ?
                        interpreter_due_ : interpreter_due_ + hwstate->timestamp,
                        hwstate->timestamp, timeout);
@@ -119,7 +147,7 @@ void LookaheadFilterInterpreter::Interpolate(const HardwareState& first,
   out->rel_hwheel = 0;
 }
 
-void LookaheadFilterInterpreter::AssignTrackingIds() {
+bool LookaheadFilterInterpreter::AssignTrackingIds() {
   // For semi-mt devices, drumrolls and quick moves are handled in
   // SemiMtCorrectingFilterInterpreter already. We need to bypass the detection
   // and tracking id reassignment here to make fast-scroll working correctly.
@@ -128,7 +156,7 @@ void LookaheadFilterInterpreter::AssignTrackingIds() {
   if (hwprops_->support_semi_mt ||
       hwprops_->is_haptic_pad ||
       !drumroll_suppression_enable_.val_) {
-    return;
+    return false;
   }
   if (queue_.size() < 2) {
     // Always reassign trackingID on the very first hwstate so that
@@ -141,10 +169,12 @@ void LookaheadFilterInterpreter::AssignTrackingIds() {
         tail.output_ids_[fs->tracking_id] = NextTrackingId();
         fs->tracking_id = tail.output_ids_[fs->tracking_id];
       }
-      if (hs->finger_cnt > 0)
+      if (hs->finger_cnt > 0) {
         tail.due_ += ExtraVariableDelay();
+        return true;
+      }
     }
-    return;
+    return false;
   }
 
   auto& tail = queue_.at(-1);
@@ -308,7 +338,28 @@ void LookaheadFilterInterpreter::AssignTrackingIds() {
     // Possibly add some extra delay to correct, incase this separation
     // shouldn't have occurred or if the finger may be lifting from the pad.
     tail.due_ += ExtraVariableDelay();
+    return true;
+  }
+  return false;
+}
+
+bool LookaheadFilterInterpreter::SteadyPointing(bool may_need_correction) {
+  if (queue_.size() < 3 || may_need_correction) {
+    steady_frames_ = 0;
+    return false;
   }
+  const HardwareState& hs = queue_.at(-1).state_;
+  const HardwareState& prev_hs = queue_.at(-2).state_;
+  const HardwareState& prev2_hs = queue_.at(-3).state_;
+  if (hs.finger_cnt != 1 || hs.touch_cnt != 1 ||
+      !hs.SameFingersAs(prev_hs) || !prev_hs.SameFingersAs(prev2_hs) ||
+      hs.buttons_down != prev_hs.buttons_down ||
+      LiftoffJumpStarting(hs, prev_hs, prev2_hs)) {
+    steady_frames_ = 0;
+    return false;
+  }
+  steady_frames_++;
+  return steady_frames_ >= kMinSteadyFrames;
 }
 
 bool LookaheadFilterInterpreter::LiftoffJumpStarting(
@@ -396,18 +447,15 @@ void LookaheadFilterInterpreter::AttemptInterpolation() {
   }
   if (!prev.state_.SameFingersAs(new_node.state_))
     return;
-  auto node = QState(hwprops_->max_finger_cnt);
-  node.state_.fingers = node.fs_.get();
-  node.completed_ = false;
-  Interpolate(prev.state_, new_node.state_, &node.state_);
-
-  double delay = max(0.0, min<stime_t>(kMaxDelay, min_delay_.val_));
-  node.due_ = node.state_.timestamp + delay;
-
   // Make sure time seems monotonically increasing w/ this new event
-  if (node.state_.timestamp > last_interpreted_time_) {
-    queue_.insert(--queue_.end(), std::move(node));
-  }
+  stime_t timestamp = (prev.state_.timestamp + new_node.state_.timestamp) / 2.0;
+  if (timestamp <= last_interpreted_time_)
+    return;
+  QState* node = NewNode(--queue_.end(), NULL);
+  Interpolate(prev.state_, new_node.state_, &node->state_);
+
+  double delay = max(0.0, min<stime_t>(kMaxDelay, Delay()));
+  node->due_ = node->state_.timestamp + delay;
 }
 
 void LookaheadFilterInterpreter::HandleTimerImpl(stime_t now,
@@ -441,9 +489,6 @@ void LookaheadFilterInterpreter::HandleTimerImpl(stime_t now,
       last_interpreted_time_ = node->state_.timestamp;
       const size_t finger_cnt = node->state_.finger_cnt;
       FingerState fs_copy[std::max(finger_cnt,(size_t)1)];
-      std::copy(&node->state_.fingers[0],
-                &node->state_.fingers[finger_cnt],
-                &fs_copy[0]);
       HardwareState hs_copy = {
         node->state_.timestamp,
         node->state_.buttons_down,
@@ -457,11 +502,22 @@ void LookaheadFilterInterpreter::HandleTimerImpl(stime_t now,
         node->state_.rel_hwheel,
         node->state_.msc_timestamp,
       };
-      next_->SyncInterpret(&hs_copy, &next_timeout);
+      // Deliver a copy, so next_ can't change the queued state. If next_
+      // hands out a state it keeps, copy straight into that.
+      HardwareState* hs = next_->NextInputState();
+      if (hs) {
+        hs->DeepCopy(node->state_, hwprops_->max_finger_cnt);
+      } else {
+        std::copy(&node->state_.fingers[0],
+                  &node->state_.fingers[finger_cnt],
+                  &fs_copy[0]);
+        hs = &hs_copy;
+      }
+      next_->SyncInterpret(hs, &next_timeout);
 
       // Clear previously completed nodes, but keep at least two nodes.
       while (queue_.size() > 2 && queue_.front().completed_) {
-        queue_.pop_front();
+        RecycleFront();
       }
 
       // Mark current node completed. This should be the only completed
@@ -469,8 +525,8 @@ void LookaheadFilterInterpreter::HandleTimerImpl(stime_t now,
       node->completed_ = true;
 
       // Copy finger flags for upstream filters.
-      for (size_t i = 0; i < node->state_.finger_cnt; i++) {
-        node->state_.fingers[i].flags = hs_copy.fingers[i].flags;
+      for (size_t i = 0; i < hs->finger_cnt; i++) {
+        node->state_.fingers[i].flags = hs->fingers[i].flags;
       }
     }
     UpdateInterpreterDue(next_timeout, now, timeout);
@@ -548,10 +604,72 @@ void LookaheadFilterInterpreter::Initialize(
     GestureConsumer* consumer) {
   FilterInterpreter::Initialize(hwprops, NULL, mprops, consumer);
   queue_.clear();
+  // Pooled nodes may be sized for a different max_finger_cnt.
+  free_nodes_.clear();
+}
+
+HardwareState* LookaheadFilterInterpreter::NextInputState() {
+  // No nodes until Initialize().
+  if (!initialized_)
+    return NULL;
+  if (free_nodes_.empty())
+    free_nodes_.emplace_back(hwprops_->max_finger_cnt);
+  // NewNode() takes this one next.
+  QState& node = free_nodes_.front();
+  memset(&node.state_, 0, sizeof(node.state_));
+  node.state_.fingers = node.fs_.get();
+  return &node.state_;
+}
+
+LookaheadFilterInterpreter::QState* LookaheadFilterInterpreter::NewNode(
+    List<QState>::iterator pos, const HardwareState* state) {
+  if (free_nodes_.empty())
+    free_nodes_.emplace_back(hwprops_->max_finger_cnt);
+  auto node = free_nodes_.begin();
+  queue_.splice(pos, free_nodes_, node);
+  // A state from NextInputState() is already in place.
+  if (state != &node->state_) {
+    memset(&node->state_, 0, sizeof(node->state_));
+    node->state_.fingers = node->fs_.get();
+    if (state)
+      node->set_state(*state);
+  }
+  node->output_ids_.clear();
+  node->due_ = 0.0;
+  node->completed_ = false;
+  return &*node;
+}
+
+void LookaheadFilterInterpreter::RecycleFront() {
+  free_nodes_.splice(free_nodes_.begin(), queue_, queue_.begin());
+}
+
+stime_t LookaheadFilterInterpreter::Delay() const {
+  if (!adaptive_delay_enable_.val_ || report_samples_ < kMinIntervalSamples)
+    return min_delay_.val_;
+  return min<stime_t>(min_delay_.val_,
+                      report_interval_ + adaptive_delay_jitter_factor_.val_ *
+                      report_interval_dev_);
 }
 
 stime_t LookaheadFilterInterpreter::ExtraVariableDelay() const {
-  return std::max<stime_t>(0.0, max_delay_.val_ - min_delay_.val_);
+  return std::max<stime_t>(0.0, max_delay_.val_ - Delay());
+}
+
+void LookaheadFilterInterpreter::UpdateReportInterval(stime_t timestamp) {
+  stime_t interval = timestamp - last_report_time_;
+  last_report_time_ = timestamp;
+  if (interval <= 0.0 || interval > kMaxReportInterval)
+    return;
+  if (report_samples_ == 0) {
+    report_interval_ = interval;
+    report_interval_dev_ = 0.0;
+  } else {
+    report_interval_dev_ += kIntervalWeight *
+        (fabs(interval - report_interval_) - report_interval_dev_);
+    report_interval_ += kIntervalWeight * (interval - report_interval_);
+  }
+  report_samples_++;
 }
 
 LookaheadFilterInterpreter::QState::QState()
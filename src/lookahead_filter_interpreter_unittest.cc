@@ -6,6 +6,7 @@
 #include <math.h>
 #include <set>
 #include <stdio.h>
+#include <string.h>
 #include <utility>
 #include <vector>
 
@@ -13,6 +14,7 @@
 
 #include "include/gestures.h"
 #include "include/lookahead_filter_interpreter.h"
+#include "include/touch_stream_generator.h"
 #include "include/unittest_util.h"
 #include "include/util.h"
 
@@ -1276,4 +1278,275 @@ TEST(LookaheadFilterInterpreterTest, SemiMtNoTrackingIdAssignmentTest) {
   }
 }
 
+class LookaheadFilterInterpreterLatencyTestInterpreter : public Interpreter {
+ public:
+  LookaheadFilterInterpreterLatencyTestInterpreter()
+      : Interpreter(NULL, NULL, false), now_(0.0), total_latency_(0.0),
+        last_timestamp_(-1.0), interpret_call_count_(0) {}
+
+  virtual void SyncInterpret(HardwareState* hwstate, stime_t* timeout) {
+    EXPECT_GT(hwstate->timestamp, last_timestamp_);
+    last_timestamp_ = hwstate->timestamp;
+    total_latency_ += now_ - hwstate->timestamp;
+    interpret_call_count_++;
+    for (size_t i = 0; i < hwstate->finger_cnt; i++)
+      finger_ids_.insert(hwstate->fingers[i].tracking_id);
+  }
+
+  virtual void HandleTimer(stime_t now, stime_t* timeout) {
+    EXPECT_TRUE(false);
+  }
+
+  stime_t now_;
+  stime_t total_latency_;
+  stime_t last_timestamp_;
+  size_t interpret_call_count_;
+  std::set<short> finger_ids_;
+};
+
+namespace {
+
+struct LookaheadLatencyResult {
+  stime_t mean_latency;
+  size_t finger_ids;
+};
+
+// Feeds a synthetic, jittery 120Hz one finger move from TouchStreamGenerator
+// through |interpreter|, whose next interpreter must be |base_interpreter|,
+// and measures how long states wait in its queue.
+LookaheadLatencyResult RunLookaheadLatency(
+    LookaheadFilterInterpreter* interpreter,
+    LookaheadFilterInterpreterLatencyTestInterpreter* base_interpreter) {
+  HardwareProperties hwprops = {
+    0, 0, 1000, 600,  // left, top, right, bottom
+    10,  // x res (pixels/mm)
+    10,  // y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch,
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TestInterpreterWrapper wrapper(interpreter, &hwprops);
+
+  TouchStreamConfig config;
+  config.rate = 120.0;
+  config.position_noise = 0.05;
+  config.delivery_jitter = 0.002;
+  TouchStreamGenerator generator(hwprops, config);
+  generator.AddSegment(kTouchSegmentMove, 1, 0.5);
+
+  HardwareState* next = generator.Next();
+  while (next) {
+    HardwareState hs = *next;
+    FingerState fs = hs.finger_cnt ? hs.fingers[0] : FingerState();
+    hs.fingers = &fs;
+    next = generator.Next();
+    stime_t next_input = next ? next->timestamp : INFINITY;
+
+    stime_t timeout = NO_DEADLINE;
+    stime_t now = hs.timestamp;
+    base_interpreter->now_ = now;
+    wrapper.SyncInterpret(&hs, &timeout);
+    while (timeout >= 0 && (timeout + now) < next_input) {
+      now += timeout;
+      timeout = NO_DEADLINE;
+      base_interpreter->now_ = now;
+      wrapper.HandleTimer(now, &timeout);
+    }
+  }
+  LookaheadLatencyResult result = {
+    base_interpreter->total_latency_ / base_interpreter->interpret_call_count_,
+    base_interpreter->finger_ids_.size()
+  };
+  return result;
+}
+
+}  // namespace {}
+
+TEST(LookaheadFilterInterpreterTest, AdaptiveDelayTest) {
+  LookaheadLatencyResult results[2];
+  stime_t current_delays[2];
+  for (int adaptive = 0; adaptive < 2; adaptive++) {
+    LookaheadFilterInterpreterLatencyTestInterpreter* base_interpreter =
+        new LookaheadFilterInterpreterLatencyTestInterpreter;
+    LookaheadFilterInterpreter interpreter(NULL, base_interpreter, NULL);
+    // A fixed delay tuned by hand for this device.
+    interpreter.min_delay_.val_ = 0.02;
+    interpreter.max_delay_.val_ = 0.02;
+    interpreter.adaptive_delay_enable_.val_ = adaptive;
+    results[adaptive] = RunLookaheadLatency(&interpreter, base_interpreter);
+    current_delays[adaptive] = interpreter.current_delay_.val_;
+  }
+  const LookaheadLatencyResult& fixed = results[0];
+  const LookaheadLatencyResult& adaptive = results[1];
+  EXPECT_DOUBLE_EQ(0.02, current_delays[0]);
+  // The adaptive delay covers one report interval plus jitter, which is
+  // about 10ms here, and saves the rest of the fixed delay.
+  EXPECT_GT(current_delays[1], 1.0 / 120);
+  EXPECT_LT(current_delays[1], 0.013);
+  EXPECT_LT(adaptive.mean_latency, fixed.mean_latency - 0.006);
+  // The finger keeps its tracking id either way.
+  EXPECT_EQ(1, fixed.finger_ids);
+  EXPECT_EQ(1, adaptive.finger_ids);
+}
+
+TEST(LookaheadFilterInterpreterTest, BypassTest) {
+  LookaheadFilterInterpreterLatencyTestInterpreter* base_interpreter =
+      new LookaheadFilterInterpreterLatencyTestInterpreter;
+  LookaheadFilterInterpreter interpreter(NULL, base_interpreter, NULL);
+  interpreter.min_delay_.val_ = 0.02;
+  interpreter.max_delay_.val_ = 0.02;
+  interpreter.single_finger_bypass_.val_ = true;
+
+  HardwareProperties hwprops = {
+    0, 0, 100, 100,  // left, top, right, bottom
+    1,  // x res (pixels/mm)
+    1,  // y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch,
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TestInterpreterWrapper wrapper(&interpreter, &hwprops);
+
+  const size_t kOneFingerFrames = 8;
+  const size_t kFrames = 12;
+  for (size_t i = 0; i < kFrames; i++) {
+    FingerState fs[] = {
+      // TM, Tm, WM, Wm, pr, orient, x, y, id
+      { 0, 0, 0, 0, 50, 0, 10.0f + i, 20, 1, 0 },
+      { 0, 0, 0, 0, 50, 0, 60, 50, 2, 0 },
+    };
+    unsigned short finger_cnt = i < kOneFingerFrames ? 1 : 2;
+    HardwareState hs = make_hwstate(1.0 + 0.01 * i, 0, finger_cnt, finger_cnt,
+                                    fs);
+    stime_t timeout = NO_DEADLINE;
+    stime_t now = hs.timestamp;
+    base_interpreter->now_ = now;
+    wrapper.SyncInterpret(&hs, &timeout);
+    if (i >= 4 && i < kOneFingerFrames) {
+      // Steady pointing: everything up to this state is passed on at once.
+      EXPECT_EQ(i + 1, base_interpreter->interpret_call_count_);
+    } else {
+      // Still learning, or back to queueing for the second finger.
+      EXPECT_GT(i + 1, base_interpreter->interpret_call_count_);
+    }
+    stime_t next_input = hs.timestamp + 0.01;
+    while (timeout >= 0 && (timeout + now) < next_input) {
+      now += timeout;
+      timeout = NO_DEADLINE;
+      base_interpreter->now_ = now;
+      wrapper.HandleTimer(now, &timeout);
+    }
+  }
+}
+
+TEST(LookaheadFilterInterpreterTest, BypassLatencyTest) {
+  LookaheadLatencyResult results[2];
+  for (int bypass = 0; bypass < 2; bypass++) {
+    LookaheadFilterInterpreterLatencyTestInterpreter* base_interpreter =
+        new LookaheadFilterInterpreterLatencyTestInterpreter;
+    LookaheadFilterInterpreter interpreter(NULL, base_interpreter, NULL);
+    interpreter.min_delay_.val_ = 0.02;
+    interpreter.max_delay_.val_ = 0.02;
+    interpreter.single_finger_bypass_.val_ = bypass;
+    results[bypass] = RunLookaheadLatency(&interpreter, base_interpreter);
+  }
+  // Only the first few states and the liftoff wait in the queue.
+  EXPECT_LT(results[1].mean_latency, results[0].mean_latency / 2);
+  EXPECT_EQ(1, results[1].finger_ids);
+}
+
+// Hands out a state of its own for Lookahead to fill, and records where
+// each state it gets came from.
+class LookaheadFilterInterpreterHandOffTestInterpreter
+    : public LookaheadFilterInterpreterTestInterpreter {
+ public:
+  LookaheadFilterInterpreterHandOffTestInterpreter() {
+    memset(&state_, 0, sizeof(state_));
+    memset(fingers_, 0, sizeof(fingers_));
+    state_.fingers = fingers_;
+  }
+
+  virtual HardwareState* NextInputState() { return &state_; }
+
+  virtual void SyncInterpret(HardwareState* hwstate, stime_t* timeout) {
+    EXPECT_EQ(&state_, hwstate);
+    EXPECT_EQ(fingers_, hwstate->fingers);
+    if (hwstate->finger_cnt)
+      positions_.push_back(hwstate->fingers[0].position_x);
+    LookaheadFilterInterpreterTestInterpreter::SyncInterpret(hwstate,
+                                                             timeout);
+  }
+
+  HardwareState state_;
+  FingerState fingers_[5];
+  std::vector<float> positions_;
+};
+
+TEST(LookaheadFilterInterpreterTest, HandOffTest) {
+  LookaheadFilterInterpreterHandOffTestInterpreter* base_interpreter =
+      new LookaheadFilterInterpreterHandOffTestInterpreter;
+  LookaheadFilterInterpreter interpreter(NULL, base_interpreter, NULL);
+  interpreter.min_delay_.val_ = 0.02;
+  interpreter.max_delay_.val_ = 0.02;
+  // No queue nodes until Initialize().
+  EXPECT_EQ(reinterpret_cast<HardwareState*>(NULL),
+            interpreter.NextInputState());
+
+  HardwareProperties hwprops = {
+    0, 0, 100, 100,  // left, top, right, bottom
+    1,  // x res (pixels/mm)
+    1,  // y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch,
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TestInterpreterWrapper wrapper(&interpreter, &hwprops);
+
+  const size_t kFrames = 10;
+  for (size_t i = 0; i < kFrames; i++) {
+    FingerState fs[] = {
+      // TM, Tm, WM, Wm, pr, orient, x, y, id
+      { 0, 0, 0, 0, 50, 0, 10.0f + i, 20, 1, 0 },
+    };
+    HardwareState hs = make_hwstate(1.0 + 0.01 * i, 0, 1, 1, fs);
+    HardwareState* input = &hs;
+    if (i % 2) {
+      // Every other state is filled in in the next queue node.
+      input = interpreter.NextInputState();
+      ASSERT_NE(reinterpret_cast<HardwareState*>(NULL), input);
+      FingerState* fingers = input->fingers;
+      *input = hs;
+      input->fingers = fingers;
+      input->fingers[0] = fs[0];
+    }
+    stime_t timeout = NO_DEADLINE;
+    stime_t now = hs.timestamp;
+    wrapper.SyncInterpret(input, &timeout);
+    // Handed out states are queued in place, the others are copied.
+    EXPECT_EQ(input != &hs, input == &interpreter.queue_.back().state_);
+    stime_t next_input = i + 1 < kFrames ? hs.timestamp + 0.01 : 3.0;
+    while (timeout >= 0 && (timeout + now) < next_input) {
+      now += timeout;
+      timeout = NO_DEADLINE;
+      wrapper.HandleTimer(now, &timeout);
+    }
+  }
+  // Every state went through the handed out one, in order.
+  ASSERT_EQ(kFrames, base_interpreter->positions_.size());
+  for (size_t i = 0; i < kFrames; i++)
+    EXPECT_FLOAT_EQ(10.0f + i, base_interpreter->positions_[i]);
+}
+
 }  // namespace gestures
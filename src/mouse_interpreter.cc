@@ -6,6 +6,8 @@
 
 #include <math.h>
 
+#include <algorithm>
+
 #include "include/logging.h"
 #include "include/macros.h"
 #include "include/tracer.h"
@@ -20,9 +22,12 @@ const static int REL_WHEEL_HI_RES_UNITS_PER_NOTCH = 120;
 
 MouseInterpreter::MouseInterpreter(PropRegistry* prop_reg, Tracer* tracer)
     : Interpreter(NULL, tracer, false),
+      prev_state_(&states_[0]),
+      next_state_(&states_[1]),
       wheel_emulation_accu_x_(0.0),
       wheel_emulation_accu_y_(0.0),
       wheel_emulation_active_(false),
+      scroll_accel_table_max_speed_(NAN),
       reverse_scrolling_(prop_reg, "Mouse Reverse Scrolling", false),
       hi_res_scrolling_(prop_reg, "Mouse High Resolution Scrolling", true),
       scroll_accel_curve_prop_(prop_reg, "Mouse Scroll Accel Curve",
@@ -42,7 +47,7 @@ MouseInterpreter::MouseInterpreter(PropRegistry* prop_reg, Tracer* tracer)
       output_mouse_wheel_gestures_(prop_reg,
                                    "Output Mouse Wheel Gestures", false) {
   InitName();
-  memset(&prev_state_, 0, sizeof(prev_state_));
+  memset(states_, 0, sizeof(states_));
   memset(&last_wheel_, 0, sizeof(last_wheel_));
   memset(&last_hwheel_, 0, sizeof(last_hwheel_));
   // Scroll acceleration curve coefficients. See the definition for more
@@ -53,6 +58,8 @@ MouseInterpreter::MouseInterpreter(PropRegistry* prop_reg, Tracer* tracer)
   scroll_accel_curve_[3] = 8.0428e-05;
   scroll_accel_curve_[4] = -9.1149e-07;
   scroll_max_allowed_input_speed_.SetDelegate(this);
+  memset(scroll_accel_table_curve_, 0, sizeof(scroll_accel_table_curve_));
+  UpdateScrollAccelTable();
 }
 
 void MouseInterpreter::SyncInterpretImpl(HardwareState* hwstate,
@@ -60,35 +67,90 @@ void MouseInterpreter::SyncInterpretImpl(HardwareState* hwstate,
   if(!EmulateScrollWheel(*hwstate)) {
     // Interpret mouse events in the order of pointer moves, scroll wheels and
     // button clicks.
-    InterpretMouseMotionEvent(prev_state_, *hwstate);
+    InterpretMouseMotionEvent(*prev_state_, *hwstate);
     // Note that unlike touchpad scrolls, we interpret and send separate events
     // for horizontal/vertical mouse wheel scrolls. This is partly to match what
     // the xf86-input-evdev driver does and is partly because not all code in
     // Chrome honors MouseWheelEvent that has both X and Y offsets.
-    InterpretScrollWheelEvent(*hwstate, true);
-    InterpretScrollWheelEvent(*hwstate, false);
-    InterpretMouseButtonEvent(prev_state_, *hwstate);
+    InterpretScrollWheelEvents(*hwstate);
+    InterpretMouseButtonEvent(*prev_state_, *hwstate);
+  }
+  if (hwstate == next_state_) {
+    // The caller filled in the state from NextInputState(), so keep it.
+    std::swap(prev_state_, next_state_);
+  } else {
+    // Pass max_finger_cnt = 0 to DeepCopy() since we don't care fingers and
+    // did not allocate any space for fingers.
+    prev_state_->DeepCopy(*hwstate, 0);
   }
-  // Pass max_finger_cnt = 0 to DeepCopy() since we don't care fingers and
-  // did not allocate any space for fingers.
-  prev_state_.DeepCopy(*hwstate, 0);
+}
+
+HardwareState* MouseInterpreter::NextInputState() {
+  return next_state_;
 }
 
 double MouseInterpreter::ComputeScrollAccelFactor(double input_speed) {
-  double result = 0.0;
-  double term = 1.0;
-  double allowed_speed = fabs(input_speed);
-  if (allowed_speed > scroll_max_allowed_input_speed_.val_)
-    allowed_speed = scroll_max_allowed_input_speed_.val_;
-
-  // Compute the scroll acceleration factor.
-  for (size_t i = 0; i < arraysize(scroll_accel_curve_); i++) {
-    result += term * scroll_accel_curve_[i];
-    term *= allowed_speed;
+  double factor;
+  ComputeScrollAccelFactors(&input_speed, 1, &factor);
+  return factor;
+}
+
+void MouseInterpreter::ComputeScrollAccelFactors(const double* input_speeds,
+                                                 size_t count,
+                                                 double* factors) {
+  UpdateScrollAccelTable();
+  const double max_speed = scroll_max_allowed_input_speed_.val_;
+  if (scroll_accel_table_scale_ <= 0.0) {
+    for (size_t i = 0; i < count; i++)
+      factors[i] = ScrollAccelCurve(std::min(fabs(input_speeds[i]),
+                                             max_speed));
+    return;
   }
+
+  // No branches, so the speeds are interpolated side by side.
+  const double scale = scroll_accel_table_scale_;
+  for (size_t i = 0; i < count; i++) {
+    double pos = std::min(fabs(input_speeds[i]), max_speed) * scale;
+    size_t idx = std::min(static_cast<size_t>(pos),
+                          kScrollAccelTableSize - 2);
+    double frac = pos - idx;
+    factors[i] = scroll_accel_table_[idx] +
+        frac * (scroll_accel_table_[idx + 1] - scroll_accel_table_[idx]);
+  }
+}
+
+double MouseInterpreter::ScrollAccelCurve(double speed) const {
+  double result = 0.0;
+  for (size_t i = arraysize(scroll_accel_curve_); i-- > 0;)
+    result = result * speed + scroll_accel_curve_[i];
   return result;
 }
 
+void MouseInterpreter::UpdateScrollAccelTable() {
+  // The properties are compared with what the table was sampled from, rather
+  // than followed with a delegate, as a replayed log sets them without
+  // notifying us.
+  double max_speed = scroll_max_allowed_input_speed_.val_;
+  if (max_speed == scroll_accel_table_max_speed_ &&
+      std::equal(scroll_accel_curve_,
+                 scroll_accel_curve_ + arraysize(scroll_accel_curve_),
+                 scroll_accel_table_curve_))
+    return;
+  scroll_accel_table_max_speed_ = max_speed;
+  std::copy(scroll_accel_curve_,
+            scroll_accel_curve_ + arraysize(scroll_accel_curve_),
+            scroll_accel_table_curve_);
+  if (!(max_speed > 0.0)) {
+    // Nothing to sample, so the curve is evaluated directly.
+    scroll_accel_table_scale_ = 0.0;
+    return;
+  }
+  scroll_accel_table_scale_ = (kScrollAccelTableSize - 1) / max_speed;
+  for (size_t i = 0; i < kScrollAccelTableSize; i++)
+    scroll_accel_table_[i] =
+        ScrollAccelCurve(max_speed * i / (kScrollAccelTableSize - 1));
+}
+
 bool MouseInterpreter::EmulateScrollWheel(const HardwareState& hwstate) {
   if (!force_scroll_wheel_emulation_.val_ && hwprops_->has_wheel)
     return false;
@@ -96,9 +158,9 @@ bool MouseInterpreter::EmulateScrollWheel(const HardwareState& hwstate) {
   bool down = hwstate.buttons_down & GESTURES_BUTTON_MIDDLE ||
               (hwstate.buttons_down & GESTURES_BUTTON_LEFT &&
                hwstate.buttons_down & GESTURES_BUTTON_RIGHT);
-  bool prev_down = prev_state_.buttons_down & GESTURES_BUTTON_MIDDLE ||
-                   (prev_state_.buttons_down & GESTURES_BUTTON_LEFT &&
-                    prev_state_.buttons_down & GESTURES_BUTTON_RIGHT);
+  bool prev_down = prev_state_->buttons_down & GESTURES_BUTTON_MIDDLE ||
+                   (prev_state_->buttons_down & GESTURES_BUTTON_LEFT &&
+                    prev_state_->buttons_down & GESTURES_BUTTON_RIGHT);
   bool raising = down && !prev_down;
   bool falling = !down && prev_down;
 
@@ -112,10 +174,10 @@ bool MouseInterpreter::EmulateScrollWheel(const HardwareState& hwstate) {
   // Send button event if button has been released without scrolling.
   if (falling && !wheel_emulation_active_) {
     ProduceGesture(Gesture(kGestureButtonsChange,
-                           prev_state_.timestamp,
+                           prev_state_->timestamp,
                            hwstate.timestamp,
-                           prev_state_.buttons_down,
-                           prev_state_.buttons_down,
+                           prev_state_->buttons_down,
+                           prev_state_->buttons_down,
                            false)); // is_tap
   }
 
@@ -147,8 +209,28 @@ bool MouseInterpreter::EmulateScrollWheel(const HardwareState& hwstate) {
   return false;
 }
 
-void MouseInterpreter::InterpretScrollWheelEvent(const HardwareState& hwstate,
-                                                 bool is_vertical) {
+void MouseInterpreter::InterpretScrollWheelEvents(
+    const HardwareState& hwstate) {
+  // Vertical first, then horizontal. The acceleration of both is computed in
+  // one go.
+  WheelScroll scrolls[2];
+  size_t scroll_cnt = 0;
+  if (ReadScrollWheel(hwstate, true, &scrolls[scroll_cnt]))
+    scroll_cnt++;
+  if (ReadScrollWheel(hwstate, false, &scrolls[scroll_cnt]))
+    scroll_cnt++;
+  double speeds[arraysize(scrolls)];
+  double factors[arraysize(scrolls)];
+  for (size_t i = 0; i < scroll_cnt; i++)
+    speeds[i] = scrolls[i].velocity;
+  ComputeScrollAccelFactors(speeds, scroll_cnt, factors);
+  for (size_t i = 0; i < scroll_cnt; i++)
+    ProduceWheelScroll(scrolls[i], factors[i]);
+}
+
+bool MouseInterpreter::ReadScrollWheel(const HardwareState& hwstate,
+                                       bool is_vertical,
+                                       WheelScroll* scroll) {
   const float scroll_wheel_event_time_delta_min = 0.008;
   bool use_high_resolution =
       is_vertical && hwprops_->wheel_is_hi_res
@@ -171,44 +253,56 @@ void MouseInterpreter::InterpretScrollWheelEvent(const HardwareState& hwstate,
   }
 
   // Check if the wheel is scrolled.
-  if (current_wheel_value) {
-    stime_t start_time, end_time = hwstate.timestamp;
-    // Check if this scroll is in same direction as previous scroll event.
-    if ((current_wheel_value < 0 && last_wheel_record->value < 0) ||
-        (current_wheel_value > 0 && last_wheel_record->value > 0)) {
-      start_time = last_wheel_record->timestamp;
-    } else {
-      start_time = end_time;
-    }
+  if (!current_wheel_value)
+    return false;
 
-    // If start_time == end_time, compute velocity using dt = 1 second.
-    // (this happens when the user initially starts scrolling)
-    stime_t dt = (end_time - start_time) ?: 1.0;
-    if (dt < scroll_wheel_event_time_delta_min) {
-      // the first packet received after BT wakeup may be delayed, causing the
-      // time delta between that and the subsequent packet to be very small.
-      // Prevent small time deltas from triggering large amounts of acceleration
-      // by enforcing a minimum time delta.
-      dt = scroll_wheel_event_time_delta_min;
-    }
+  stime_t start_time, end_time = hwstate.timestamp;
+  // Check if this scroll is in same direction as previous scroll event.
+  if ((current_wheel_value < 0 && last_wheel_record->value < 0) ||
+      (current_wheel_value > 0 && last_wheel_record->value > 0)) {
+    start_time = last_wheel_record->timestamp;
+  } else {
+    start_time = end_time;
+  }
 
-    float velocity = current_wheel_value / dt;
-    float offset = current_wheel_value * ComputeScrollAccelFactor(velocity);
-    last_wheel_record->timestamp = hwstate.timestamp;
-    last_wheel_record->value = current_wheel_value;
+  // If start_time == end_time, compute velocity using dt = 1 second.
+  // (this happens when the user initially starts scrolling)
+  stime_t dt = (end_time - start_time) ?: 1.0;
+  if (dt < scroll_wheel_event_time_delta_min) {
+    // the first packet received after BT wakeup may be delayed, causing the
+    // time delta between that and the subsequent packet to be very small.
+    // Prevent small time deltas from triggering large amounts of acceleration
+    // by enforcing a minimum time delta.
+    dt = scroll_wheel_event_time_delta_min;
+  }
 
-    if (is_vertical) {
-      // For historical reasons the vertical wheel (REL_WHEEL) is inverted
-      if (!reverse_scrolling_.val_) {
-        offset = -offset;
-        ticks = -ticks;
-      }
-      ProduceGesture(
-          CreateWheelGesture(start_time, end_time, 0, offset, 0, ticks));
-    } else {
-      ProduceGesture(
-          CreateWheelGesture(start_time, end_time, offset, 0, ticks, 0));
+  last_wheel_record->timestamp = hwstate.timestamp;
+  last_wheel_record->value = current_wheel_value;
+
+  scroll->start_time = start_time;
+  scroll->end_time = end_time;
+  scroll->value = current_wheel_value;
+  scroll->velocity = current_wheel_value / dt;
+  scroll->ticks = ticks;
+  scroll->is_vertical = is_vertical;
+  return true;
+}
+
+void MouseInterpreter::ProduceWheelScroll(const WheelScroll& scroll,
+                                          double accel_factor) {
+  float offset = scroll.value * accel_factor;
+  int ticks = scroll.ticks;
+  if (scroll.is_vertical) {
+    // For historical reasons the vertical wheel (REL_WHEEL) is inverted
+    if (!reverse_scrolling_.val_) {
+      offset = -offset;
+      ticks = -ticks;
     }
+    ProduceGesture(CreateWheelGesture(scroll.start_time, scroll.end_time, 0,
+                                      offset, 0, ticks));
+  } else {
+    ProduceGesture(CreateWheelGesture(scroll.start_time, scroll.end_time,
+                                      offset, 0, ticks, 0));
   }
 }
 
@@ -2,9 +2,12 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <math.h>
+
 #include <gtest/gtest.h>
 
 #include "include/gestures.h"
+#include "include/macros.h"
 #include "include/mouse_interpreter.h"
 #include "include/unittest_util.h"
 #include "include/util.h"
@@ -220,4 +223,98 @@ TEST(MouseInterpreterTest, WheelTickReportingLowResTest) {
   EXPECT_EQ(  0, gs->details.wheel.tick_120ths_dy);
 }
 
+namespace {
+
+// The scroll acceleration polynomial, evaluated term by term.
+double ScrollAccelPolynomial(const double* curve, size_t count,
+                             double speed) {
+  double result = 0.0;
+  for (size_t i = 0; i < count; i++)
+    result += curve[i] * pow(speed, i);
+  return result;
+}
+
+}  // namespace {}
+
+TEST(MouseInterpreterTest, ScrollAccelTableTest) {
+  PropRegistry prop_reg;
+  MouseInterpreter mi(&prop_reg, NULL);
+  const size_t count = arraysize(mi.scroll_accel_curve_);
+  double max_speed = mi.scroll_max_allowed_input_speed_.val_;
+
+  for (double speed = -250.0; speed <= 250.0; speed += 0.05) {
+    double expected = ScrollAccelPolynomial(
+        mi.scroll_accel_curve_, count, std::min(fabs(speed), max_speed));
+    EXPECT_NEAR(expected, mi.ScrollAccelCurve(std::min(fabs(speed),
+                                                       max_speed)), 1e-9);
+    EXPECT_NEAR(expected, mi.ComputeScrollAccelFactor(speed), 0.02);
+  }
+
+  // The table follows changes to the curve and the max input speed, even
+  // when they are set without notifying, as replaying a log does.
+  Json::Value curve(Json::arrayValue);
+  for (size_t i = 0; i < count; i++)
+    curve.append(i == 2 ? 0.05 : mi.scroll_accel_curve_[i]);
+  EXPECT_TRUE(prop_reg.FindProperty("Mouse Scroll Accel Curve")->
+              SetValue(curve));
+  EXPECT_TRUE(prop_reg.FindProperty("Mouse Scroll Max Input Speed")->
+              SetValue(Json::Value(100.0)));
+  EXPECT_DOUBLE_EQ(0.05, mi.scroll_accel_curve_[2]);
+  for (double speed = 0.0; speed <= 150.0; speed += 0.05) {
+    double expected = ScrollAccelPolynomial(mi.scroll_accel_curve_, count,
+                                            std::min(speed, 100.0));
+    EXPECT_NEAR(expected, mi.ComputeScrollAccelFactor(speed), 0.02);
+  }
+
+  // A batch of speeds gets the same factors as one at a time.
+  const double kSpeeds[] = { -120.0, -3.5, 0.0, 0.7, 42.0, 99.9, 180.0 };
+  double factors[arraysize(kSpeeds)];
+  mi.ComputeScrollAccelFactors(kSpeeds, arraysize(kSpeeds), factors);
+  for (size_t i = 0; i < arraysize(kSpeeds); i++)
+    EXPECT_DOUBLE_EQ(mi.ComputeScrollAccelFactor(kSpeeds[i]), factors[i]);
+
+  // With no speed range to sample, the curve is evaluated directly.
+  EXPECT_TRUE(prop_reg.FindProperty("Mouse Scroll Max Input Speed")->
+              SetValue(Json::Value(0.0)));
+  EXPECT_DOUBLE_EQ(mi.scroll_accel_curve_[0],
+                   mi.ComputeScrollAccelFactor(10.0));
+}
+
+TEST(MouseInterpreterTest, HandOffTest) {
+  HardwareProperties hwprops = make_hwprops_for_mouse(1, 0);
+  MouseInterpreter mi(NULL, NULL);
+  TestInterpreterWrapper wrapper(&mi, &hwprops);
+
+  HardwareState* first = mi.NextInputState();
+  ASSERT_NE(reinterpret_cast<HardwareState*>(NULL), first);
+  HardwareState hs = make_hwstate(1.0, 0, 0, 0, NULL);
+  *first = hs;
+  EXPECT_EQ(reinterpret_cast<Gesture*>(NULL),
+            wrapper.SyncInterpret(first, NULL));
+  // The state is kept as is, and the spare one is handed out next.
+  EXPECT_EQ(first, mi.prev_state_);
+  HardwareState* second = mi.NextInputState();
+  EXPECT_NE(first, second);
+
+  hs = make_hwstate(1.01, 0, 0, 0, NULL);
+  hs.rel_x = 3;
+  *second = hs;
+  Gesture* gs = wrapper.SyncInterpret(second, NULL);
+  ASSERT_NE(reinterpret_cast<Gesture*>(NULL), gs);
+  EXPECT_EQ(kGestureTypeMove, gs->type);
+  EXPECT_EQ(3, gs->details.move.dx);
+  EXPECT_DOUBLE_EQ(1.0, gs->start_time);
+  EXPECT_EQ(second, mi.prev_state_);
+  EXPECT_EQ(first, mi.NextInputState());
+
+  // States that weren't handed out are copied, as before.
+  hs = make_hwstate(1.02, 0, 0, 0, NULL);
+  hs.rel_x = 4;
+  gs = wrapper.SyncInterpret(&hs, NULL);
+  ASSERT_NE(reinterpret_cast<Gesture*>(NULL), gs);
+  EXPECT_DOUBLE_EQ(1.01, gs->start_time);
+  EXPECT_EQ(second, mi.prev_state_);
+  EXPECT_DOUBLE_EQ(1.02, mi.prev_state_->timestamp);
+}
+
 }  // namespace gestures
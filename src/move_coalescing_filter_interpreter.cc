@@ -0,0 +1,103 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "include/move_coalescing_filter_interpreter.h"
+
+#include "include/logging.h"
+
+namespace gestures {
+
+MoveCoalescingFilterInterpreter::MoveCoalescingFilterInterpreter(
+    PropRegistry* prop_reg, Interpreter* next, Tracer* tracer)
+    : FilterInterpreter(NULL, next, tracer, false),
+      now_(0.0),
+      last_move_time_(NO_DEADLINE),
+      has_pending_(false),
+      coalescing_budget_(prop_reg, "Move Coalescing Budget", 0.0) {
+  InitName();
+}
+
+void MoveCoalescingFilterInterpreter::SyncInterpretImpl(HardwareState* hwstate,
+                                                        stime_t* timeout) {
+  now_ = hwstate->timestamp;
+  stime_t next_timeout = NO_DEADLINE;
+  next_->SyncInterpret(hwstate, &next_timeout);
+  *timeout = SetNextDeadlineAndReturnTimeoutVal(now_, FlushIfDue(now_),
+                                                next_timeout);
+}
+
+void MoveCoalescingFilterInterpreter::HandleTimerImpl(stime_t now,
+                                                      stime_t* timeout) {
+  now_ = now;
+  stime_t local_deadline = has_pending_ ?
+      last_move_time_ + coalescing_budget_.val_ : NO_DEADLINE;
+  if (!ShouldCallNextTimer(local_deadline)) {
+    if (local_deadline > now) {
+      Err("Spurious callback. now: %f, local deadline: %f, next deadline: %f",
+          now, local_deadline, next_timer_deadline_);
+      return;
+    }
+    Flush();
+    stime_t next_timeout =
+      next_timer_deadline_ == NO_DEADLINE || next_timer_deadline_ <= now ?
+      NO_DEADLINE : next_timer_deadline_ - now;
+    *timeout = SetNextDeadlineAndReturnTimeoutVal(now, NO_DEADLINE,
+                                                  next_timeout);
+    return;
+  }
+  // Call next_
+  if (next_timer_deadline_ > now) {
+    Err("Spurious callback. now: %f, local deadline: %f, next deadline: %f",
+        now, local_deadline, next_timer_deadline_);
+    return;
+  }
+  stime_t next_timeout = NO_DEADLINE;
+  next_->HandleTimer(now, &next_timeout);
+  *timeout = SetNextDeadlineAndReturnTimeoutVal(now, FlushIfDue(now),
+                                                next_timeout);
+}
+
+void MoveCoalescingFilterInterpreter::ConsumeGesture(const Gesture& gesture) {
+  if (gesture.type != kGestureTypeMove || coalescing_budget_.val_ <= 0.0) {
+    Flush();
+    ProduceGesture(gesture);
+    return;
+  }
+  if (has_pending_) {
+    pending_.end_time = gesture.end_time;
+    pending_.details.move.dx += gesture.details.move.dx;
+    pending_.details.move.dy += gesture.details.move.dy;
+    pending_.details.move.ordinal_dx += gesture.details.move.ordinal_dx;
+    pending_.details.move.ordinal_dy += gesture.details.move.ordinal_dy;
+    return;
+  }
+  if (last_move_time_ == NO_DEADLINE ||
+      now_ >= last_move_time_ + coalescing_budget_.val_) {
+    last_move_time_ = now_;
+    ProduceGesture(gesture);
+    return;
+  }
+  pending_ = gesture;
+  has_pending_ = true;
+}
+
+void MoveCoalescingFilterInterpreter::Flush() {
+  if (!has_pending_)
+    return;
+  has_pending_ = false;
+  last_move_time_ = now_;
+  ProduceGesture(pending_);
+}
+
+stime_t MoveCoalescingFilterInterpreter::FlushIfDue(stime_t now) {
+  if (!has_pending_)
+    return NO_DEADLINE;
+  stime_t deadline = last_move_time_ + coalescing_budget_.val_;
+  if (deadline > now)
+    return deadline;
+  Flush();
+  return NO_DEADLINE;
+}
+
+}  // namespace gestures
@@ -0,0 +1,258 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <math.h>
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "include/gestures.h"
+#include "include/move_coalescing_filter_interpreter.h"
+#include "include/unittest_util.h"
+
+namespace gestures {
+
+class MoveCoalescingFilterInterpreterTest : public ::testing::Test {};
+
+// Produces a move of (rel_x, rel_y) for each hardware state, and a button
+// change before it when the buttons change.
+class MoveCoalescingFilterInterpreterTestInterpreter : public Interpreter {
+ public:
+  MoveCoalescingFilterInterpreterTestInterpreter()
+      : Interpreter(NULL, NULL, false), prev_buttons_(0), prev_time_(0.0) {}
+
+  virtual void SyncInterpret(HardwareState* hwstate, stime_t* timeout) {
+    if (hwstate->buttons_down != prev_buttons_) {
+      ProduceGesture(Gesture(kGestureButtonsChange, prev_time_,
+                             hwstate->timestamp,
+                             hwstate->buttons_down & ~prev_buttons_,
+                             prev_buttons_ & ~hwstate->buttons_down,
+                             false));  // is_tap
+      prev_buttons_ = hwstate->buttons_down;
+    }
+    if (hwstate->rel_x || hwstate->rel_y)
+      ProduceGesture(Gesture(kGestureMove, prev_time_, hwstate->timestamp,
+                             hwstate->rel_x, hwstate->rel_y));
+    prev_time_ = hwstate->timestamp;
+  }
+
+  virtual void HandleTimer(stime_t now, stime_t* timeout) {
+    ADD_FAILURE() << "HandleTimer on the next interpreter shouldn't be called";
+  }
+
+ private:
+  int prev_buttons_;
+  stime_t prev_time_;
+};
+
+class MoveCoalescingFilterInterpreterTestConsumer : public GestureConsumer {
+ public:
+  virtual void ConsumeGesture(const Gesture& gesture) {
+    gestures_.push_back(gesture);
+  }
+
+  std::vector<Gesture> gestures_;
+};
+
+namespace {
+
+HardwareState MouseState(stime_t timestamp, int buttons_down, float rel_x,
+                         float rel_y) {
+  HardwareState hs = make_hwstate(timestamp, buttons_down, 0, 0, NULL);
+  hs.rel_x = rel_x;
+  hs.rel_y = rel_y;
+  return hs;
+}
+
+}  // namespace {}
+
+TEST(MoveCoalescingFilterInterpreterTest, CoalesceTest) {
+  MoveCoalescingFilterInterpreter interpreter(
+      NULL, new MoveCoalescingFilterInterpreterTestInterpreter, NULL);
+  MoveCoalescingFilterInterpreterTestConsumer consumer;
+  HardwareProperties hwprops = {
+    0, 0, 0, 0,  // left, top, right, bottom
+    0, 0,  // x res, y res
+    0, 0,  // screen DPI x, y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    0, 0,  // max fingers, max touch
+    0, 0, 0,  // t5r2, semi-mt, is button pad
+    0, 0,  // has_wheel, wheel_is_hi_res
+    0,  // is haptic pad
+  };
+  interpreter.Initialize(&hwprops, NULL, NULL, &consumer);
+  interpreter.coalescing_budget_.val_ = 1.0 / 128;
+
+  // 1024 Hz, one count right and two down per report.
+  const size_t kFrames = 96;
+  stime_t timeout = NO_DEADLINE;
+  for (size_t i = 1; i <= kFrames; i++) {
+    HardwareState hs = MouseState(1.0 + i / 1024.0, 0, 1, 2);
+    interpreter.SyncInterpret(&hs, &timeout);
+    // The first move isn't held back.
+    if (i == 1)
+      EXPECT_EQ(1, consumer.gestures_.size());
+  }
+  // One move per 8 reports.
+  EXPECT_EQ(12, consumer.gestures_.size());
+  interpreter.HandleTimer(2.0, &timeout);
+  ASSERT_EQ(13, consumer.gestures_.size());
+
+  // None of the motion is lost.
+  float dx = 0.0, dy = 0.0, ordinal_dx = 0.0;
+  for (size_t i = 0; i < consumer.gestures_.size(); i++) {
+    const Gesture& gesture = consumer.gestures_[i];
+    EXPECT_EQ(kGestureTypeMove, gesture.type);
+    dx += gesture.details.move.dx;
+    dy += gesture.details.move.dy;
+    ordinal_dx += gesture.details.move.ordinal_dx;
+  }
+  EXPECT_FLOAT_EQ(kFrames, dx);
+  EXPECT_FLOAT_EQ(2 * kFrames, dy);
+  EXPECT_FLOAT_EQ(kFrames, ordinal_dx);
+
+  // Without a budget, every move goes through.
+  interpreter.coalescing_budget_.val_ = 0.0;
+  consumer.gestures_.clear();
+  for (size_t i = 0; i < 5; i++) {
+    HardwareState hs = MouseState(3.0 + 0.001 * i, 0, 1, 0);
+    interpreter.SyncInterpret(&hs, &timeout);
+  }
+  EXPECT_EQ(5, consumer.gestures_.size());
+}
+
+TEST(MoveCoalescingFilterInterpreterTest, ButtonFlushTest) {
+  MoveCoalescingFilterInterpreter interpreter(
+      NULL, new MoveCoalescingFilterInterpreterTestInterpreter, NULL);
+  MoveCoalescingFilterInterpreterTestConsumer consumer;
+  HardwareProperties hwprops = {
+    0, 0, 0, 0,  // left, top, right, bottom
+    0, 0,  // x res, y res
+    0, 0,  // screen DPI x, y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    0, 0,  // max fingers, max touch
+    0, 0, 0,  // t5r2, semi-mt, is button pad
+    0, 0,  // has_wheel, wheel_is_hi_res
+    0,  // is haptic pad
+  };
+  interpreter.Initialize(&hwprops, NULL, NULL, &consumer);
+  interpreter.coalescing_budget_.val_ = 0.01;
+
+  stime_t timeout = NO_DEADLINE;
+  HardwareState hs[] = {
+    MouseState(1.000, 0, 1, 0),
+    MouseState(1.001, 0, 1, 0),
+    MouseState(1.002, 0, 1, 0),
+    MouseState(1.003, GESTURES_BUTTON_LEFT, 1, 0),
+  };
+  for (size_t i = 0; i < arraysize(hs); i++)
+    interpreter.SyncInterpret(&hs[i], &timeout);
+
+  // The held motion goes out before the click, and the move after the click
+  // is held again.
+  ASSERT_EQ(3, consumer.gestures_.size());
+  EXPECT_EQ(kGestureTypeMove, consumer.gestures_[0].type);
+  EXPECT_FLOAT_EQ(1.0, consumer.gestures_[0].details.move.dx);
+  EXPECT_EQ(kGestureTypeMove, consumer.gestures_[1].type);
+  EXPECT_FLOAT_EQ(2.0, consumer.gestures_[1].details.move.dx);
+  EXPECT_DOUBLE_EQ(1.000, consumer.gestures_[1].start_time);
+  EXPECT_DOUBLE_EQ(1.002, consumer.gestures_[1].end_time);
+  EXPECT_EQ(kGestureTypeButtonsChange, consumer.gestures_[2].type);
+  EXPECT_LT(0.0, timeout);
+}
+
+TEST(MoveCoalescingFilterInterpreterTest, TimerTest) {
+  MoveCoalescingFilterInterpreter interpreter(
+      NULL, new MoveCoalescingFilterInterpreterTestInterpreter, NULL);
+  MoveCoalescingFilterInterpreterTestConsumer consumer;
+  HardwareProperties hwprops = {
+    0, 0, 0, 0,  // left, top, right, bottom
+    0, 0,  // x res, y res
+    0, 0,  // screen DPI x, y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    0, 0,  // max fingers, max touch
+    0, 0, 0,  // t5r2, semi-mt, is button pad
+    0, 0,  // has_wheel, wheel_is_hi_res
+    0,  // is haptic pad
+  };
+  interpreter.Initialize(&hwprops, NULL, NULL, &consumer);
+  interpreter.coalescing_budget_.val_ = 0.01;
+
+  stime_t timeout = NO_DEADLINE;
+  HardwareState first = MouseState(1.000, 0, 3, 0);
+  interpreter.SyncInterpret(&first, &timeout);
+  EXPECT_DOUBLE_EQ(NO_DEADLINE, timeout);
+  HardwareState second = MouseState(1.004, 0, 4, 0);
+  interpreter.SyncInterpret(&second, &timeout);
+  ASSERT_EQ(1, consumer.gestures_.size());
+  // The held move is due when the budget of the first one ends.
+  EXPECT_NEAR(0.006, timeout, 1e-9);
+
+  interpreter.HandleTimer(1.011, &timeout);
+  ASSERT_EQ(2, consumer.gestures_.size());
+  EXPECT_FLOAT_EQ(4.0, consumer.gestures_[1].details.move.dx);
+  EXPECT_DOUBLE_EQ(NO_DEADLINE, timeout);
+}
+
+namespace {
+
+void SumMoves(void* data, const Gesture* gesture) {
+  if (gesture->type == kGestureTypeMove)
+    *reinterpret_cast<double*>(data) += gesture->details.move.dx;
+}
+
+// Runs a second of 8 kHz mouse input through the mouse chain with the given
+// coalescing budget. Returns the total move distance.
+double RunMouseChain(double budget) {
+  std::unique_ptr<GestureInterpreter> gi(NewGestureInterpreter());
+  gi->Initialize(GESTURES_DEVCLASS_MOUSE);
+  Property* prop = gi->prop_reg()->FindProperty("Move Coalescing Budget");
+  EXPECT_NE(nullptr, prop);
+  if (!prop)
+    return 0.0;
+  prop->SetValue(Json::Value(budget));
+  prop->HandleGesturesPropWritten();
+  HardwareProperties hwprops = {
+    0, 0, 0, 0,  // left, top, right, bottom
+    0, 0,  // x res, y res
+    0, 0,  // screen DPI x, y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    0, 0,  // max fingers, max touch
+    0, 0, 0,  // t5r2, semi-mt, is button pad
+    0, 0,  // has_wheel, wheel_is_hi_res
+    0,  // is haptic pad
+  };
+  gi->SetHardwareProperties(hwprops);
+
+  double distance = 0.0;
+  gi->SetCallback(SumMoves, &distance);
+  for (size_t i = 0; i < 8000; i++) {
+    // Speed varies so acceleration is exercised.
+    HardwareState hs = MouseState(1.0 + i / 8000.0, 0, 1 + i / 800 % 4, 0);
+    gi->PushHardwareState(&hs);
+  }
+  // The last held move is flushed by the timer.
+  stime_t timeout = NO_DEADLINE;
+  gi->TimerCallback(3.0, &timeout);
+  gi->SetCallback(NULL, NULL);
+  return distance;
+}
+
+}  // namespace {}
+
+TEST(MoveCoalescingFilterInterpreterTest, ChainTest) {
+  double plain = RunMouseChain(0.0);
+  double coalesced = RunMouseChain(1.0 / 120);
+  // Acceleration runs per report either way, so the motion matches up to
+  // the rounding IntegralGestureFilterInterpreter does on each move.
+  EXPECT_NEAR(plain, coalesced, 2.0);
+}
+
+}  // namespace gestures
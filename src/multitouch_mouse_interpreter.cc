@@ -38,10 +38,13 @@ MultitouchMouseInterpreter::MultitouchMouseInterpreter(
     : MouseInterpreter(prop_reg, tracer),
       state_buffer_(2),
       scroll_buffer_(15),
+      prev_gs_fingers_(&finger_slots_),
+      gs_fingers_(&finger_slots_),
       prev_gesture_type_(kGestureTypeNull),
       current_gesture_type_(kGestureTypeNull),
       should_fling_(false),
       scroll_manager_(prop_reg),
+      moving_(&finger_slots_),
       click_buffer_depth_(prop_reg, "Click Buffer Depth", 10),
       click_max_distance_(prop_reg, "Click Max Distance", 1.0),
       click_left_button_going_up_lead_time_(prop_reg,
@@ -67,6 +70,8 @@ void MultitouchMouseInterpreter::SyncInterpretImpl(HardwareState* hwstate,
     return;
   }
 
+  finger_slots_.Update(*hwstate);
+
   // Should we remove all fingers from our structures, or just removed ones?
   if ((hwstate->rel_x * hwstate->rel_x + hwstate->rel_y * hwstate->rel_y) >
       moving_min_rel_amount_.val_ * moving_min_rel_amount_.val_) {
@@ -101,7 +106,8 @@ void MultitouchMouseInterpreter::SyncInterpretImpl(HardwareState* hwstate,
           GESTURES_FINGER_WARP_X_NON_MOVE | GESTURES_FINGER_WARP_Y_NON_MOVE;
   }
 
-  // Record current HardwareState now.
+  // Record current HardwareState now. This doesn't copy it if it came from
+  // NextInputState().
   state_buffer_.PushState(*hwstate);
 
   // TODO(clchiou): Remove palm and thumb.
@@ -112,8 +118,7 @@ void MultitouchMouseInterpreter::SyncInterpretImpl(HardwareState* hwstate,
   for (size_t i = 0; i < num_fingers; i++)
     gs_fingers_.insert(fs[i].tracking_id);
 
-  InterpretScrollWheelEvent(*hwstate, true);
-  InterpretScrollWheelEvent(*hwstate, false);
+  InterpretScrollWheelEvents(*hwstate);
   InterpretMouseButtonEvent(prev_state_, *state_buffer_.Get(0));
   InterpretMouseMotionEvent(prev_state_, *state_buffer_.Get(0));
 
@@ -167,6 +172,11 @@ void MultitouchMouseInterpreter::Initialize(
   state_buffer_.Reset(hw_props->max_finger_cnt);
 }
 
+HardwareState* MultitouchMouseInterpreter::NextInputState() {
+  // No slots until SetHardwareProperties().
+  return state_buffer_.Get(0)->fingers ? state_buffer_.NextState() : NULL;
+}
+
 void MultitouchMouseInterpreter::InterpretMultitouchEvent() {
   Gesture result;
 
@@ -5,6 +5,7 @@
 #include <gtest/gtest.h>
 
 #include "include/gestures.h"
+#include "include/macros.h"
 #include "include/multitouch_mouse_interpreter.h"
 #include "include/unittest_util.h"
 #include "include/util.h"
@@ -87,4 +88,57 @@ TEST(MultitouchMouseInterpreterTest, SimpleTest) {
   EXPECT_EQ(240000, gs->end_time);
 }
 
+TEST(MultitouchMouseInterpreterTest, HandOffTest) {
+  HardwareProperties hwprops = {
+    0, 0, 100, 60,  // left, top, right, bottom
+    1, 1,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch
+    0, 0, 0,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  // One interpreter copies its input, the other is handed its states.
+  MultitouchMouseInterpreter copy_mi(NULL, NULL);
+  MultitouchMouseInterpreter mi(NULL, NULL);
+  TestInterpreterWrapper copy_wrapper(&copy_mi, &hwprops);
+  TestInterpreterWrapper wrapper(&mi, &hwprops);
+
+  for (size_t i = 0; i < 20; i++) {
+    // Five resting fingers, and the first one scrolls down. Every fourth
+    // report only moves the mouse, repeating the previous fingers.
+    bool mouse_move = i % 4 == 3;
+    FingerState fs[5];
+    for (size_t j = 0; j < arraysize(fs); j++) {
+      FingerState finger = { 1, 1, 0, 0, 20, 0, 10.0f + 15 * j, 30,
+                             static_cast<short>(j + 1), 0 };
+      fs[j] = finger;
+    }
+    fs[0].position_y += 2.0 * (mouse_move ? i - 1 : i);
+    HardwareState input = make_hwstate(1.0 + 0.001 * i, 0, 5, 5, fs);
+    if (mouse_move)
+      input.rel_x = 2;
+
+    HardwareState* hs = mi.NextInputState();
+    ASSERT_NE(reinterpret_cast<HardwareState*>(NULL), hs);
+    FingerState* slot_fingers = hs->fingers;
+    hs->DeepCopy(input, hwprops.max_finger_cnt);
+    EXPECT_EQ(slot_fingers, hs->fingers);
+
+    Gesture* copy_gs = copy_wrapper.SyncInterpret(&input, NULL);
+    Gesture* gs = wrapper.SyncInterpret(hs, NULL);
+    // The handed off state is kept in place, unless it only repeated the
+    // previous fingers and was dropped.
+    if (!mouse_move)
+      EXPECT_EQ(hs, mi.state_buffer_.Get(0));
+    ASSERT_EQ(copy_gs == NULL, gs == NULL);
+    if (!gs)
+      continue;
+    EXPECT_EQ(copy_gs->type, gs->type);
+    EXPECT_EQ(copy_gs->String(), gs->String());
+  }
+}
+
 }  // namespace gestures
@@ -4,6 +4,10 @@
 
 #include "include/palm_classifying_filter_interpreter.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "include/gestures.h"
 #include "include/interpreter.h"
 #include "include/tracer.h"
@@ -15,6 +19,9 @@ PalmClassifyingFilterInterpreter::PalmClassifyingFilterInterpreter(
     PropRegistry* prop_reg, Interpreter* next,
     Tracer* tracer)
     : FilterInterpreter(NULL, next, tracer, false),
+      prev_present_(0),
+      present_(0),
+      prev_time_(0.0),
       palm_pressure_(prop_reg, "Palm Pressure", 200.0),
       palm_width_(prop_reg, "Palm Width", 21.2),
       multi_palm_width_(prop_reg, "Multiple Palm Width", 75.0),
@@ -39,107 +46,99 @@ PalmClassifyingFilterInterpreter::PalmClassifyingFilterInterpreter(
       filter_top_edge_(prop_reg, "Palm Filter Top Edge Enable", false)
 {
   InitName();
+  memset(contacts_, 0, sizeof(contacts_));
+  memset(finger_contacts_, 0, sizeof(finger_contacts_));
   requires_metrics_ = true;
 }
 
 void PalmClassifyingFilterInterpreter::SyncInterpretImpl(
     HardwareState* hwstate,
     stime_t* timeout) {
-  FillOriginInfo(*hwstate);
-  FillMaxPressureWidthInfo(*hwstate);
-  UpdateDistanceInfo(*hwstate);
+  UpdateContacts(*hwstate);
+  finger_distances_.Update(*hwstate);
   UpdatePalmState(*hwstate);
   UpdatePalmFlags(hwstate);
-  FillPrevInfo(*hwstate);
+  prev_time_ = hwstate->timestamp;
+  prev_present_ = present_;
   if (next_.get())
     next_->SyncInterpret(hwstate, timeout);
 }
 
-void PalmClassifyingFilterInterpreter::FillOriginInfo(
+void PalmClassifyingFilterInterpreter::UpdateContacts(
     const HardwareState& hwstate) {
-  RemoveMissingIdsFromMap(&origin_timestamps_, hwstate);
-  RemoveMissingIdsFromMap(&origin_fingerstates_, hwstate);
-  for (size_t i = 0; i < hwstate.finger_cnt; i++) {
+  finger_slots_.Update(hwstate);
+  present_ = 0;
+  for (size_t i = 0; i < hwstate.finger_cnt && i < kMaxFingerSlots; i++) {
     const FingerState& fs = hwstate.fingers[i];
-    if (MapContainsKey(origin_timestamps_, fs.tracking_id))
+    int slot = finger_slots_.SlotForId(fs.tracking_id);
+    if (slot < 0) {
+      finger_contacts_[i] = NULL;
       continue;
-    origin_timestamps_[fs.tracking_id] = hwstate.timestamp;
-    origin_fingerstates_[fs.tracking_id] = fs;
+    }
+    uint64_t bit = static_cast<uint64_t>(1) << slot;
+    present_ |= bit;
+    Contact* contact = &contacts_[slot];
+    finger_contacts_[i] = contact;
+    if (!(prev_present_ & bit)) {
+      // A new contact.
+      memset(contact, 0, sizeof(*contact));
+      contact->origin_time = hwstate.timestamp;
+      contact->origin = fs;
+      contact->max_pressure = fs.pressure;
+      contact->max_width = fs.touch_major;
+    } else {
+      contact->max_pressure = std::max(contact->max_pressure, fs.pressure);
+      contact->max_width = std::max(contact->max_width, fs.touch_major);
+      float delta[2] = {
+        fs.position_x - contact->prev.position_x,
+        fs.position_y - contact->prev.position_y
+      };
+      for (int j = 0; j < 2; j++) {
+        if (delta[j] > 0)
+          contact->distance_positive[j] += delta[j];
+        else
+          contact->distance_negative[j] -= delta[j];
+      }
+    }
+    contact->prev = fs;
   }
 }
 
-void PalmClassifyingFilterInterpreter::FillPrevInfo(
-    const HardwareState& hwstate) {
-  RemoveMissingIdsFromMap(&prev_fingerstates_, hwstate);
-  prev_time_ = hwstate.timestamp;
-  for (size_t i = 0; i < hwstate.finger_cnt; i++) {
-    const FingerState& fs = hwstate.fingers[i];
-    prev_fingerstates_[fs.tracking_id] = fs;
-  }
+const PalmClassifyingFilterInterpreter::Contact*
+PalmClassifyingFilterInterpreter::ContactForId(short id) const {
+  int slot = finger_slots_.SlotForId(id);
+  if (slot < 0 || !((present_ >> slot) & 1))
+    return NULL;
+  return &contacts_[slot];
 }
 
-void PalmClassifyingFilterInterpreter::FillMaxPressureWidthInfo(
-    const HardwareState& hwstate) {
-  RemoveMissingIdsFromMap(&max_pressure_, hwstate);
-  RemoveMissingIdsFromMap(&max_width_, hwstate);
-  for (size_t i = 0; i < hwstate.finger_cnt; i++) {
-    const FingerState& fs = hwstate.fingers[i];
-    int id = fs.tracking_id;
-    if (MapContainsKey(max_pressure_, id)) {
-      if (fs.pressure > max_pressure_[id])
-        max_pressure_[id] = fs.pressure;
-      if (fs.touch_major > max_width_[id])
-        max_width_[id] = fs.touch_major;
-    } else {
-      max_pressure_[id] = fs.pressure;
-      max_width_[id] = fs.touch_major;
-    }
-  }
+bool PalmClassifyingFilterInterpreter::IsPalm(short id) const {
+  const Contact* contact = ContactForId(id);
+  return contact && contact->palm;
 }
 
-void PalmClassifyingFilterInterpreter::UpdateDistanceInfo(
-    const HardwareState& hwstate) {
-  RemoveMissingIdsFromMap(&distance_positive_[0], hwstate);
-  RemoveMissingIdsFromMap(&distance_positive_[1], hwstate);
-  RemoveMissingIdsFromMap(&distance_negative_[0], hwstate);
-  RemoveMissingIdsFromMap(&distance_negative_[1], hwstate);
-  for (size_t i = 0; i < hwstate.finger_cnt; i++) {
-    const FingerState& fs = hwstate.fingers[i];
-    int id = fs.tracking_id;
-    if (MapContainsKey(prev_fingerstates_, id)) {
-      float delta[2];
-      delta[0] = fs.position_x - prev_fingerstates_[id].position_x;
-      delta[1] = fs.position_y - prev_fingerstates_[id].position_y;
-      for (int i = 0; i < 2; i++) {
-        if (delta[i] > 0)
-          distance_positive_[i][id] += delta[i];
-        else
-          distance_negative_[i][id] -= delta[i];
-      }
-    } else {
-      distance_positive_[0][id] = 0;
-      distance_positive_[1][id] = 0;
-      distance_negative_[0][id] = 0;
-      distance_negative_[1][id] = 0;
-    }
-  }
+bool PalmClassifyingFilterInterpreter::IsPointing(short id) const {
+  const Contact* contact = ContactForId(id);
+  return contact && contact->pointing;
 }
 
 bool PalmClassifyingFilterInterpreter::FingerNearOtherFinger(
     const HardwareState& hwstate,
     size_t finger_idx) {
   const FingerState& fs = hwstate.fingers[finger_idx];
-  for (int i = 0; i < hwstate.finger_cnt; ++i) {
+  for (size_t i = 0; i < hwstate.finger_cnt && i < kMaxFingerSlots; ++i) {
     const FingerState& other_fs = hwstate.fingers[i];
-    if (other_fs.tracking_id == fs.tracking_id)
+    const Contact* other = finger_contacts_[i];
+    if (other_fs.tracking_id == fs.tracking_id || !other)
       continue;
+    Vector2 delta(finger_distances_.DeltaX(finger_idx, i),
+                  finger_distances_.DeltaY(finger_idx, i));
     bool close_enough_together =
-        metrics_->CloseEnoughToGesture(Vector2(fs), Vector2(other_fs)) &&
-        !SetContainsValue(palm_, other_fs.tracking_id);
-    bool too_close_together = DistSq(fs, other_fs) <
+        metrics_->CloseEnoughToGesture(delta, Vector2()) && !other->palm;
+    bool too_close_together = finger_distances_.DistSq(finger_idx, i) <
         palm_split_max_distance_.val_ * palm_split_max_distance_.val_;
     if (close_enough_together && !too_close_together) {
-      was_near_other_fingers_.insert(fs.tracking_id);
+      finger_contacts_[finger_idx]->was_near_other_fingers = true;
       return true;
     }
   }
@@ -163,36 +162,34 @@ bool PalmClassifyingFilterInterpreter::FingerInBottomArea(
 
 void PalmClassifyingFilterInterpreter::UpdatePalmState(
     const HardwareState& hwstate) {
-  RemoveMissingIdsFromSet(&palm_, hwstate);
-  RemoveMissingIdsFromSet(&large_palm_, hwstate);
-  RemoveMissingIdsFromMap(&pointing_, hwstate);
-  RemoveMissingIdsFromSet(&non_stationary_palm_, hwstate);
-  RemoveMissingIdsFromSet(&fingers_not_in_edge_, hwstate);
-  RemoveMissingIdsFromSet(&was_near_other_fingers_, hwstate);
-
   // Some finger(s) just leaves, skip this update for stability
-  if (prev_fingerstates_.size() > hwstate.finger_cnt)
+  if (static_cast<size_t>(__builtin_popcountll(prev_present_)) >
+      hwstate.finger_cnt)
     return;
 
-  for (short i = 0; i < hwstate.finger_cnt; i++) {
+  const size_t finger_cnt =
+      std::min<size_t>(hwstate.finger_cnt, kMaxFingerSlots);
+  for (size_t i = 0; i < finger_cnt; i++) {
     const FingerState& fs = hwstate.fingers[i];
+    Contact* contact = finger_contacts_[i];
+    if (!contact)
+      continue;
     if (!(FingerInPalmEnvelope(fs) || FingerInBottomArea(fs)))
-      fingers_not_in_edge_.insert(fs.tracking_id);
+      contact->not_in_edge = true;
     // Mark anything over the palm thresh as a palm
     if (fs.pressure >= palm_pressure_.val_ ||
         fs.touch_major >= multi_palm_width_.val_) {
-      large_palm_.insert(fs.tracking_id);
-      palm_.insert(fs.tracking_id);
-      pointing_.erase(fs.tracking_id);
-      continue;
+      contact->large_palm = true;
+      contact->palm = true;
+      contact->pointing = 0;
     }
   }
 
-  if (hwstate.finger_cnt == 1 &&
+  if (hwstate.finger_cnt == 1 && finger_contacts_[0] &&
       hwstate.fingers[0].touch_major >= palm_width_.val_) {
-    large_palm_.insert(hwstate.fingers[0].tracking_id);
-    palm_.insert(hwstate.fingers[0].tracking_id);
-    pointing_.erase(hwstate.fingers[0].tracking_id);
+    finger_contacts_[0]->large_palm = true;
+    finger_contacts_[0]->palm = true;
+    finger_contacts_[0]->pointing = 0;
   }
 
   const float kPalmStationaryDistSq =
@@ -203,22 +200,25 @@ void PalmClassifyingFilterInterpreter::UpdatePalmState(
       palm_pressure_.val_ * fat_finger_pressure_ratio_.val_;
   const float kFatFingerMaxWidth =
       palm_width_.val_ * fat_finger_width_ratio_.val_;
+  const float min_dist = palm_pointing_min_dist_.val_;
+  const float max_reverse_dist = palm_pointing_max_reverse_dist_.val_;
 
-  for (short i = 0; i < hwstate.finger_cnt; i++) {
+  for (size_t i = 0; i < finger_cnt; i++) {
     const FingerState& fs = hwstate.fingers[i];
-    bool prev_palm = SetContainsValue(palm_, fs.tracking_id);
-    bool prev_pointing = MapContainsKey(pointing_, fs.tracking_id);
+    Contact* contact = finger_contacts_[i];
+    if (!contact)
+      continue;
 
-    if (prev_palm) {
+    if (contact->palm) {
       // If the finger's pressure & width are more like a fat finger
       // and it has moved a lot, it might be a fat finger and remove
       // it from palm.
-      float dist_sq = DistSq(origin_fingerstates_[fs.tracking_id], fs);
-      if (max_pressure_[fs.tracking_id] <= kFatFingerMaxPressure &&
-          max_width_[fs.tracking_id] <= kFatFingerMaxWidth &&
+      float dist_sq = DistSq(contact->origin, fs);
+      if (contact->max_pressure <= kFatFingerMaxPressure &&
+          contact->max_width <= kFatFingerMaxWidth &&
           dist_sq > kFatFingerMinDistSq) {
-        large_palm_.erase(fs.tracking_id);
-        palm_.erase(fs.tracking_id);
+        contact->large_palm = false;
+        contact->palm = false;
       } else {
         // Lock onto palm
         continue;
@@ -227,87 +227,76 @@ void PalmClassifyingFilterInterpreter::UpdatePalmState(
 
     // If the finger is recently placed, remove it from pointing/fingers.
     // If it's still looking like pointing, it'll get readded.
-    if (FingerAge(fs.tracking_id, hwstate.timestamp) <
-        palm_eval_timeout_.val_) {
-      pointing_.erase(fs.tracking_id);
-
-      prev_pointing = false;
-    }
+    if (FingerAge(*contact, hwstate.timestamp) < palm_eval_timeout_.val_)
+      contact->pointing = 0;
     // If another finger is close by, let this be pointing
     bool near_finger = FingerNearOtherFinger(hwstate, i);
     bool on_edge = FingerInPalmEnvelope(fs) ||
         FingerInBottomArea(fs);
-    if (!prev_pointing && (near_finger || !on_edge)) {
-      unsigned reason = (near_finger ? kPointCloseToFinger : 0) |
+    if (!contact->pointing && (near_finger || !on_edge)) {
+      contact->pointing = (near_finger ? kPointCloseToFinger : 0) |
           ((!on_edge) ? kPointNotInEdge : 0);
-      pointing_[fs.tracking_id] = reason;
     }
 
     // Check if fingers that only move within palm envelope are pointing.
-    int id = fs.tracking_id;
-    float min_dist = palm_pointing_min_dist_.val_;
-    float max_reverse_dist = palm_pointing_max_reverse_dist_.val_;
-
+    //
     // Ideally, we want to say that a finger is pointing if it moves only in
     // one direction significantly without zig-zag. But due to touch sensor's
     // inaccuratcy, we make the rule to be that a finger has to move in one
     // direction significantly with little move in the opposite direction.
-    for (size_t j = 0; j < arraysize(distance_positive_); j++)
-      if ((distance_positive_[j][id] >= min_dist &&
-           distance_negative_[j][id] <= max_reverse_dist) ||
-          (distance_positive_[j][id] <= max_reverse_dist &&
-           distance_negative_[j][id] >= min_dist)) {
-        pointing_[id] |= kPointMoving;
+    for (size_t j = 0; j < arraysize(contact->distance_positive); j++)
+      if ((contact->distance_positive[j] >= min_dist &&
+           contact->distance_negative[j] <= max_reverse_dist) ||
+          (contact->distance_positive[j] <= max_reverse_dist &&
+           contact->distance_negative[j] >= min_dist)) {
+        contact->pointing |= kPointMoving;
       }
 
     // However, if the contact has been stationary for a while since it
     // touched down, it is a palm. We track a potential palm closely for the
     // first amount of time to see if it fits this pattern.
-    if (FingerAge(fs.tracking_id, prev_time_) >
-        palm_stationary_time_.val_ ||
-        SetContainsValue(non_stationary_palm_, fs.tracking_id)) {
+    if (FingerAge(*contact, prev_time_) > palm_stationary_time_.val_ ||
+        contact->non_stationary_palm) {
       // Finger is too old to reconsider or is moving a lot
       continue;
     }
-    if (DistSq(origin_fingerstates_[fs.tracking_id], fs) >
-        kPalmStationaryDistSq || !(FingerInPalmEnvelope(fs) ||
-                                   FingerInBottomArea(fs))) {
+    if (DistSq(contact->origin, fs) > kPalmStationaryDistSq ||
+        !(FingerInPalmEnvelope(fs) || FingerInBottomArea(fs))) {
       // Finger moving a lot or not in palm envelope; not a stationary palm.
-      non_stationary_palm_.insert(fs.tracking_id);
+      contact->non_stationary_palm = true;
       continue;
     }
-    if (FingerAge(fs.tracking_id, prev_time_) <=
-        palm_stationary_time_.val_ &&
-        FingerAge(fs.tracking_id, hwstate.timestamp) >
-        palm_stationary_time_.val_ &&
-        !SetContainsValue(non_stationary_palm_, fs.tracking_id) &&
+    if (FingerAge(*contact, hwstate.timestamp) > palm_stationary_time_.val_ &&
         !FingerNearOtherFinger(hwstate, i)) {
       // Enough time has passed. Make this stationary contact a palm.
-      palm_.insert(fs.tracking_id);
-      pointing_.erase(fs.tracking_id);
+      contact->palm = true;
+      contact->pointing = 0;
     }
   }
 }
 
 void PalmClassifyingFilterInterpreter::UpdatePalmFlags(HardwareState* hwstate) {
-  for (short i = 0; i < hwstate->finger_cnt; i++) {
+  const size_t finger_cnt =
+      std::min<size_t>(hwstate->finger_cnt, kMaxFingerSlots);
+  for (size_t i = 0; i < finger_cnt; i++) {
     FingerState* fs = &hwstate->fingers[i];
-    if (SetContainsValue(large_palm_, fs->tracking_id)) {
+    const Contact* contact = finger_contacts_[i];
+    if (!contact)
+      continue;
+    if (contact->large_palm) {
       fs->flags |= GESTURES_FINGER_LARGE_PALM;
     }
-    if (SetContainsValue(palm_, fs->tracking_id)) {
+    if (contact->palm) {
       fs->flags |= GESTURES_FINGER_PALM;
-    } else if (!MapContainsKey(pointing_, fs->tracking_id) &&
-               !SetContainsValue(was_near_other_fingers_, fs->tracking_id)) {
+    } else if (!contact->pointing && !contact->was_near_other_fingers) {
       if (FingerInPalmEnvelope(*fs)) {
         fs->flags |= GESTURES_FINGER_PALM;
       } else if (FingerInBottomArea(*fs)) {
         fs->flags |= (GESTURES_FINGER_WARP_X | GESTURES_FINGER_WARP_Y);
       }
-    } else if (MapContainsKey(pointing_, fs->tracking_id) &&
-               FingerInPalmEnvelope(*fs)) {
+    } else if (contact->pointing && FingerInPalmEnvelope(*fs)) {
       fs->flags |= GESTURES_FINGER_POSSIBLE_PALM;
-      if (pointing_[fs->tracking_id] == kPointCloseToFinger &&
+      if (contact->pointing == kPointCloseToFinger &&
           !FingerNearOtherFinger(*hwstate, i)) {
         // Finger was near another finger, but it's not anymore, and it was
         // only this other finger that caused it to point. Mark it w/ warp
@@ -319,13 +308,4 @@ void PalmClassifyingFilterInterpreter::UpdatePalmFlags(HardwareState* hwstate) {
   }
 }
 
-stime_t PalmClassifyingFilterInterpreter::FingerAge(short finger_id,
-                                                    stime_t now) const {
-  if (!MapContainsKey(origin_timestamps_, finger_id)) {
-    Err("Don't have record of finger age for finger %d", finger_id);
-    return -1;
-  }
-  return now - origin_timestamps_.at(finger_id);
-}
-
 }  // namespace gestures
@@ -100,24 +100,24 @@ TEST(PalmClassifyingFilterInterpreterTest, PalmTest) {
     wrapper.SyncInterpret(&hardware_state[i], NULL);
     switch (i) {
       case 0:
-        EXPECT_TRUE(SetContainsValue(pci.pointing_, 1));
-        EXPECT_FALSE(SetContainsValue(pci.palm_, 1));
-        EXPECT_TRUE(SetContainsValue(pci.pointing_, 2));
-        EXPECT_FALSE(SetContainsValue(pci.palm_, 2));
+        EXPECT_TRUE(pci.IsPointing(1));
+        EXPECT_FALSE(pci.IsPalm(1));
+        EXPECT_TRUE(pci.IsPointing(2));
+        EXPECT_FALSE(pci.IsPalm(2));
         break;
       case 1:  // fallthrough
       case 2:
-        EXPECT_TRUE(SetContainsValue(pci.pointing_, 1));
-        EXPECT_FALSE(SetContainsValue(pci.palm_, 1));
-        EXPECT_FALSE(SetContainsValue(pci.pointing_, 2));
-        EXPECT_TRUE(SetContainsValue(pci.palm_, 2));
+        EXPECT_TRUE(pci.IsPointing(1));
+        EXPECT_FALSE(pci.IsPalm(1));
+        EXPECT_FALSE(pci.IsPointing(2));
+        EXPECT_TRUE(pci.IsPalm(2));
         break;
       case 3:  // fallthrough
       case 4:
-        EXPECT_TRUE(SetContainsValue(pci.pointing_, 3)) << "i=" << i;
-        EXPECT_FALSE(SetContainsValue(pci.palm_, 3));
-        EXPECT_FALSE(SetContainsValue(pci.pointing_, 4));
-        EXPECT_TRUE(SetContainsValue(pci.palm_, 4));
+        EXPECT_TRUE(pci.IsPointing(3)) << "i=" << i;
+        EXPECT_FALSE(pci.IsPalm(3));
+        EXPECT_FALSE(pci.IsPointing(4));
+        EXPECT_TRUE(pci.IsPalm(4));
         break;
     }
   }
@@ -174,11 +174,11 @@ TEST(PalmClassifyingFilterInterpreterTest, StationaryPalmTest) {
     if (i > 0) {
       // We expect after the second input frame is processed that the palm
       // is classified
-      EXPECT_FALSE(SetContainsValue(pci.pointing_, 1));
-      EXPECT_TRUE(SetContainsValue(pci.palm_, 1));
+      EXPECT_FALSE(pci.IsPointing(1));
+      EXPECT_TRUE(pci.IsPalm(1));
     }
     if (hardware_state[i].finger_cnt > 1)
-      EXPECT_TRUE(SetContainsValue(pci.pointing_, 2)) << "i=" << i;
+      EXPECT_TRUE(pci.IsPointing(2)) << "i=" << i;
   }
 }
 
@@ -391,10 +391,51 @@ TEST(PalmClassifyingFilterInterpreterTest, PalmReevaluateTest) {
     stime_t age = inputs[i].now_ - inputs[0].now_;
     if (age < pci.palm_eval_timeout_.val_)
       continue;
-    EXPECT_FALSE(SetContainsValue(pci.pointing_, 1));
+    EXPECT_FALSE(pci.IsPointing(1));
   }
 }
 
+TEST(PalmClassifyingFilterInterpreterTest, ReturningIdTest) {
+  PalmClassifyingFilterInterpreter pci(NULL, NULL, NULL);
+  HardwareProperties hwprops = {
+    0, 0, 1000, 1000,  // left, top, right, bottom
+    500, 500,  // x res, y res
+    96, 96,  // screen DPI x, y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    2, 5,  // max fingers, max touch
+    0, 0, 1,  // t5r2, semi-mt, is button pad
+    0, 0,  // has_wheel, wheel_is_hi_res
+    0,  // is haptic pad
+  };
+  TestInterpreterWrapper wrapper(&pci, &hwprops);
+
+  const float kBig = pci.palm_pressure_.val_ + 1;  // big (palm) pressure
+  const float kSml = pci.palm_pressure_.val_ - 1;  // low pressure
+
+  FingerState finger_states[] = {
+    // TM, Tm, WM, Wm, Press, Orientation, X, Y, TrID
+    {0, 0, 0, 0, kBig, 0, 500, 500, 1, 0},
+    {0, 0, 0, 0, kSml, 0, 500, 500, 1, 0},
+  };
+  HardwareState hardware_state[] = {
+    // time, buttons, finger count, touch count, finger states pointer
+    make_hwstate(1.00, 0, 1, 1, &finger_states[0]),
+    make_hwstate(1.01, 0, 0, 0, NULL),
+    make_hwstate(1.02, 0, 1, 1, &finger_states[1]),
+  };
+
+  wrapper.SyncInterpret(&hardware_state[0], NULL);
+  EXPECT_TRUE(pci.IsPalm(1));
+  wrapper.SyncInterpret(&hardware_state[1], NULL);
+  EXPECT_FALSE(pci.IsPalm(1));
+  // The same tracking id coming back is a new contact, which doesn't inherit
+  // the palm state of the old one.
+  wrapper.SyncInterpret(&hardware_state[2], NULL);
+  EXPECT_FALSE(pci.IsPalm(1));
+  EXPECT_EQ(0, hardware_state[2].fingers[0].flags & GESTURES_FINGER_PALM);
+}
+
 namespace {
 struct LargeTouchMajorTestInputs {
   stime_t now_;
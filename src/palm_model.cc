@@ -0,0 +1,188 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "include/palm_model.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+namespace gestures {
+
+// Feature scales put the interesting range of each feature in [-127, 127]:
+// pressure in steps of 2, widths in 1/8 mm, edge distances in 1/4 mm, speed
+// in steps of 2 mm/s and age in 10 ms. The pressure and width offsets sit
+// one step below the palm thresholds, so values at the thresholds quantize
+// to 1.
+const PalmModelWeights kDefaultPalmModel = {
+  // input_offset
+  { 198.0, 21.075, 0.0, 198.0, 21.075, 0.0, 0.0, 0.0,
+    0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
+  // input_scale
+  { 0.5, 8.0, 4.0, 0.5, 8.0, 4.0, 4.0, 4.0,
+    0.5, 0.5, 8.0, 16.0, 100.0, 4.0, 16.0, 2.0 },
+  // hidden_weights
+  {
+    // Pressed harder than a finger can.
+    { 0, 0, 0, 16, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+    // Wider than a finger.
+    { 0, 0, 0, 0, 16, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+    // Resting on the bottom edge.
+    { 0, 0, 0, 0, 0, 0, -2, 0, -4, 0, 0, 0, 0, 0, 0, 0 },
+    // Resting on a side edge.
+    { 0, 0, 0, 0, 0, -2, 0, 0, -4, 0, 0, 0, 0, 0, 0, 0 },
+    { 0 }, { 0 }, { 0 }, { 0 },
+  },
+  // hidden_bias
+  { 0, 0, 60, 60, 0, 0, 0, 0 },
+  0,  // hidden_shift
+  // output_weights
+  { 64, 64, 8, 8, 0, 0, 0, 0 },
+  0,  // output_bias
+  1.0 / 512,  // output_scale
+};
+
+namespace {
+
+int8_t Saturate(int32_t val) {
+  return std::min(127, std::max(-127, val));
+}
+
+}  // namespace {}
+
+void QuantizePalmFeatures(const PalmModelWeights& weights,
+                          const float* features, int8_t* out) {
+  for (size_t i = 0; i < kPalmFeatureCount; i++) {
+    float val = (features[i] - weights.input_offset[i]) *
+        weights.input_scale[i];
+    val = std::min(127.0f, std::max(-127.0f, val));
+    out[i] = static_cast<int8_t>(lrintf(val));
+  }
+}
+
+float ScorePalmFeatures(const PalmModelWeights& weights, const int8_t* q) {
+  // Fixed trip counts and int32 accumulators, so the compiler can unroll and
+  // vectorize both layers.
+  int8_t hidden[kPalmModelHidden];
+  for (size_t j = 0; j < kPalmModelHidden; j++) {
+    int32_t acc = weights.hidden_bias[j];
+    for (size_t i = 0; i < kPalmFeatureCount; i++)
+      acc += static_cast<int32_t>(weights.hidden_weights[j][i]) * q[i];
+    hidden[j] = Saturate(std::max(0, acc) >> weights.hidden_shift);
+  }
+  int32_t out = weights.output_bias;
+  for (size_t j = 0; j < kPalmModelHidden; j++)
+    out += static_cast<int32_t>(weights.output_weights[j]) * hidden[j];
+  return out * weights.output_scale;
+}
+
+float EvaluatePalmModel(const PalmModelWeights& weights,
+                        const float* features) {
+  int8_t q[kPalmFeatureCount];
+  QuantizePalmFeatures(weights, features, q);
+  return ScorePalmFeatures(weights, q);
+}
+
+PalmFeatureExtractor::PalmFeatureExtractor()
+    : prev_present_(0), present_(0) {
+  memset(contacts_, 0, sizeof(contacts_));
+}
+
+void PalmFeatureExtractor::Update(const HardwareState& hwstate) {
+  finger_slots_.Update(hwstate);
+  prev_present_ = present_;
+  present_ = 0;
+  for (size_t i = 0; i < hwstate.finger_cnt; i++) {
+    const FingerState& fs = hwstate.fingers[i];
+    int slot = finger_slots_.SlotForId(fs.tracking_id);
+    if (slot < 0)
+      continue;
+    uint64_t bit = static_cast<uint64_t>(1) << slot;
+    present_ |= bit;
+    Contact* contact = &contacts_[slot];
+    if (!(prev_present_ & bit)) {
+      // A new contact.
+      contact->origin_time = hwstate.timestamp;
+      contact->origin_x = fs.position_x;
+      contact->origin_y = fs.position_y;
+      contact->max_pressure = fs.pressure;
+      contact->max_touch_major = fs.touch_major;
+      contact->head = 0;
+      contact->size = 0;
+    } else {
+      contact->max_pressure = std::max(contact->max_pressure, fs.pressure);
+      contact->max_touch_major = std::max(contact->max_touch_major,
+                                          fs.touch_major);
+      contact->head = (contact->head + 1) % kPalmHistorySize;
+    }
+    size_t head = contact->head;
+    contact->time[head] = hwstate.timestamp;
+    contact->x[head] = fs.position_x;
+    contact->y[head] = fs.position_y;
+    contact->pressure[head] = fs.pressure;
+    contact->touch_major[head] = fs.touch_major;
+    contact->size = std::min(contact->size + 1, kPalmHistorySize);
+  }
+}
+
+bool PalmFeatureExtractor::Features(const HardwareProperties& hwprops,
+                                    const HardwareState& hwstate,
+                                    size_t finger_idx, float* out) const {
+  const FingerState& fs = hwstate.fingers[finger_idx];
+  int slot = finger_slots_.SlotForId(fs.tracking_id);
+  if (slot < 0 || !((present_ >> slot) & 1))
+    return false;
+  const Contact& contact = contacts_[slot];
+
+  out[kPalmFeaturePressure] = fs.pressure;
+  out[kPalmFeatureTouchMajor] = fs.touch_major;
+  out[kPalmFeatureTouchMinor] = fs.touch_minor;
+  out[kPalmFeatureMaxPressure] = contact.max_pressure;
+  out[kPalmFeatureMaxTouchMajor] = contact.max_touch_major;
+  out[kPalmFeatureSideEdgeDist] =
+      std::max(0.0f, std::min(fs.position_x - hwprops.left,
+                              hwprops.right - fs.position_x));
+  out[kPalmFeatureBottomEdgeDist] =
+      std::max(0.0f, hwprops.bottom - fs.position_y);
+  out[kPalmFeatureTopEdgeDist] = std::max(0.0f, fs.position_y - hwprops.top);
+
+  // Walk the history from the oldest frame to the newest.
+  size_t oldest = (contact.head + kPalmHistorySize + 1 - contact.size) %
+      kPalmHistorySize;
+  float path = 0.0;
+  for (size_t k = 1; k < contact.size; k++) {
+    size_t cur = (oldest + k) % kPalmHistorySize;
+    size_t prev = (oldest + k - 1) % kPalmHistorySize;
+    path += hypotf(contact.x[cur] - contact.x[prev],
+                   contact.y[cur] - contact.y[prev]);
+  }
+  float displacement = hypotf(contact.x[contact.head] - contact.x[oldest],
+                              contact.y[contact.head] - contact.y[oldest]);
+  stime_t duration = contact.time[contact.head] - contact.time[oldest];
+  out[kPalmFeatureSpeed] = duration > 0.0 ? displacement / duration : 0.0;
+  out[kPalmFeaturePressureChange] =
+      contact.pressure[contact.head] - contact.pressure[oldest];
+  out[kPalmFeatureTouchMajorChange] =
+      contact.touch_major[contact.head] - contact.touch_major[oldest];
+  out[kPalmFeatureJitter] = path - displacement;
+
+  out[kPalmFeatureAge] = hwstate.timestamp - contact.origin_time;
+  out[kPalmFeatureTravel] = hypotf(fs.position_x - contact.origin_x,
+                                   fs.position_y - contact.origin_y);
+  out[kPalmFeatureFingerCount] = hwstate.finger_cnt;
+
+  float nearest_sq = kPalmNoNeighborDist * kPalmNoNeighborDist;
+  for (size_t i = 0; i < hwstate.finger_cnt; i++) {
+    if (i == finger_idx)
+      continue;
+    float dx = hwstate.fingers[i].position_x - fs.position_x;
+    float dy = hwstate.fingers[i].position_y - fs.position_y;
+    nearest_sq = std::min(nearest_sq, dx * dx + dy * dy);
+  }
+  out[kPalmFeatureNearestDist] = sqrtf(nearest_sq);
+  return true;
+}
+
+}  // namespace gestures
@@ -0,0 +1,99 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "include/palm_training_exporter.h"
+
+#include <vector>
+
+#include "include/activity_replay.h"
+#include "include/finger_metrics.h"
+#include "include/interpreter.h"
+#include "include/logging.h"
+#include "include/palm_classifying_filter_interpreter.h"
+#include "include/palm_model.h"
+#include "include/prop_registry.h"
+#include "include/scaling_filter_interpreter.h"
+#include "include/string_util.h"
+
+using std::string;
+
+namespace gestures {
+
+namespace {
+
+// Sits where LearnedPalmFilterInterpreter would, past a heuristic palm
+// classifier, and writes a row for each contact it's sent.
+class PalmFeatureRecorder : public Interpreter {
+ public:
+  explicit PalmFeatureRecorder(string* out)
+      : Interpreter(NULL, NULL, false), out_(out) {}
+
+  virtual void SyncInterpret(HardwareState* hwstate, stime_t* timeout) {
+    features_.Update(*hwstate);
+    for (size_t i = 0; i < hwstate->finger_cnt; i++) {
+      const FingerState& fs = hwstate->fingers[i];
+      float features[kPalmFeatureCount];
+      if (!features_.Features(*hwprops_, *hwstate, i, features))
+        continue;
+      int label = 0;
+      if (fs.flags & GESTURES_FINGER_PALM)
+        label = 2;
+      else if (fs.flags & GESTURES_FINGER_POSSIBLE_PALM)
+        label = 1;
+      out_->append(StringPrintf("%.6f,%d", hwstate->timestamp,
+                                fs.tracking_id));
+      for (size_t j = 0; j < kPalmFeatureCount; j++)
+        out_->append(StringPrintf(",%g", features[j]));
+      out_->append(StringPrintf(",%d\n", label));
+    }
+  }
+
+  virtual void HandleTimer(stime_t now, stime_t* timeout) {}
+
+ private:
+  PalmFeatureExtractor features_;
+  string* out_;
+};
+
+}  // namespace {}
+
+string ExportPalmTrainingData(const string& log_data) {
+  ActivityReplay replay(NULL);
+  if (!replay.Parse(log_data)) {
+    Err("Unable to parse activity log");
+    return "";
+  }
+
+  string out = "time,tracking_id";
+  for (size_t i = 0; i < kPalmFeatureCount; i++)
+    out.append(StringPrintf(",f%zu", i));
+  out.append(",label\n");
+
+  PropRegistry prop_reg;
+  MetricsProperties mprops(&prop_reg);
+  Interpreter* temp = new PalmFeatureRecorder(&out);
+  temp = new PalmClassifyingFilterInterpreter(&prop_reg, temp, NULL);
+  ScalingFilterInterpreter chain(&prop_reg, temp, NULL,
+                                 GESTURES_DEVCLASS_TOUCHPAD);
+  if (!prop_reg.ApplyProperties(replay.properties()))
+    Err("Unable to apply some logged properties");
+  chain.Initialize(&replay.hwprops(), NULL, &mprops, NULL);
+
+  // Interpreters modify fingers in place, so each state gets a copy of them.
+  std::vector<FingerState> fingers;
+  ActivityLog* log = replay.log();
+  for (size_t i = 0; i < log->size(); ++i) {
+    const ActivityLog::Entry* entry = log->GetEntry(i);
+    if (entry->type != ActivityLog::kHardwareState)
+      continue;
+    HardwareState hs = entry->details.hwstate;
+    fingers.assign(hs.fingers, hs.fingers + hs.finger_cnt);
+    hs.fingers = fingers.data();
+    stime_t timeout = NO_DEADLINE;
+    chain.SyncInterpret(&hs, &timeout);
+  }
+  return out;
+}
+
+}  // namespace gestures
@@ -0,0 +1,94 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdlib.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "include/gestures.h"
+#include "include/palm_model.h"
+#include "include/palm_training_exporter.h"
+#include "include/prop_registry.h"
+#include "include/string_util.h"
+#include "include/touch_stream_generator.h"
+
+namespace gestures {
+
+class PalmTrainingExporterTest : public ::testing::Test {};
+
+TEST(PalmTrainingExporterTest, ExportTest) {
+  HardwareProperties hwprops = {
+    0, 0, 1000, 600,  // left, top, right, bottom
+    10, 10,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch,
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  std::unique_ptr<GestureInterpreter> gi(NewGestureInterpreter());
+  gi->Initialize(GESTURES_DEVCLASS_TOUCHPAD);
+  Property* logging = gi->prop_reg()->FindProperty("Event Logging Enable");
+  ASSERT_NE(nullptr, logging);
+  logging->SetValue(Json::Value(true));
+  logging->HandleGesturesPropWritten();
+  gi->SetHardwareProperties(hwprops);
+
+  // A resting palm with two fingers moving above it.
+  TouchStreamConfig config;
+  config.rate = 100.0;
+  TouchStreamGenerator generator(hwprops, config);
+  generator.AddSegment(kTouchSegmentPalm, 3, 0.3);
+  size_t contacts = 0;
+  short palm_id = -1;
+  while (HardwareState* hs = generator.Next()) {
+    contacts += hs->finger_cnt;
+    if (hs->finger_cnt)
+      palm_id = hs->fingers[0].tracking_id;
+    gi->PushHardwareState(hs);
+  }
+  ASSERT_GT(contacts, 0);
+
+  std::string csv = ExportPalmTrainingData(gi->EncodeActivityLog());
+  std::vector<std::string> lines;
+  SplitString(csv, '\n', &lines);
+  if (!lines.empty() && lines.back().empty())
+    lines.pop_back();
+  ASSERT_EQ(contacts + 1, lines.size());
+  EXPECT_EQ(0, lines[0].find("time,tracking_id,f0,"));
+
+  // Columns: time, id, features, label.
+  const size_t kColumns = kPalmFeatureCount + 3;
+  size_t palm_rows = 0;
+  for (size_t i = 1; i < lines.size(); i++) {
+    std::vector<std::string> columns;
+    SplitString(lines[i], ',', &columns);
+    ASSERT_EQ(kColumns, columns.size()) << lines[i];
+    short id = atoi(columns[1].c_str());
+    int label = atoi(columns.back().c_str());
+    float pressure = atof(columns[2 + kPalmFeaturePressure].c_str());
+    float width = atof(columns[2 + kPalmFeatureTouchMajor].c_str());
+    if (id == palm_id) {
+      // The palm is 25 mm wide once scaled, and labeled a palm.
+      EXPECT_NEAR(25.0, width, 0.01);
+      EXPECT_FLOAT_EQ(200.0, pressure);
+      EXPECT_EQ(2, label);
+      palm_rows++;
+    } else {
+      EXPECT_NEAR(8.0, width, 0.01);
+    }
+  }
+  EXPECT_GT(palm_rows, 0);
+
+  EXPECT_EQ("", ExportPalmTrainingData("not a log"));
+}
+
+}  // namespace gestures
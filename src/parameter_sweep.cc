@@ -0,0 +1,261 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "include/parameter_sweep.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "include/finger_metrics.h"
+#include "include/logging.h"
+#include "include/prop_registry.h"
+
+using std::string;
+
+namespace gestures {
+
+namespace {
+
+// Building and destroying a GestureInterpreter touches process-wide state
+// (the trace marker), so only one thread does it at a time.
+std::mutex chain_lock;
+
+bool ValuesNear(double a, double b, double tolerance) {
+  return fabs(a - b) <= tolerance * std::max(1.0, std::max(fabs(a), fabs(b)));
+}
+
+// Collects a chain's output and diffs it against the logged gestures.
+class SweepConsumer {
+ public:
+  SweepConsumer(SweepResult* result, double time_tolerance,
+                double value_tolerance)
+      : result_(result),
+        time_tolerance_(time_tolerance),
+        value_tolerance_(value_tolerance) {}
+
+  void ConsumeGesture(const Gesture& gesture) {
+    result_->gestures.push_back(gesture);
+    pending_.push_back(gesture);
+    switch (gesture.type) {
+      case kGestureTypeMove:
+        result_->move_distance +=
+            hypot(gesture.details.move.dx, gesture.details.move.dy);
+        break;
+      case kGestureTypeScroll:
+        result_->scroll_distance +=
+            hypot(gesture.details.scroll.dx, gesture.details.scroll.dy);
+        break;
+      case kGestureTypeMouseWheel:
+        result_->scroll_distance +=
+            hypot(gesture.details.wheel.dx, gesture.details.wheel.dy);
+        break;
+      case kGestureTypeButtonsChange:
+        result_->buttons_changes++;
+        break;
+      case kGestureTypeFling:
+        result_->flings++;
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Matches a logged gesture against the output produced so far. Output
+  // skipped over on the way to a match is unexpected.
+  void MatchLogged(const Gesture& logged) {
+    while (!pending_.empty()) {
+      bool matched = (time_tolerance_ == 0.0 && value_tolerance_ == 0.0) ?
+          pending_.front() == logged :
+          GesturesNear(pending_.front(), logged, time_tolerance_,
+                       value_tolerance_);
+      pending_.pop_front();
+      if (matched) {
+        result_->matched++;
+        return;
+      }
+      result_->unexpected++;
+    }
+    result_->missing++;
+  }
+
+  void Finish() {
+    result_->unexpected += pending_.size();
+    pending_.clear();
+  }
+
+ private:
+  SweepResult* result_;
+  double time_tolerance_;
+  double value_tolerance_;
+  std::deque<Gesture> pending_;
+};
+
+void SweepGestureReady(void* data, const Gesture* gesture) {
+  reinterpret_cast<SweepConsumer*>(data)->ConsumeGesture(*gesture);
+}
+
+}  // namespace {}
+
+bool GesturesNear(const Gesture& a, const Gesture& b, double time_tolerance,
+                  double value_tolerance) {
+  if (a.type != b.type)
+    return false;
+  if (fabs(a.start_time - b.start_time) > time_tolerance ||
+      fabs(a.end_time - b.end_time) > time_tolerance)
+    return false;
+  double tol = value_tolerance;
+  switch (a.type) {
+    case kGestureTypeMove:
+      return ValuesNear(a.details.move.dx, b.details.move.dx, tol) &&
+          ValuesNear(a.details.move.dy, b.details.move.dy, tol);
+    case kGestureTypeScroll:
+      return ValuesNear(a.details.scroll.dx, b.details.scroll.dx, tol) &&
+          ValuesNear(a.details.scroll.dy, b.details.scroll.dy, tol);
+    case kGestureTypeMouseWheel:
+      return ValuesNear(a.details.wheel.dx, b.details.wheel.dx, tol) &&
+          ValuesNear(a.details.wheel.dy, b.details.wheel.dy, tol) &&
+          ValuesNear(a.details.wheel.tick_120ths_dx,
+                     b.details.wheel.tick_120ths_dx, tol) &&
+          ValuesNear(a.details.wheel.tick_120ths_dy,
+                     b.details.wheel.tick_120ths_dy, tol);
+    case kGestureTypePinch:
+      return ValuesNear(a.details.pinch.dz, b.details.pinch.dz, tol);
+    case kGestureTypeButtonsChange:
+      return a.details.buttons.down == b.details.buttons.down &&
+          a.details.buttons.up == b.details.buttons.up;
+    case kGestureTypeFling:
+      return ValuesNear(a.details.fling.vx, b.details.fling.vx, tol) &&
+          ValuesNear(a.details.fling.vy, b.details.fling.vy, tol);
+    case kGestureTypeSwipe:
+      return ValuesNear(a.details.swipe.dx, b.details.swipe.dx, tol) &&
+          ValuesNear(a.details.swipe.dy, b.details.swipe.dy, tol);
+    case kGestureTypeFourFingerSwipe:
+      return ValuesNear(a.details.four_finger_swipe.dx,
+                        b.details.four_finger_swipe.dx, tol) &&
+          ValuesNear(a.details.four_finger_swipe.dy,
+                     b.details.four_finger_swipe.dy, tol);
+    case kGestureTypeMetrics:
+      return a.details.metrics.type == b.details.metrics.type &&
+          ValuesNear(a.details.metrics.data[0], b.details.metrics.data[0],
+                     tol) &&
+          ValuesNear(a.details.metrics.data[1], b.details.metrics.data[1],
+                     tol);
+    default:
+      return true;
+  }
+}
+
+ParameterSweep::ParameterSweep()
+    : replay_(NULL), time_tolerance_(0.0), value_tolerance_(0.0) {}
+
+bool ParameterSweep::Parse(const string& data) {
+  return replay_.Parse(data);
+}
+
+std::vector<SweepResult> ParameterSweep::Run(
+    const std::vector<SweepConfig>& configs,
+    GestureInterpreterDeviceClass cls,
+    size_t max_threads) {
+  std::vector<SweepResult> results(configs.size());
+  if (!max_threads)
+    max_threads = std::max(1u, std::thread::hardware_concurrency());
+  size_t num_threads = std::min(max_threads, configs.size());
+
+  // Workers take the next config until none are left.
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < configs.size(); i = next++)
+      RunOne(configs[i], cls, &results[i]);
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; i++)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread& thread : threads)
+    thread.join();
+  return results;
+}
+
+void ParameterSweep::RunOne(const SweepConfig& config,
+                            GestureInterpreterDeviceClass cls,
+                            SweepResult* result) {
+  result->name = config.name;
+  GestureInterpreter* gi;
+  {
+    std::lock_guard<std::mutex> lock(chain_lock);
+    gi = NewGestureInterpreter();
+    gi->Initialize(cls);
+  }
+  PropRegistry* prop_reg = gi->prop_reg();
+  {
+    if (!prop_reg->ApplyProperties(replay_.properties()))
+      Err("Unable to apply some logged properties for %s",
+          config.name.c_str());
+    if (!config.overrides.isNull() &&
+        !prop_reg->ApplyProperties(config.overrides)) {
+      Err("Unable to apply overrides for %s", config.name.c_str());
+      result->ok = false;
+    }
+
+    SweepConsumer consumer(result, time_tolerance_, value_tolerance_);
+    gi->SetCallback(SweepGestureReady, &consumer);
+    gi->SetHardwareProperties(replay_.hwprops());
+
+    // The log is shared by all workers, and interpreters modify fingers in
+    // place, so each state gets its own copy of them.
+    std::vector<FingerState> fingers;
+    std::vector<Gesture> logged;
+    ActivityLog* log = replay_.log();
+    for (size_t i = 0; i < log->size(); ++i) {
+      const ActivityLog::Entry* entry = log->GetEntry(i);
+      switch (entry->type) {
+        case ActivityLog::kHardwareState: {
+          HardwareState hs = entry->details.hwstate;
+          fingers.assign(hs.fingers, hs.fingers + hs.finger_cnt);
+          hs.fingers = fingers.data();
+          gi->PushHardwareState(&hs);
+          break;
+        }
+        case ActivityLog::kTimerCallback: {
+          stime_t timeout = NO_DEADLINE;
+          gi->TimerCallback(entry->details.timestamp, &timeout);
+          break;
+        }
+        case ActivityLog::kCallbackRequest:
+          break;
+        case ActivityLog::kGesture:
+          logged.push_back(entry->details.gesture);
+          consumer.MatchLogged(entry->details.gesture);
+          break;
+        case ActivityLog::kPropChange: {
+          const ActivityLog::PropChangeEntry& change =
+              entry->details.prop_change;
+          if (config.overrides.isMember(change.name))
+            break;
+          Property* prop = prop_reg->FindProperty(change.name);
+          if (!prop) {
+            Err("Unable to find prop %s to set.", change.name);
+            break;
+          }
+          prop->SetValue(ActivityReplay::PropChangeValue(change));
+          prop->HandleGesturesPropWritten();
+          break;
+        }
+      }
+    }
+    consumer.Finish();
+    gi->SetCallback(NULL, NULL);
+    result->diff = DiffGestures(logged, result->gestures,
+                                GestureDiffOptions());
+  }
+  std::lock_guard<std::mutex> lock(chain_lock);
+  DeleteGestureInterpreter(gi);
+}
+
+}  // namespace gestures
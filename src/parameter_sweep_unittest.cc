@@ -0,0 +1,69 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "include/gestures.h"
+#include "include/parameter_sweep.h"
+#include "include/unittest_util.h"
+
+namespace gestures {
+
+class ParameterSweepTest : public ::testing::Test {};
+
+TEST(ParameterSweepTest, SweepTest) {
+  ParameterSweep sweep;
+  ASSERT_TRUE(sweep.Parse(RecordMouseActivityLog(20)));
+
+  std::vector<SweepConfig> configs(4);
+  configs[0].name = "logged";
+  configs[1].name = "slow";
+  configs[1].overrides["Pointer Sensitivity"] = Json::Value(1);
+  configs[2].name = "fast";
+  configs[2].overrides["Pointer Sensitivity"] = Json::Value(5);
+  configs[3].name = "bad";
+  configs[3].overrides["Pointer Sensitivity"] = Json::Value("fast");
+
+  std::vector<SweepResult> results =
+      sweep.Run(configs, GESTURES_DEVCLASS_MOUSE, 3);
+  ASSERT_EQ(configs.size(), results.size());
+
+  const SweepResult& logged = results[0];
+  EXPECT_EQ("logged", logged.name);
+  EXPECT_TRUE(logged.ok);
+  EXPECT_EQ(20, logged.gestures.size());
+  EXPECT_EQ(20, logged.matched);
+  EXPECT_EQ(0, logged.missing);
+  EXPECT_EQ(0, logged.unexpected);
+  EXPECT_TRUE(logged.diff.Identical());
+
+  const SweepResult& slow = results[1];
+  const SweepResult& fast = results[2];
+  EXPECT_TRUE(slow.ok);
+  EXPECT_TRUE(fast.ok);
+  EXPECT_GT(slow.unexpected, 0);
+  EXPECT_GT(slow.missing, 0);
+  EXPECT_LT(slow.move_distance, logged.move_distance);
+  EXPECT_GT(fast.move_distance, logged.move_distance);
+  // Same timing, different values.
+  EXPECT_EQ(20, slow.diff.matched());
+  EXPECT_GT(slow.diff.max_deviation(), 0.0);
+
+  EXPECT_FALSE(results[3].ok);
+
+  // The result doesn't depend on how many threads ran the sweep.
+  std::vector<SweepResult> serial =
+      sweep.Run(configs, GESTURES_DEVCLASS_MOUSE, 1);
+  ASSERT_EQ(results.size(), serial.size());
+  for (size_t i = 0; i < results.size(); i++) {
+    EXPECT_EQ(results[i].gestures.size(), serial[i].gestures.size());
+    EXPECT_EQ(results[i].matched, serial[i].matched);
+    EXPECT_DOUBLE_EQ(results[i].move_distance, serial[i].move_distance);
+  }
+}
+
+}  // namespace gestures
@@ -0,0 +1,162 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "include/prediction_filter_interpreter.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "include/util.h"
+
+namespace gestures {
+
+namespace {
+
+// Reports needed to fit a finger's velocity.
+const size_t kMinSamples = 3;
+// Share of the full prediction restored per report after it was turned off.
+const float kConfidenceStep = 1.0 / 3;
+// How much the applied prediction may change per report, relative to how far
+// the finger moved.
+const double kMaxOffsetChange = 0.5;
+
+const unsigned kWarpFlags = GESTURES_FINGER_WARP_X | GESTURES_FINGER_WARP_Y |
+    GESTURES_FINGER_WARP_TELEPORTATION;
+const unsigned kPalmFlags = GESTURES_FINGER_PALM |
+    GESTURES_FINGER_POSSIBLE_PALM | GESTURES_FINGER_LARGE_PALM;
+
+}  // namespace {}
+
+void PredictionFilterInterpreter::History::Push(stime_t now, float pos_x,
+                                                float pos_y) {
+  if (size == kSize) {
+    std::copy(time + 1, time + kSize, time);
+    std::copy(x + 1, x + kSize, x);
+    std::copy(y + 1, y + kSize, y);
+    size--;
+  }
+  time[size] = now;
+  x[size] = pos_x;
+  y[size] = pos_y;
+  size++;
+}
+
+PredictionFilterInterpreter::PredictionFilterInterpreter(
+    PropRegistry* prop_reg, Interpreter* next, Tracer* tracer)
+    : FilterInterpreter(NULL, next, tracer, false),
+      prediction_lead_(prop_reg, "Prediction Lead Time", 0.0),
+      prediction_window_(prop_reg, "Prediction Window", 0.05),
+      min_speed_(prop_reg, "Prediction Min Speed", 20.0),
+      max_distance_(prop_reg, "Prediction Max Distance", 3.0) {
+  InitName();
+}
+
+void PredictionFilterInterpreter::SyncInterpretImpl(HardwareState* hwstate,
+                                                    stime_t* timeout) {
+  if (prediction_lead_.val_ <= 0.0) {
+    histories_.clear();
+    next_->SyncInterpret(hwstate, timeout);
+    return;
+  }
+  RemoveMissingIdsFromMap(&histories_, *hwstate);
+
+  for (size_t i = 0; i < hwstate->finger_cnt; i++) {
+    FingerState* fs = &hwstate->fingers[i];
+    History* history = &histories_[fs->tracking_id];
+    if (fs->flags & kWarpFlags) {
+      // Motion before a warp says nothing about motion after it.
+      history->size = 0;
+      history->confidence = 0.0;
+      history->offset_x = 0.0;
+      history->offset_y = 0.0;
+    }
+    history->Push(hwstate->timestamp, fs->position_x, fs->position_y);
+    Predict(history, fs);
+  }
+  next_->SyncInterpret(hwstate, timeout);
+}
+
+void PredictionFilterInterpreter::Predict(History* history,
+                                          FingerState* fs) {
+  double target_x = 0.0, target_y = 0.0;
+  if (!FitOffset(history, fs->flags, &target_x, &target_y))
+    history->confidence = 0.0;
+
+  // Move the applied offset toward the fitted one, no faster than the finger
+  // moves. Turning prediction off, as on a reversal, then drains the lead
+  // over a few reports rather than snapping the finger back by up to
+  // max_distance_.
+  const size_t last = history->size - 1;
+  double max_change = last > 0 ?
+      kMaxOffsetChange * hypot(history->x[last] - history->x[last - 1],
+                               history->y[last] - history->y[last - 1]) :
+      0.0;
+  double change_x = target_x - history->offset_x;
+  double change_y = target_y - history->offset_y;
+  double change = hypot(change_x, change_y);
+  if (change > max_change) {
+    change_x *= max_change / change;
+    change_y *= max_change / change;
+  }
+  history->offset_x += change_x;
+  history->offset_y += change_y;
+  fs->position_x += history->offset_x;
+  fs->position_y += history->offset_y;
+}
+
+bool PredictionFilterInterpreter::FitOffset(History* history, unsigned flags,
+                                            double* dx, double* dy) {
+  const size_t last = history->size - 1;
+  size_t first = 0;
+  while (first < last &&
+         history->time[last] - history->time[first] > prediction_window_.val_)
+    first++;
+  if ((flags & kPalmFlags) || last + 1 - first < kMinSamples)
+    return false;
+
+  // Least squares fit of position against time, per axis.
+  const size_t count = last + 1 - first;
+  double mean_t = 0.0, mean_x = 0.0, mean_y = 0.0;
+  for (size_t i = first; i <= last; i++) {
+    mean_t += history->time[i];
+    mean_x += history->x[i];
+    mean_y += history->y[i];
+  }
+  mean_t /= count;
+  mean_x /= count;
+  mean_y /= count;
+  double var_t = 0.0, cov_x = 0.0, cov_y = 0.0;
+  for (size_t i = first; i <= last; i++) {
+    double dt = history->time[i] - mean_t;
+    var_t += dt * dt;
+    cov_x += dt * (history->x[i] - mean_x);
+    cov_y += dt * (history->y[i] - mean_y);
+  }
+  if (var_t <= 0.0)
+    return false;
+  double vx = cov_x / var_t;
+  double vy = cov_y / var_t;
+
+  // A slow finger is mostly noise, and a finger whose last step goes
+  // against the fit has reversed: predicting either overshoots.
+  float step_x = history->x[last] - history->x[last - 1];
+  float step_y = history->y[last] - history->y[last - 1];
+  if (hypot(vx, vy) < min_speed_.val_ || step_x * vx + step_y * vy < 0.0)
+    return false;
+  history->confidence = std::min(1.0f,
+                                 history->confidence + kConfidenceStep);
+
+  double lead = prediction_lead_.val_ * history->confidence;
+  *dx = vx * lead;
+  *dy = vy * lead;
+  double dist = hypot(*dx, *dy);
+  if (dist > max_distance_.val_) {
+    *dx *= max_distance_.val_ / dist;
+    *dy *= max_distance_.val_ / dist;
+  }
+  return true;
+}
+
+}  // namespace gestures
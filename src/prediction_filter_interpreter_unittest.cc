@@ -0,0 +1,177 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <math.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "include/gestures.h"
+#include "include/prediction_filter_interpreter.h"
+#include "include/touch_stream_generator.h"
+#include "include/unittest_util.h"
+
+namespace gestures {
+
+class PredictionFilterInterpreterTest : public ::testing::Test {};
+
+class PredictionFilterInterpreterTestInterpreter : public Interpreter {
+ public:
+  PredictionFilterInterpreterTestInterpreter()
+      : Interpreter(NULL, NULL, false) {}
+
+  virtual void SyncInterpret(HardwareState* hwstate, stime_t* timeout) {
+    ASSERT_EQ(1, hwstate->finger_cnt);
+    prev_ = hwstate->fingers[0];
+  }
+
+  FingerState prev_;
+};
+
+// Runs a noisy, synthetic 120Hz move and compares each output with where the
+// finger really was two reports later.
+TEST(PredictionFilterInterpreterTest, LatencyTest) {
+  HardwareProperties hwprops = {
+    0, 0, 100, 100,  // left, top, right, bottom
+    1, 1,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch,
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TouchStreamConfig config;
+  config.rate = 120.0;
+  config.position_noise = 0.05;
+  TouchStreamGenerator generator(hwprops, config);
+  generator.AddSegment(kTouchSegmentMove, 1, 0.5);
+  std::vector<HardwareState> states;
+  std::vector<FingerState> fingers;
+  while (HardwareState* hs = generator.Next()) {
+    if (!hs->finger_cnt)
+      break;
+    states.push_back(*hs);
+    fingers.push_back(hs->fingers[0]);
+  }
+  ASSERT_EQ(60, states.size());
+
+  const size_t kLeadFrames = 2;
+  double errors[2];
+  for (int predict = 0; predict < 2; predict++) {
+    PredictionFilterInterpreterTestInterpreter* base_interpreter =
+        new PredictionFilterInterpreterTestInterpreter;
+    PredictionFilterInterpreter interpreter(NULL, base_interpreter, NULL);
+    interpreter.prediction_lead_.val_ = predict ? kLeadFrames / 120.0 : 0.0;
+    TestInterpreterWrapper wrapper(&interpreter, &hwprops);
+
+    double total_error = 0.0;
+    size_t count = 0;
+    for (size_t i = 0; i < states.size(); i++) {
+      FingerState fs = fingers[i];
+      HardwareState hs = states[i];
+      hs.fingers = &fs;
+      wrapper.SyncInterpret(&hs, NULL);
+      // Skip the reports the filter needs to learn the motion.
+      if (i < 6 || i + kLeadFrames >= states.size())
+        continue;
+      const FingerState& future = fingers[i + kLeadFrames];
+      total_error += hypot(base_interpreter->prev_.position_x -
+                           future.position_x,
+                           base_interpreter->prev_.position_y -
+                           future.position_y);
+      count++;
+    }
+    errors[predict] = total_error / count;
+  }
+  // The unpredicted finger trails by two 0.5mm steps.
+  EXPECT_NEAR(1.0, errors[0], 0.1);
+  EXPECT_LT(errors[1], errors[0] / 3);
+}
+
+TEST(PredictionFilterInterpreterTest, ReversalTest) {
+  PredictionFilterInterpreterTestInterpreter* base_interpreter =
+      new PredictionFilterInterpreterTestInterpreter;
+  PredictionFilterInterpreter interpreter(NULL, base_interpreter, NULL);
+  interpreter.prediction_lead_.val_ = 0.02;
+  HardwareProperties hwprops = {
+    0, 0, 100, 100,  // left, top, right, bottom
+    1, 1,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch,
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TestInterpreterWrapper wrapper(&interpreter, &hwprops);
+
+  // Right at 100mm/s for 8 reports, then back left.
+  float x = 20.0;
+  float prev_output = x;
+  for (size_t i = 0; i < 16; i++) {
+    float step = i < 8 ? 1.0 : -1.0;
+    x += step;
+    FingerState fs = { 0, 0, 0, 0, 50, 0, x, 50, 1, 0 };
+    HardwareState hs = make_hwstate(1.0 + 0.01 * i, 0, 1, 1, &fs);
+    wrapper.SyncInterpret(&hs, NULL);
+    float output = base_interpreter->prev_.position_x;
+    if (i >= 5 && i < 8) {
+      EXPECT_GT(output, x);
+      EXPECT_FLOAT_EQ(50, base_interpreter->prev_.position_y);
+    } else if (i >= 8) {
+      // The lead is drained without a jump back: the finger keeps going the
+      // same way as the input, at no more than one and a half times its step.
+      EXPECT_LT(output, prev_output);
+      EXPECT_LE(prev_output - output, 1.5 * fabs(step) + 1e-4);
+    }
+    if (i >= 11) {
+      // No longer ahead to the right.
+      EXPECT_LE(output, x + 1e-4);
+    }
+    // Never more than the lead time ahead.
+    EXPECT_LE(fabs(output - x), 2.0 + 1e-4);
+    prev_output = output;
+  }
+}
+
+TEST(PredictionFilterInterpreterTest, WarpTest) {
+  PredictionFilterInterpreterTestInterpreter* base_interpreter =
+      new PredictionFilterInterpreterTestInterpreter;
+  PredictionFilterInterpreter interpreter(NULL, base_interpreter, NULL);
+  interpreter.prediction_lead_.val_ = 0.02;
+  interpreter.max_distance_.val_ = 1.5;
+  HardwareProperties hwprops = {
+    0, 0, 100, 100,  // left, top, right, bottom
+    1, 1,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch,
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TestInterpreterWrapper wrapper(&interpreter, &hwprops);
+
+  for (size_t i = 0; i < 10; i++) {
+    float x = 20.0 + i;
+    FingerState fs = { 0, 0, 0, 0, 50, 0, x, 50, 1, 0 };
+    if (i == 6)
+      fs.flags = GESTURES_FINGER_WARP_X_MOVE;
+    HardwareState hs = make_hwstate(1.0 + 0.01 * i, 0, 1, 1, &fs);
+    wrapper.SyncInterpret(&hs, NULL);
+    float lead = base_interpreter->prev_.position_x - x;
+    if (i == 5)
+      EXPECT_FLOAT_EQ(1.5, lead);  // Capped by max_distance_
+    if (i >= 6 && i < 8)
+      EXPECT_FLOAT_EQ(0.0, lead);  // Relearning after the warp
+    if (i == 8)
+      EXPECT_GT(lead, 0.0);
+  }
+}
+
+}  // namespace gestures
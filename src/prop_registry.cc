@@ -4,6 +4,7 @@
 
 #include "include/prop_registry.h"
 
+#include <algorithm>
 #include <set>
 #include <string>
 
@@ -17,17 +18,185 @@ using std::string;
 
 namespace gestures {
 
+namespace {
+
+// Orders properties by name, for searching props_by_name_.
+struct PropNameLess {
+  bool operator()(Property* prop, const char* name) const {
+    return strcmp(prop->name(), name) < 0;
+  }
+  bool operator()(const char* name, Property* prop) const {
+    return strcmp(name, prop->name()) < 0;
+  }
+};
+
+}  // namespace {}
+
 void PropRegistry::Register(Property* prop) {
   props_.insert(prop);
+  props_by_name_.insert(std::upper_bound(props_by_name_.begin(),
+                                         props_by_name_.end(),
+                                         prop->name(),
+                                         PropNameLess()),
+                        prop);
   if (prop_provider_)
-    prop->CreateProp();
+    CreateOrDefer(prop);
 }
 
 void PropRegistry::Unregister(Property* prop) {
   if (props_.erase(prop) != 1)
     Err("Unregister failed?");
-  if (prop_provider_)
+  std::vector<Property*>::iterator it =
+      std::lower_bound(props_by_name_.begin(), props_by_name_.end(),
+                       prop->name(), PropNameLess());
+  while (it != props_by_name_.end() && *it != prop)
+    ++it;
+  if (it != props_by_name_.end())
+    props_by_name_.erase(it);
+  {
+    std::lock_guard<std::mutex> lock(staging_lock_);
+    if (prop->staged_pending_) {
+      pending_props_.erase(
+          std::remove(pending_props_.begin(), pending_props_.end(), prop),
+          pending_props_.end());
+      prop->staged_pending_ = false;
+    }
+  }
+  if (prop->create_deferred_) {
+    deferred_props_.erase(
+        std::remove(deferred_props_.begin(), deferred_props_.end(), prop),
+        deferred_props_.end());
+    prop->create_deferred_ = false;
+  } else if (prop_provider_) {
     prop->DestroyProp();
+  }
+}
+
+void PropRegistry::CreateOrDefer(Property* prop) {
+  if (!defer_creation_) {
+    prop->CreateProp();
+    return;
+  }
+  prop->create_deferred_ = true;
+  deferred_props_.push_back(prop);
+}
+
+void PropRegistry::SetDeferredCreation(bool defer) {
+  defer_creation_ = defer;
+  if (!defer)
+    CreateDeferredProps();
+}
+
+void PropRegistry::CreateDeferredProps() {
+  if (deferred_props_.empty())
+    return;
+  std::vector<Property*> props;
+  props.swap(deferred_props_);
+  for (Property* prop : props)
+    prop->create_deferred_ = false;
+  for (Property* prop : props)
+    prop->CreateProp();
+}
+
+void PropRegistry::CreateDeferredProp(Property* prop) {
+  if (!prop->create_deferred_)
+    return;
+  deferred_props_.erase(
+      std::remove(deferred_props_.begin(), deferred_props_.end(), prop),
+      deferred_props_.end());
+  prop->create_deferred_ = false;
+  prop->CreateProp();
+}
+
+Property* PropRegistry::FindProperty(const char* name) const {
+  std::vector<Property*>::const_iterator it =
+      std::lower_bound(props_by_name_.begin(), props_by_name_.end(), name,
+                       PropNameLess());
+  if (it == props_by_name_.end() || strcmp((*it)->name(), name) != 0)
+    return NULL;
+  return *it;
+}
+
+bool PropRegistry::ApplyProperties(const Json::Value& values) {
+  if (!values.isObject()) {
+    Err("Properties to apply must be a dict");
+    return false;
+  }
+  bool ret = true;
+  std::vector<Property*> changed;
+  const Json::Value::Members names = values.getMemberNames();
+  for (const string& name : names) {
+    const Json::Value& value = values[name];
+    std::pair<std::vector<Property*>::iterator,
+              std::vector<Property*>::iterator> range =
+        std::equal_range(props_by_name_.begin(), props_by_name_.end(),
+                         name.c_str(), PropNameLess());
+    if (range.first == range.second) {
+      Log("No property named %s", name.c_str());
+      continue;
+    }
+    for (std::vector<Property*>::iterator it = range.first;
+         it != range.second; ++it) {
+      Property* prop = *it;
+      Json::Value old_value = prop->NewValue();
+      if (!prop->SetValue(value)) {
+        Err("Unable to set value for property %s", name.c_str());
+        ret = false;
+        continue;
+      }
+      if (prop->NewValue() != old_value)
+        changed.push_back(prop);
+    }
+  }
+  // Dict keys are unique, so each property is notified at most once.
+  for (Property* prop : changed)
+    prop->NotifyWritten();
+  return ret;
+}
+
+void PropRegistry::SetStagedWrites(bool staged) {
+  if (prop_provider_) {
+    Err("Staged writes must be set before the prop provider");
+    return;
+  }
+  staged_writes_ = staged;
+}
+
+void PropRegistry::StageWrite(Property* prop) {
+  std::lock_guard<std::mutex> lock(staging_lock_);
+  prop->StageWrite();
+  if (!prop->staged_pending_) {
+    prop->staged_pending_ = true;
+    pending_props_.push_back(prop);
+  }
+  write_epoch_.fetch_add(1, std::memory_order_release);
+}
+
+bool PropRegistry::RefreshStagedValue(Property* prop) {
+  std::lock_guard<std::mutex> lock(staging_lock_);
+  if (prop->staged_pending_)
+    return false;
+  return prop->RefreshStaged();
+}
+
+void PropRegistry::PublishStagedWrites() {
+  if (!staged_writes_ ||
+      write_epoch_.load(std::memory_order_acquire) == published_epoch_)
+    return;
+  std::vector<Property*> written;
+  {
+    std::lock_guard<std::mutex> lock(staging_lock_);
+    published_epoch_ = write_epoch_.load(std::memory_order_relaxed);
+    written.swap(pending_props_);
+    for (Property* prop : written) {
+      prop->ApplyStagedWrite();
+      prop->staged_pending_ = false;
+    }
+  }
+  // Notify outside the lock, so delegates may take as long as they need
+  // without holding up the writer.
+  for (Property* prop : written)
+    prop->NotifyWritten();
 }
 
 void PropRegistry::SetPropProvider(GesturesPropProvider* prop_provider,
@@ -36,15 +205,20 @@ void PropRegistry::SetPropProvider(GesturesPropProvider* prop_provider,
     return;
   if (prop_provider_) {
     for (std::set<Property*>::iterator it = props_.begin(), e= props_.end();
-         it != e; ++it)
-      (*it)->DestroyProp();
+         it != e; ++it) {
+      if ((*it)->create_deferred_)
+        (*it)->create_deferred_ = false;
+      else
+        (*it)->DestroyProp();
+    }
+    deferred_props_.clear();
   }
   prop_provider_ = prop_provider;
   prop_provider_data_ = data;
   if (prop_provider_)
     for (std::set<Property*>::iterator it = props_.begin(), e= props_.end();
          it != e; ++it)
-      (*it)->CreateProp();
+      CreateOrDefer(*it);
 }
 
 void Property::CreateProp() {
@@ -61,6 +235,22 @@ void Property::CreateProp() {
   }
 }
 
+GesturesPropBool Property::HandleGesturesPropWillRead() {
+  // In staged mode the provider reads the staging copy, which doesn't follow
+  // changes the interpreters make to the live value.
+  if (Staged() && parent_->RefreshStagedValue(this))
+    return 1;
+  return 0;
+}
+
+void Property::HandleGesturesPropWritten() {
+  if (Staged()) {
+    parent_->StageWrite(this);
+    return;
+  }
+  NotifyWritten();
+}
+
 void Property::DestroyProp() {
   if (!gprop_) {
     Err("gprop_ already freed!");
@@ -72,12 +262,18 @@ void Property::DestroyProp() {
 
 void BoolProperty::CreatePropImpl() {
   GesturesPropBool orig_val = val_;
+  GesturesPropBool* loc = &val_;
+  if (parent_->staged_writes()) {
+    staged_val_ = val_;
+    loc = &staged_val_;
+  }
   gprop_ = parent_->PropProvider()->create_bool_fn(
       parent_->PropProviderData(),
       name(),
-      &val_,
+      loc,
       1,
       &val_);
+  val_ = *loc;
   if (delegate_ && orig_val != val_)
     delegate_->BoolWasWritten(this);
 }
@@ -94,7 +290,7 @@ bool BoolProperty::SetValue(const Json::Value& value) {
   return true;
 }
 
-void BoolProperty::HandleGesturesPropWritten() {
+void BoolProperty::NotifyWritten() {
   if (parent_ && parent_->activity_log()) {
     ActivityLog::PropChangeEntry entry = {
       name(), ActivityLog::PropChangeEntry::kBoolProp, { 0 }
@@ -109,12 +305,19 @@ void BoolProperty::HandleGesturesPropWritten() {
 void BoolArrayProperty::CreatePropImpl() {
   GesturesPropBool orig_vals[count_];
   memcpy(orig_vals, vals_, sizeof(orig_vals));
+  GesturesPropBool* loc = vals_;
+  if (parent_->staged_writes()) {
+    staged_vals_.assign(vals_, vals_ + count_);
+    loc = staged_vals_.data();
+  }
   gprop_ = parent_->PropProvider()->create_bool_fn(
       parent_->PropProviderData(),
       name(),
-      vals_,
+      loc,
       count_,
       vals_);
+  if (loc != vals_)
+    std::copy(loc, loc + count_, vals_);
   if (delegate_ && memcmp(orig_vals, vals_, sizeof(orig_vals)))
     delegate_->BoolArrayWasWritten(this);
 }
@@ -139,7 +342,7 @@ bool BoolArrayProperty::SetValue(const Json::Value& list) {
   return true;
 }
 
-void BoolArrayProperty::HandleGesturesPropWritten() {
+void BoolArrayProperty::NotifyWritten() {
   // TODO(b/191802713): Log array property changes
   if (delegate_)
     delegate_->BoolArrayWasWritten(this);
@@ -147,12 +350,18 @@ void BoolArrayProperty::HandleGesturesPropWritten() {
 
 void DoubleProperty::CreatePropImpl() {
   double orig_val = val_;
+  double* loc = &val_;
+  if (parent_->staged_writes()) {
+    staged_val_ = val_;
+    loc = &staged_val_;
+  }
   gprop_ = parent_->PropProvider()->create_real_fn(
       parent_->PropProviderData(),
       name(),
-      &val_,
+      loc,
       1,
       &val_);
+  val_ = *loc;
   if (delegate_ && orig_val != val_)
     delegate_->DoubleWasWritten(this);
 }
@@ -171,7 +380,7 @@ bool DoubleProperty::SetValue(const Json::Value& value) {
   return true;
 }
 
-void DoubleProperty::HandleGesturesPropWritten() {
+void DoubleProperty::NotifyWritten() {
   if (parent_ && parent_->activity_log()) {
     ActivityLog::PropChangeEntry entry = {
       name(), ActivityLog::PropChangeEntry::kDoubleProp, { 0 }
@@ -186,12 +395,19 @@ void DoubleProperty::HandleGesturesPropWritten() {
 void DoubleArrayProperty::CreatePropImpl() {
   float orig_vals[count_];
   memcpy(orig_vals, vals_, sizeof(orig_vals));
+  double* loc = vals_;
+  if (parent_->staged_writes()) {
+    staged_vals_.assign(vals_, vals_ + count_);
+    loc = staged_vals_.data();
+  }
   gprop_ = parent_->PropProvider()->create_real_fn(
       parent_->PropProviderData(),
       name(),
-      vals_,
+      loc,
       count_,
       vals_);
+  if (loc != vals_)
+    std::copy(loc, loc + count_, vals_);
   if (delegate_ && memcmp(orig_vals, vals_, sizeof(orig_vals)))
     delegate_->DoubleArrayWasWritten(this);
 }
@@ -221,7 +437,7 @@ bool DoubleArrayProperty::SetValue(const Json::Value& list) {
   return true;
 }
 
-void DoubleArrayProperty::HandleGesturesPropWritten() {
+void DoubleArrayProperty::NotifyWritten() {
   // TODO(b/191802713): Log array property changes
   if (delegate_)
     delegate_->DoubleArrayWasWritten(this);
@@ -229,12 +445,18 @@ void DoubleArrayProperty::HandleGesturesPropWritten() {
 
 void IntProperty::CreatePropImpl() {
   int orig_val = val_;
+  int* loc = &val_;
+  if (parent_->staged_writes()) {
+    staged_val_ = val_;
+    loc = &staged_val_;
+  }
   gprop_ = parent_->PropProvider()->create_int_fn(
       parent_->PropProviderData(),
       name(),
-      &val_,
+      loc,
       1,
       &val_);
+  val_ = *loc;
   if (delegate_ && orig_val != val_)
     delegate_->IntWasWritten(this);
 }
@@ -253,7 +475,7 @@ bool IntProperty::SetValue(const Json::Value& value) {
   return true;
 }
 
-void IntProperty::HandleGesturesPropWritten() {
+void IntProperty::NotifyWritten() {
   if (parent_ && parent_->activity_log()) {
     ActivityLog::PropChangeEntry entry = {
       name(), ActivityLog::PropChangeEntry::kIntProp, { 0 }
@@ -268,12 +490,19 @@ void IntProperty::HandleGesturesPropWritten() {
 void IntArrayProperty::CreatePropImpl() {
   int orig_vals[count_];
   memcpy(orig_vals, vals_, sizeof(orig_vals));
+  int* loc = vals_;
+  if (parent_->staged_writes()) {
+    staged_vals_.assign(vals_, vals_ + count_);
+    loc = staged_vals_.data();
+  }
   gprop_ = parent_->PropProvider()->create_int_fn(
       parent_->PropProviderData(),
       name(),
-      vals_,
+      loc,
       count_,
       vals_);
+  if (loc != vals_)
+    std::copy(loc, loc + count_, vals_);
   if (delegate_ && memcmp(orig_vals, vals_, sizeof(orig_vals)))
     delegate_->IntArrayWasWritten(this);
 }
@@ -299,7 +528,7 @@ bool IntArrayProperty::SetValue(const Json::Value& list) {
   return true;
 }
 
-void IntArrayProperty::HandleGesturesPropWritten() {
+void IntArrayProperty::NotifyWritten() {
   // TODO(b/191802713): Log array property changes
   if (delegate_)
     delegate_->IntArrayWasWritten(this);
@@ -307,11 +536,17 @@ void IntArrayProperty::HandleGesturesPropWritten() {
 
 void StringProperty::CreatePropImpl() {
   const char* orig_val = val_;
+  const char** loc = &val_;
+  if (parent_->staged_writes()) {
+    staged_val_ = val_;
+    loc = &staged_val_;
+  }
   gprop_ = parent_->PropProvider()->create_string_fn(
       parent_->PropProviderData(),
       name(),
-      &val_,
+      loc,
       val_);
+  val_ = *loc;
   if (delegate_ && strcmp(orig_val, val_) != 0)
     delegate_->StringWasWritten(this);
 }
@@ -329,7 +564,7 @@ bool StringProperty::SetValue(const Json::Value& value) {
   return true;
 }
 
-void StringProperty::HandleGesturesPropWritten() {
+void StringProperty::NotifyWritten() {
   if (delegate_)
     delegate_->StringWasWritten(this);
 }
@@ -214,6 +214,196 @@ TEST(PropRegistryTest, SetAtCreateShouldNotifyTest) {
   EXPECT_EQ(4, delegate.call_cnt_);
 }
 
+TEST(PropRegistryTest, DeferredCreationTest) {
+  GesturesPropProvider mock_gestures_props_provider = {
+    MockGesturesPropCreateInt,
+    NULL,
+    MockGesturesPropCreateBool,
+    MockGesturesPropCreateString,
+    MockGesturesPropCreateReal,
+    MockGesturesPropRegisterHandlers,
+    MockGesturesPropFree
+  };
+
+  PropRegistry reg;
+  PropRegistryTestDelegate delegate;
+  reg.SetPropProvider(&mock_gestures_props_provider, NULL);
+  reg.SetDeferredCreation(true);
+  IntProperty my_int(&reg, "MyInt", 0);
+  my_int.SetDelegate(&delegate);
+  DoubleProperty my_double(&reg, "MyDouble", 0.0);
+  my_double.SetDelegate(&delegate);
+  {
+    // Unregistered before it was ever created.
+    BoolProperty my_bool(&reg, "MyBool", false);
+  }
+  EXPECT_EQ(0, my_int.val_);
+  EXPECT_EQ(0.0, my_double.val_);
+
+  reg.CreateDeferredProp(&my_int);
+  EXPECT_EQ(1, my_int.val_);
+  EXPECT_EQ(0.0, my_double.val_);
+  EXPECT_EQ(1, delegate.call_cnt_);
+
+  reg.CreateDeferredProps();
+  EXPECT_EQ(1.0, my_double.val_);
+  EXPECT_EQ(2, delegate.call_cnt_);
+  reg.CreateDeferredProps();
+  EXPECT_EQ(2, delegate.call_cnt_);
+
+  // Turning deferral off creates whatever is still queued.
+  IntProperty late_int(&reg, "LateInt", 0);
+  EXPECT_EQ(0, late_int.val_);
+  reg.SetDeferredCreation(false);
+  EXPECT_EQ(1, late_int.val_);
+
+  reg.SetPropProvider(NULL, NULL);
+}
+
+namespace {
+int* staged_int_loc = NULL;
+double* staged_real_loc = NULL;
+
+GesturesProp* StagedGesturesPropCreateInt(void* data, const char* name,
+                                          int* loc, size_t count,
+                                          const int* init) {
+  staged_int_loc = loc;
+  return new GesturesProp();
+}
+
+GesturesProp* StagedGesturesPropCreateReal(void* data, const char* name,
+                                           double* loc, size_t count,
+                                           const double* init) {
+  staged_real_loc = loc;
+  return new GesturesProp();
+}
+}  // namespace {}
+
+// With staged writes, values written by the prop provider only become
+// visible, and only notify delegates, once they are published.
+TEST(PropRegistryTest, StagedWritesTest) {
+  GesturesPropProvider staged_gestures_props_provider = {
+    StagedGesturesPropCreateInt,
+    NULL,
+    MockGesturesPropCreateBool,
+    MockGesturesPropCreateString,
+    StagedGesturesPropCreateReal,
+    MockGesturesPropRegisterHandlers,
+    MockGesturesPropFree
+  };
+
+  PropRegistry reg;
+  reg.SetStagedWrites(true);
+  PropRegistryTestDelegate delegate;
+  IntProperty my_int(&reg, "MyInt", 3);
+  my_int.SetDelegate(&delegate);
+  DoubleProperty my_double(&reg, "MyDouble", 1.5);
+  my_double.SetDelegate(&delegate);
+  reg.SetPropProvider(&staged_gestures_props_provider, NULL);
+  ASSERT_NE(nullptr, staged_int_loc);
+  ASSERT_NE(nullptr, staged_real_loc);
+  EXPECT_NE(&my_int.val_, staged_int_loc);
+  EXPECT_EQ(3, *staged_int_loc);
+
+  // Nothing written yet, so publishing is a no-op.
+  reg.PublishStagedWrites();
+  EXPECT_EQ(0, delegate.call_cnt_);
+
+  *staged_int_loc = 7;
+  my_int.HandleGesturesPropWritten();
+  *staged_int_loc = 8;
+  my_int.HandleGesturesPropWritten();
+  *staged_real_loc = 2.5;
+  my_double.HandleGesturesPropWritten();
+  EXPECT_EQ(3, my_int.val_);
+  EXPECT_EQ(1.5, my_double.val_);
+  EXPECT_EQ(0, delegate.call_cnt_);
+
+  reg.PublishStagedWrites();
+  EXPECT_EQ(8, my_int.val_);
+  EXPECT_EQ(2.5, my_double.val_);
+  EXPECT_EQ(2, delegate.call_cnt_);
+
+  reg.PublishStagedWrites();
+  EXPECT_EQ(2, delegate.call_cnt_);
+
+  // The provider reads the live value, as changed by the interpreters, unless
+  // a write to it is still to be published.
+  my_int.val_ = 11;
+  EXPECT_TRUE(my_int.HandleGesturesPropWillRead());
+  EXPECT_EQ(11, *staged_int_loc);
+  EXPECT_FALSE(my_int.HandleGesturesPropWillRead());
+  *staged_int_loc = 12;
+  my_int.HandleGesturesPropWritten();
+  my_int.val_ = 13;
+  EXPECT_FALSE(my_int.HandleGesturesPropWillRead());
+  EXPECT_EQ(12, *staged_int_loc);
+  reg.PublishStagedWrites();
+  EXPECT_EQ(12, my_int.val_);
+  EXPECT_EQ(3, delegate.call_cnt_);
+
+  // Staging can't be turned on once the provider has bound the properties.
+  reg.SetStagedWrites(false);
+  EXPECT_TRUE(reg.staged_writes());
+  reg.SetPropProvider(NULL, NULL);
+  staged_int_loc = NULL;
+  staged_real_loc = NULL;
+}
+
+TEST(PropRegistryTest, FindPropertyTest) {
+  PropRegistry reg;
+  IntProperty b(&reg, "B", 2);
+  IntProperty a(&reg, "A", 1);
+  IntProperty b_again(&reg, "B", 3);
+  EXPECT_EQ(&a, reg.FindProperty("A"));
+  EXPECT_EQ(&b, reg.FindProperty("B"));
+  EXPECT_EQ(nullptr, reg.FindProperty("C"));
+  {
+    IntProperty c(&reg, "C", 4);
+    EXPECT_EQ(&c, reg.FindProperty("C"));
+  }
+  EXPECT_EQ(nullptr, reg.FindProperty("C"));
+}
+
+TEST(PropRegistryTest, ApplyPropertiesTest) {
+  PropRegistry reg;
+  ActivityLog log(&reg);
+  reg.set_activity_log(&log);
+  PropRegistryTestDelegate delegate;
+  IntProperty my_int(&reg, "MyInt", 1);
+  my_int.SetDelegate(&delegate);
+  DoubleProperty my_double(&reg, "MyDouble", 2.0);
+  my_double.SetDelegate(&delegate);
+  BoolProperty my_bool(&reg, "MyBool", false);
+  my_bool.SetDelegate(&delegate);
+
+  Json::Value profile(Json::objectValue);
+  profile["MyInt"] = Json::Value(5);
+  profile["MyDouble"] = Json::Value(2.0);  // Unchanged
+  profile["MyBool"] = Json::Value(true);
+  profile["NotAProperty"] = Json::Value(1);
+  EXPECT_TRUE(reg.ApplyProperties(profile));
+  EXPECT_EQ(5, my_int.val_);
+  EXPECT_EQ(2.0, my_double.val_);
+  EXPECT_TRUE(my_bool.val_);
+  EXPECT_EQ(2, delegate.call_cnt_);
+  EXPECT_EQ(2, log.size());
+
+  // Applying the same profile again changes nothing.
+  EXPECT_TRUE(reg.ApplyProperties(profile));
+  EXPECT_EQ(2, delegate.call_cnt_);
+
+  // A bad value fails, but the other values are still applied.
+  Json::Value bad(Json::objectValue);
+  bad["MyBool"] = Json::Value("yes");
+  bad["MyInt"] = Json::Value(6);
+  EXPECT_FALSE(reg.ApplyProperties(bad));
+  EXPECT_EQ(6, my_int.val_);
+  EXPECT_EQ(3, delegate.call_cnt_);
+
+  EXPECT_FALSE(reg.ApplyProperties(Json::Value(1)));
+}
+
 TEST(PropRegistryTest, DoublePromoteIntTest) {
   PropRegistry reg;
   PropRegistryTestDelegate delegate;
@@ -0,0 +1,166 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "include/regression_runner.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "include/file_util.h"
+#include "include/logging.h"
+#include "include/parameter_sweep.h"
+
+using std::string;
+
+namespace gestures {
+
+namespace {
+
+bool EndsWith(const string& str, const string& suffix) {
+  return str.size() >= suffix.size() &&
+      str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Appends the paths of the files under |dir| ending in |suffix|, relative
+// to |dir| and prefixed with |prefix|.
+bool ListFiles(const string& dir, const string& prefix, const string& suffix,
+               std::vector<string>* out) {
+  DIR* handle = opendir(dir.c_str());
+  if (!handle)
+    return false;
+  while (struct dirent* entry = readdir(handle)) {
+    string name = entry->d_name;
+    if (name == "." || name == "..")
+      continue;
+    string path = dir + "/" + name;
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+      continue;
+    if (S_ISDIR(info.st_mode))
+      ListFiles(path, prefix + name + "/", suffix, out);
+    else if (EndsWith(name, suffix))
+      out->push_back(prefix + name);
+  }
+  closedir(handle);
+  return true;
+}
+
+Json::Value ReportEntry(const char* result, double score, const string& error) {
+  Json::Value entry(Json::objectValue);
+  entry["description"] = Json::Value("");
+  entry["disabled"] = Json::Value(false);
+  entry["error"] = Json::Value(error);
+  entry["result"] = Json::Value(result);
+  entry["score"] = Json::Value(score);
+  return entry;
+}
+
+}  // namespace {}
+
+RegressionRunner::RegressionRunner()
+    : time_tolerance_(0.0), value_tolerance_(0.0) {}
+
+bool RegressionRunner::AddLogsInDirectory(const string& dir,
+                                          const string& suffix,
+                                          GestureInterpreterDeviceClass cls) {
+  std::vector<string> files;
+  if (!ListFiles(dir, "", suffix, &files)) {
+    Err("Unable to read directory %s", dir.c_str());
+    return false;
+  }
+  std::sort(files.begin(), files.end());
+  for (const string& file : files)
+    AddLog(file.substr(0, file.size() - suffix.size()), dir + "/" + file,
+           cls);
+  return true;
+}
+
+void RegressionRunner::AddLog(const string& name, const string& path,
+                              GestureInterpreterDeviceClass cls) {
+  Case test_case = { name, path, cls };
+  cases_.push_back(test_case);
+}
+
+Json::Value RegressionRunner::Run(size_t max_threads) {
+  std::vector<Json::Value> entries(cases_.size());
+  if (!max_threads)
+    max_threads = std::max(1u, std::thread::hardware_concurrency());
+  size_t num_threads = std::min(max_threads, cases_.size());
+
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < cases_.size(); i = next++)
+      entries[i] = RunCase(cases_[i]);
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; i++)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread& thread : threads)
+    thread.join();
+
+  Json::Value report(Json::objectValue);
+  for (size_t i = 0; i < cases_.size(); i++)
+    report[cases_[i].name] = entries[i];
+  return report;
+}
+
+Json::Value RegressionRunner::RunCase(const Case& test_case) const {
+  string data;
+  if (!ReadFileToString(test_case.path.c_str(), &data))
+    return ReportEntry("incomplete", 0.0, "Unable to read " + test_case.path);
+  ParameterSweep sweep;
+  if (!sweep.Parse(data))
+    return ReportEntry("incomplete", 0.0, "Unable to parse log");
+  sweep.SetTolerance(time_tolerance_, value_tolerance_);
+
+  std::vector<SweepConfig> configs(1);
+  configs[0].name = test_case.name;
+  SweepResult result = sweep.Run(configs, test_case.cls, 1)[0];
+
+  size_t logged = result.matched + result.missing;
+  double score = logged ? static_cast<double>(result.matched) / logged : 1.0;
+  if (result.missing || result.unexpected)
+    return ReportEntry("failure", score, "");
+  return ReportEntry("success", score, "");
+}
+
+bool RegressionRunner::DeviceClassFromName(
+    const string& name, GestureInterpreterDeviceClass* out) {
+  if (name == "touchpad")
+    *out = GESTURES_DEVCLASS_TOUCHPAD;
+  else if (name == "mouse")
+    *out = GESTURES_DEVCLASS_MOUSE;
+  else if (name == "multitouch_mouse")
+    *out = GESTURES_DEVCLASS_MULTITOUCH_MOUSE;
+  else if (name == "pointing_stick")
+    *out = GESTURES_DEVCLASS_POINTING_STICK;
+  else if (name == "touchscreen")
+    *out = GESTURES_DEVCLASS_TOUCHSCREEN;
+  else
+    return false;
+  return true;
+}
+
+std::vector<string> RegressionRunner::Regressions(const Json::Value& reference,
+                                                  const Json::Value& report) {
+  std::vector<string> ret;
+  if (!reference.isObject() || !report.isObject())
+    return ret;
+  for (const string& name : reference.getMemberNames()) {
+    const Json::Value& ref_entry = reference[name];
+    if (!ref_entry.isObject() || ref_entry["result"].asString() != "success")
+      continue;
+    const Json::Value& entry = report[name];
+    if (!entry.isObject() || entry["result"].asString() != "success")
+      ret.push_back(name);
+  }
+  return ret;
+}
+
+}  // namespace gestures
@@ -0,0 +1,179 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <json/reader.h>
+#include <json/value.h>
+
+#include "include/command_line.h"
+#include "include/file_util.h"
+#include "include/gestures.h"
+#include "include/prop_registry.h"
+#include "include/regression_runner.h"
+#include "include/unittest_util.h"
+
+using std::string;
+
+namespace gestures {
+
+class RegressionRunnerTest : public ::testing::Test {};
+
+namespace {
+
+bool ParseJson(const string& data, Json::Value* out) {
+  Json::CharReaderBuilder builder;
+  std::unique_ptr<Json::CharReader> const reader(builder.newCharReader());
+  string error;
+  return reader->parse(data.c_str(), data.c_str() + data.size(), out, &error);
+}
+
+void WriteString(const string& path, const string& data) {
+  EXPECT_EQ(static_cast<int>(data.size()),
+            WriteFile(path.c_str(), data.c_str(), data.size()));
+}
+
+// Records a multitouch mouse that moves, then scrolls with one of the two
+// fingers on its surface.
+string RecordMultitouchMouseActivityLog() {
+  std::unique_ptr<GestureInterpreter> gi(NewGestureInterpreter());
+  gi->Initialize(GESTURES_DEVCLASS_MULTITOUCH_MOUSE);
+  Property* logging = gi->prop_reg()->FindProperty("Event Logging Enable");
+  logging->SetValue(Json::Value(true));
+  logging->HandleGesturesPropWritten();
+  HardwareProperties hwprops = {
+    0, 0, 100, 60,  // left, top, right, bottom
+    1, 1,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    2, 5,  // max fingers, max_touch
+    0, 0, 0,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  gi->SetHardwareProperties(hwprops);
+  for (size_t i = 0; i < 20; i++) {
+    bool moving = i < 10;
+    FingerState fs[] = {
+      // TM, Tm, WM, Wm, pr, orient, x, y, id, flags
+      { 1, 1, 0, 0, 20, 0, 30, moving ? 20.0f : 20.0f + i, 1, 0 },
+      { 1, 1, 0, 0, 20, 0, 60, 20, 2, 0 },
+    };
+    HardwareState hs = make_hwstate(0.01 * (i + 1), 0, 2, 2, fs);
+    hs.rel_x = moving ? 3 : 0;
+    gi->PushHardwareState(&hs);
+  }
+  return gi->EncodeActivityLog();
+}
+
+}  // namespace {}
+
+TEST(RegressionRunnerTest, CorpusTest) {
+  char dir_template[] = "/tmp/gestures_regression_XXXXXX";
+  ASSERT_NE(nullptr, mkdtemp(dir_template));
+  string dir = dir_template;
+  ASSERT_EQ(0, mkdir((dir + "/mouse").c_str(), 0700));
+
+  string log = RecordMouseActivityLog(10);
+  WriteString(dir + "/mouse/move.log", log);
+  WriteString(dir + "/multitouch_mouse.log",
+              RecordMultitouchMouseActivityLog());
+
+  // Nudge the first logged gesture.
+  Json::Value root;
+  ASSERT_TRUE(ParseJson(log, &root));
+  Json::Value& entries = root["entries"];
+  for (Json::Value& entry : entries) {
+    if (entry["type"].asString() == "gesture") {
+      entry["dx"] = Json::Value(entry["dx"].asDouble() * 1.001);
+      break;
+    }
+  }
+  WriteString(dir + "/mouse/nudged.log", root.toStyledString());
+  WriteString(dir + "/broken.log", "not a log");
+  WriteString(dir + "/mouse/notes.txt", "not a test");
+
+  RegressionRunner runner;
+  ASSERT_TRUE(runner.AddLogsInDirectory(dir + "/mouse", ".log",
+                                        GESTURES_DEVCLASS_MOUSE));
+  runner.AddLog("multitouch_mouse", dir + "/multitouch_mouse.log",
+                GESTURES_DEVCLASS_MULTITOUCH_MOUSE);
+  // The wrong chain doesn't reproduce a log.
+  runner.AddLog("multitouch_mouse_on_touchpad", dir + "/multitouch_mouse.log",
+                GESTURES_DEVCLASS_TOUCHPAD);
+  runner.AddLog("broken", dir + "/broken.log", GESTURES_DEVCLASS_TOUCHPAD);
+  Json::Value exact = runner.Run(3);
+  EXPECT_EQ(5, exact.size());
+  EXPECT_EQ("success", exact["move"]["result"].asString());
+  EXPECT_EQ(1.0, exact["move"]["score"].asDouble());
+  EXPECT_EQ("failure", exact["nudged"]["result"].asString());
+  EXPECT_EQ(0.9, exact["nudged"]["score"].asDouble());
+  EXPECT_EQ("success", exact["multitouch_mouse"]["result"].asString());
+  EXPECT_EQ("failure",
+            exact["multitouch_mouse_on_touchpad"]["result"].asString());
+  EXPECT_EQ("incomplete", exact["broken"]["result"].asString());
+  EXPECT_NE("", exact["broken"]["error"].asString());
+  EXPECT_FALSE(exact["move"]["disabled"].asBool());
+
+  runner.SetTolerance(0.0, 0.01);
+  Json::Value tolerant = runner.Run(1);
+  EXPECT_EQ("success", tolerant["nudged"]["result"].asString());
+
+  std::vector<string> regressions =
+      RegressionRunner::Regressions(tolerant, exact);
+  ASSERT_EQ(1, regressions.size());
+  EXPECT_EQ("nudged", regressions[0]);
+  EXPECT_TRUE(RegressionRunner::Regressions(exact, tolerant).empty());
+
+  unlink((dir + "/mouse/move.log").c_str());
+  unlink((dir + "/mouse/nudged.log").c_str());
+  unlink((dir + "/multitouch_mouse.log").c_str());
+  unlink((dir + "/broken.log").c_str());
+  unlink((dir + "/mouse/notes.txt").c_str());
+  rmdir((dir + "/mouse").c_str());
+  rmdir(dir.c_str());
+}
+
+// Runs a corpus of logs and writes the report. Run it with
+// --gtest_also_run_disabled_tests and these flags:
+//   --logs=<dir of logs> [--device=touchpad] [--suffix=.log]
+//   [--out=<report path>]
+//   [--ref=<reference report, e.g. tools/touchtests-report.json>]
+// "make regression" runs it, see the Makefile.
+TEST(RegressionRunnerTest, DISABLED_RunCorpus) {
+  CommandLine* cl = CommandLine::ForCurrentProcess();
+  RegressionRunner runner;
+  string suffix = cl->HasSwitch("suffix") ?
+      cl->GetSwitchValueASCII("suffix") : ".log";
+  GestureInterpreterDeviceClass cls = GESTURES_DEVCLASS_TOUCHPAD;
+  if (cl->HasSwitch("device"))
+    ASSERT_TRUE(RegressionRunner::DeviceClassFromName(
+        cl->GetSwitchValueASCII("device"), &cls));
+  ASSERT_TRUE(runner.AddLogsInDirectory(cl->GetSwitchValueASCII("logs"),
+                                        suffix, cls));
+  Json::Value report = runner.Run(0);
+  if (cl->HasSwitch("out")) {
+    string out = report.toStyledString();
+    WriteString(cl->GetSwitchValueASCII("out"), out);
+  }
+  if (cl->HasSwitch("ref")) {
+    string ref_data;
+    Json::Value reference;
+    ASSERT_TRUE(ReadFileToString(cl->GetSwitchValueASCII("ref").c_str(),
+                                 &ref_data));
+    ASSERT_TRUE(ParseJson(ref_data, &reference));
+    for (const string& name : RegressionRunner::Regressions(reference, report))
+      ADD_FAILURE() << "Regression: " << name;
+  }
+}
+
+}  // namespace gestures
@@ -351,9 +351,15 @@ void ScalingFilterInterpreter::Initialize(const HardwareProperties* hwprops,
   }
 
   // For haptic touchpads, the pressure field is actual force in grams, not an
-  // estimate of surface area.
-  if (hwprops->is_haptic_pad && use_touch_size_for_haptic_pad_.val_)
-    surface_area_from_pressure_.val_ = false;
+  // estimate of surface area. Both properties get the provider's values
+  // first, so a deferred creation doesn't write over the override later.
+  if (hwprops->is_haptic_pad) {
+    use_touch_size_for_haptic_pad_.CreateDeferred();
+    if (use_touch_size_for_haptic_pad_.val_) {
+      surface_area_from_pressure_.CreateDeferred();
+      surface_area_from_pressure_.val_ = false;
+    }
+  }
 
   // Make fake idealized hardware properties to report to next_.
   friendly_props_ = {
@@ -4,11 +4,38 @@
 
 #include "include/sensor_jump_filter_interpreter.h"
 
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
 #include "include/tracer.h"
 #include "include/util.h"
 
 namespace gestures {
 
+namespace {
+
+// The flags set on a finger that fails each SensorJumpFilterInterpreter
+// check. Warping moves here get tap warped, too.
+const unsigned kCheckFlags[] = {
+  GESTURES_FINGER_WARP_X_NON_MOVE | GESTURES_FINGER_WARP_TELEPORTATION,
+  GESTURES_FINGER_WARP_Y_NON_MOVE | GESTURES_FINGER_WARP_TELEPORTATION,
+  GESTURES_FINGER_WARP_X_MOVE | GESTURES_FINGER_WARP_TELEPORTATION |
+      GESTURES_FINGER_WARP_X_TAP_MOVE,
+  GESTURES_FINGER_WARP_Y_MOVE | GESTURES_FINGER_WARP_TELEPORTATION |
+      GESTURES_FINGER_WARP_Y_TAP_MOVE,
+};
+
+// The largest float less than |val|, so that a float is less than |val|
+// exactly when it's at most this.
+float LargestFloatBelow(double val) {
+  float below = val;
+  return below < val ? below : nextafterf(below, -INFINITY);
+}
+
+}  // namespace {}
+
 SensorJumpFilterInterpreter::SensorJumpFilterInterpreter(PropRegistry* prop_reg,
                                                          Interpreter* next,
                                                          Tracer* tracer)
@@ -28,6 +55,10 @@ SensorJumpFilterInterpreter::SensorJumpFilterInterpreter(PropRegistry* prop_reg,
                              "Sensor Jump No Warp Min Dist Move",
                              0.21) {
   InitName();
+  present_[0] = present_[1] = 0;
+  memset(input_, 0, sizeof(input_));
+  input_head_ = 0;
+  memset(first_flags_, 0, sizeof(first_flags_));
 }
 
 void SensorJumpFilterInterpreter::SyncInterpretImpl(HardwareState* hwstate,
@@ -37,98 +68,99 @@ void SensorJumpFilterInterpreter::SyncInterpretImpl(HardwareState* hwstate,
     return;
   }
 
-  RemoveMissingIdsFromMap(&previous_input_[0], *hwstate);
-  RemoveMissingIdsFromMap(&previous_input_[1], *hwstate);
-  RemoveMissingIdsFromSet(&first_flag_[0], *hwstate);
-  RemoveMissingIdsFromSet(&first_flag_[1], *hwstate);
-  RemoveMissingIdsFromSet(&first_flag_[2], *hwstate);
-  RemoveMissingIdsFromSet(&first_flag_[3], *hwstate);
-
-  std::map<short, FingerState> current_input;
-
-  for (size_t i = 0; i < hwstate->finger_cnt; i++)
-    current_input[hwstate->fingers[i].tracking_id] = hwstate->fingers[i];
-
-  for (size_t i = 0; i < hwstate->finger_cnt; i++) {
-    short tracking_id = hwstate->fingers[i].tracking_id;
-    if (!MapContainsKey(previous_input_[1], tracking_id) ||
-        !MapContainsKey(previous_input_[0], tracking_id))
+  // Store the current inputs, and gather the last two deltas of each
+  // contact that was in the previous two inputs as well, in arrays by the
+  // order they're checked in. Fingers without a slot, which only happens past
+  // kMaxFingerSlots contacts, aren't checked.
+  const size_t finger_cnt =
+      std::min<size_t>(hwstate->finger_cnt, kMaxFingerSlots);
+  const size_t next_row = InputRow(kHistorySize - 1);  // the oldest row
+  finger_slots_.Update(*hwstate);
+  uint64_t present = 0;
+  size_t checked_cnt = 0;
+  size_t checked_fingers[kMaxFingerSlots];
+  int checked_slots[kMaxFingerSlots];
+  // By axis, newer and older delta, and order checked.
+  float deltas[2][kHistorySize][kMaxFingerSlots];
+  uint8_t first_flags[kMaxFingerSlots];
+  for (size_t i = 0; i < finger_cnt; i++) {
+    const FingerState& fs = hwstate->fingers[i];
+    int slot = finger_slots_.SlotForId(fs.tracking_id);
+    if (slot < 0)
       continue;
-    FingerState* fs[] = {
-      &hwstate->fingers[i],  // newest
-      &previous_input_[0][tracking_id],
-      &previous_input_[1][tracking_id],  // oldest
-    };
-    float FingerState::* const fields[] = { &FingerState::position_x,
-                                            &FingerState::position_y,
-                                            &FingerState::position_x,
-                                            &FingerState::position_y };
-
-    unsigned warp[] = { GESTURES_FINGER_WARP_X_NON_MOVE,
-                        GESTURES_FINGER_WARP_Y_NON_MOVE,
-                        GESTURES_FINGER_WARP_X_MOVE,
-                        GESTURES_FINGER_WARP_Y_MOVE };
-
-    for (size_t f_idx = 0; f_idx < arraysize(fields); f_idx++) {
-      float FingerState::* const field = fields[f_idx];
-      const float val[] = {
-        fs[0]->*field,  // newest
-        fs[1]->*field,
-        fs[2]->*field,  // oldest
-      };
-      const float delta[] = {
-        val[0] - val[1],  // newer
-        val[1] - val[2],  // older
-      };
-
-      bool warp_move = (warp[f_idx] == GESTURES_FINGER_WARP_X_MOVE ||
-                        warp[f_idx] == GESTURES_FINGER_WARP_Y_MOVE);
-      float min_warp_dist = warp_move ? min_warp_dist_move_.val_ :
-          min_warp_dist_non_move_.val_;
-      float max_warp_dist = warp_move ? max_warp_dist_move_.val_ :
-          max_warp_dist_non_move_.val_;
-      float similar_multiplier = warp_move ? similar_multiplier_move_.val_ :
-          similar_multiplier_non_move_.val_;
-
-      const float kAllowableChange = fabsf(delta[1] * similar_multiplier);
-
-      bool should_warp = false;
-      bool should_store_flag = false;
-      if (delta[0] * delta[1] < 0.0) {
-        // switched direction
-        // Don't mark direction change with small delta with WARP_*_MOVE.
-        if (!warp_move || !(fabsf(delta[0]) < no_warp_min_dist_move_.val_ &&
-                            fabsf(delta[1]) < no_warp_min_dist_move_.val_))
-          should_store_flag = should_warp = true;
-      } else if (fabsf(delta[0]) < min_warp_dist ||
-                 fabsf(delta[0]) > max_warp_dist) {
-        // acceptable movement
-      } else if (fabsf(delta[0] - delta[1]) <= kAllowableChange) {
-        if (SetContainsValue(first_flag_[f_idx], tracking_id)) {
-          // Was flagged last time. Flag one more time
-          should_warp = true;
-        }
-      } else {
-        should_store_flag = should_warp = true;
-      }
-      if (should_warp) {
-        fs[0]->flags |= (warp[f_idx] | GESTURES_FINGER_WARP_TELEPORTATION);
-        // Warping moves here get tap warped, too
-        if (warp_move) {
-          fs[0]->flags |= warp[f_idx] == GESTURES_FINGER_WARP_X_MOVE ?
-              GESTURES_FINGER_WARP_X_TAP_MOVE : GESTURES_FINGER_WARP_Y_TAP_MOVE;
-        }
+    uint64_t bit = static_cast<uint64_t>(1) << slot;
+    present |= bit;
+    const float vals[] = { fs.position_x, fs.position_y };
+    if (!(present_[0] & bit)) {
+      first_flags_[slot] = 0;
+    } else if (present_[1] & bit) {
+      for (size_t axis = 0; axis < 2; axis++) {
+        const float prev = input_[axis][InputRow(0)][slot];
+        deltas[axis][0][checked_cnt] = vals[axis] - prev;  // newer
+        deltas[axis][1][checked_cnt] =
+            prev - input_[axis][InputRow(1)][slot];  // older
       }
-      if (should_store_flag)
-        first_flag_[f_idx].insert(tracking_id);
-      else
-        first_flag_[f_idx].erase(tracking_id);
+      first_flags[checked_cnt] = first_flags_[slot];
+      checked_fingers[checked_cnt] = i;
+      checked_slots[checked_cnt] = slot;
+      checked_cnt++;
     }
+    for (size_t axis = 0; axis < 2; axis++)
+      input_[axis][next_row][slot] = vals[axis];
+  }
+
+  // Check both axes of every contact at once, noting which checks warp and
+  // which store a first flag.
+  uint8_t warps[kMaxFingerSlots] = { 0 };
+  uint8_t stores[kMaxFingerSlots] = { 0 };
+  for (size_t check = 0; check < kNumChecks; check++) {
+    const size_t axis = check % 2;
+    const bool warp_move = check >= kCheckXMove;
+    const float* newer = deltas[axis][0];
+    const float* older = deltas[axis][1];
+    const float min_warp_dist = warp_move ? min_warp_dist_move_.val_ :
+        min_warp_dist_non_move_.val_;
+    const float max_warp_dist = warp_move ? max_warp_dist_move_.val_ :
+        max_warp_dist_non_move_.val_;
+    const float similar_multiplier = warp_move ?
+        similar_multiplier_move_.val_ : similar_multiplier_non_move_.val_;
+    // Don't mark direction change with small delta with WARP_*_MOVE. No
+    // delta is at most -1.
+    const float small_turn_max = warp_move ?
+        LargestFloatBelow(no_warp_min_dist_move_.val_) : -1.0;
+    for (size_t i = 0; i < checked_cnt; i++) {
+      const float delta0 = newer[i];
+      const float delta1 = older[i];
+      const float kAllowableChange = fabsf(delta1 * similar_multiplier);
+      const int turned = delta0 * delta1 < 0.0f;
+      const int small_turn = (fabsf(delta0) <= small_turn_max) &
+          (fabsf(delta1) <= small_turn_max);
+      const int acceptable = (fabsf(delta0) < min_warp_dist) |
+          (fabsf(delta0) > max_warp_dist);
+      const int similar = fabsf(delta0 - delta1) <= kAllowableChange;
+      const int flagged = (first_flags[i] >> check) & 1;
+      // A finger that switched direction, or that jumps unlike last time, is
+      // flagged. One that jumps like last time is flagged again if it was
+      // flagged last time.
+      const int jump = (1 - turned) & (1 - acceptable);
+      const int store = (turned & (1 - small_turn)) | (jump & (1 - similar));
+      const int warp = store | (jump & similar & flagged);
+      warps[i] |= warp << check;
+      stores[i] |= store << check;
+    }
+  }
+
+  for (size_t i = 0; i < checked_cnt; i++) {
+    first_flags_[checked_slots[i]] = stores[i];
+    for (size_t check = 0; check < kNumChecks; check++)
+      if ((warps[i] >> check) & 1)
+        hwstate->fingers[checked_fingers[i]].flags |= kCheckFlags[check];
   }
 
-  // Update previous input/output state
-  previous_input_[1] = previous_input_[0];
-  previous_input_[0] = current_input;
+  // Update previous input state
+  input_head_ = next_row;
+  present_[1] = present_[0];
+  present_[0] = present;
 
   next_->SyncInterpret(hwstate, timeout);
 }
@@ -0,0 +1,306 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "include/smoothing_filter_interpreter.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "include/stationary_wiggle_filter_interpreter.h"
+
+namespace gestures {
+
+// One step of a SmoothingFilterInterpreter.
+class SmoothingStageFilter {
+ public:
+  virtual ~SmoothingStageFilter() {}
+
+  // Filters the first |finger_cnt| fingers of |hwstate| in place. slots[i]
+  // is the slot of finger i, or -1 if it has none, in which case it isn't
+  // filtered. |present| has the slots of all of them.
+  virtual void Filter(const HardwareProperties* hwprops, const int* slots,
+                      size_t finger_cnt, uint64_t present,
+                      HardwareState* hwstate) = 0;
+};
+
+namespace {
+
+uint64_t SlotBit(int slot) {
+  return static_cast<uint64_t>(1) << slot;
+}
+
+float FingerState::* const kPositionFields[] = {
+  &FingerState::position_x,
+  &FingerState::position_y,
+};
+
+const unsigned kWarpMoveFlags[] = {
+  GESTURES_FINGER_WARP_X_MOVE,
+  GESTURES_FINGER_WARP_Y_MOVE,
+};
+
+// Same as StationaryWiggleFilterInterpreter.
+class StationaryWiggleStage : public SmoothingStageFilter {
+ public:
+  explicit StationaryWiggleStage(PropRegistry* prop_reg)
+      : enabled_(prop_reg, "Stationary Wiggle Filter Enabled", false),
+        threshold_(prop_reg, "Finger Moving Energy", 0.012),
+        hysteresis_(prop_reg, "Finger Moving Hysteresis", 0.006),
+        window_(prop_reg, "Stationary Wiggle Window", SIGNAL_SAMPLES) {}
+
+  virtual void Filter(const HardwareProperties* hwprops, const int* slots,
+                      size_t finger_cnt, uint64_t present,
+                      HardwareState* hwstate) {
+    detector_.RemoveMissing(present);
+    if (enabled_.val_)
+      detector_.Update(slots, finger_cnt, threshold_.val_, hysteresis_.val_,
+                       window_.val_, hwstate);
+  }
+
+ private:
+  StationaryWiggleDetector detector_;
+
+  BoolProperty enabled_;
+  DoubleProperty threshold_;
+  DoubleProperty hysteresis_;
+  IntProperty window_;
+};
+
+// Same as BoxFilterInterpreter.
+class BoxStage : public SmoothingStageFilter {
+ public:
+  explicit BoxStage(PropRegistry* prop_reg)
+      : tracked_(0),
+        box_width_(prop_reg, "Box Width", 0.0),
+        box_height_(prop_reg, "Box Height", 0.0) {}
+
+  virtual void Filter(const HardwareProperties* hwprops, const int* slots,
+                      size_t finger_cnt, uint64_t present,
+                      HardwareState* hwstate) {
+    tracked_ &= present;
+    if (box_width_.val_ == 0.0 && box_height_.val_ == 0.0)
+      return;
+    const float kHalfWidth = box_width_.val_ * 0.5;
+    const float kHalfHeight = box_height_.val_ * 0.5;
+    const float kBounds[] = { kHalfWidth, kHalfHeight };
+
+    for (size_t i = 0; i < finger_cnt; i++) {
+      int slot = slots[i];
+      // If it's new, pass it through
+      if (slot < 0 || !(tracked_ & SlotBit(slot)))
+        continue;
+      FingerState* fs = &hwstate->fingers[i];
+      for (size_t axis = 0; axis < arraysize(kPositionFields); axis++) {
+        if (fs->flags & kWarpMoveFlags[axis])
+          continue;
+        float* val = &(fs->*kPositionFields[axis]);
+        float prev_out_val = prev_out_[axis][slot];
+        float bound = kBounds[axis];
+        if (prev_out_val - bound < *val && *val < prev_out_val + bound)
+          *val = prev_out_val;
+        else if (*val > prev_out_val)
+          *val -= bound;
+        else
+          *val += bound;
+      }
+    }
+
+    for (size_t i = 0; i < finger_cnt; i++) {
+      int slot = slots[i];
+      if (slot < 0)
+        continue;
+      for (size_t axis = 0; axis < arraysize(kPositionFields); axis++)
+        prev_out_[axis][slot] = hwstate->fingers[i].*kPositionFields[axis];
+    }
+    tracked_ |= present;
+  }
+
+ private:
+  // The previous output position, by axis and slot.
+  float prev_out_[2][kMaxFingerSlots];
+  // Slots with a previous output.
+  uint64_t tracked_;
+
+  DoubleProperty box_width_;
+  DoubleProperty box_height_;
+};
+
+// Same as IirFilterInterpreter, and then the extra sections.
+class BiquadStage : public SmoothingStageFilter, public PropertyDelegate {
+ public:
+  explicit BiquadStage(PropRegistry* prop_reg)
+      : iir_(prop_reg),
+        extra_coeffs_prop_(prop_reg, "IIR Extra Sections", extra_coeffs_,
+                           arraysize(extra_coeffs_)) {
+    // The extra sections pass their input through until set.
+    memset(extra_coeffs_, 0, sizeof(extra_coeffs_));
+    for (size_t i = 0; i < kSmoothingExtraSections; i++)
+      extra_coeffs_[i * IirFilterBank::kSectionCoefficients] = 1.0;
+    extra_coeffs_prop_.SetDelegate(this);
+  }
+
+  virtual void Filter(const HardwareProperties* hwprops, const int* slots,
+                      size_t finger_cnt, uint64_t present,
+                      HardwareState* hwstate) {
+    // Run the sections up to the last one that isn't a pass through. They
+    // are counted here rather than when written, as a replayed log sets the
+    // property without notifying us.
+    const double kPassThrough[IirFilterBank::kSectionCoefficients] = {
+      1.0, 0.0, 0.0, 0.0, 0.0
+    };
+    size_t section_cnt = 0;
+    for (size_t i = 0; i < kSmoothingExtraSections; i++) {
+      const double* coeffs =
+          &extra_coeffs_[i * IirFilterBank::kSectionCoefficients];
+      if (!std::equal(coeffs, coeffs + IirFilterBank::kSectionCoefficients,
+                      kPassThrough))
+        section_cnt = i + 1;
+    }
+    iir_.Filter(hwprops, slots, finger_cnt, extra_coeffs_, section_cnt,
+                hwstate);
+  }
+
+  virtual void DoubleArrayWasWritten(DoubleArrayProperty* prop) {
+    // Start over with the new filter.
+    iir_.Restart();
+  }
+
+ private:
+  IirFilterBank iir_;
+
+  // The coefficients of each extra section,
+  // y[0] = b0*x[0] + b1*x[1] + b2*x[2] - (a1*y[1] + a2*y[2])
+  double extra_coeffs_[kSmoothingExtraSections *
+                       IirFilterBank::kSectionCoefficients];
+  DoubleArrayProperty extra_coeffs_prop_;
+};
+
+// The 1€ filter of Casiez et al., on each axis of the position.
+class OneEuroStage : public SmoothingStageFilter {
+ public:
+  explicit OneEuroStage(PropRegistry* prop_reg)
+      : tracked_(0),
+        enabled_(prop_reg, "One Euro Filter Enable", false),
+        min_cutoff_(prop_reg, "One Euro Min Cutoff", 1.0),
+        beta_(prop_reg, "One Euro Beta", 0.05),
+        speed_cutoff_(prop_reg, "One Euro Speed Cutoff", 1.0) {}
+
+  virtual void Filter(const HardwareProperties* hwprops, const int* slots,
+                      size_t finger_cnt, uint64_t present,
+                      HardwareState* hwstate) {
+    if (!enabled_.val_) {
+      tracked_ = 0;
+      return;
+    }
+    tracked_ &= present;
+    const stime_t now = hwstate->timestamp;
+    for (size_t i = 0; i < finger_cnt; i++) {
+      int slot = slots[i];
+      if (slot < 0)
+        continue;
+      FingerState* fs = &hwstate->fingers[i];
+      uint64_t bit = SlotBit(slot);
+      stime_t dt = now - prev_time_[slot];
+      prev_time_[slot] = now;
+      if (!(tracked_ & bit)) {
+        for (size_t axis = 0; axis < arraysize(kPositionFields); axis++) {
+          value_[axis][slot] = fs->*kPositionFields[axis];
+          speed_[axis][slot] = 0.0;
+        }
+        tracked_ |= bit;
+        continue;
+      }
+      for (size_t axis = 0; axis < arraysize(kPositionFields); axis++) {
+        float* val = &(fs->*kPositionFields[axis]);
+        float* value = &value_[axis][slot];
+        float* speed = &speed_[axis][slot];
+        if ((fs->flags & kWarpMoveFlags[axis]) || dt <= 0.0) {
+          // Start over from where a warped finger is, and don't make up a
+          // speed for a repeated timestamp.
+          *value = *val;
+          *speed = 0.0;
+          continue;
+        }
+        float new_speed = (*val - *value) / dt;
+        *speed += Alpha(speed_cutoff_.val_, dt) * (new_speed - *speed);
+        double cutoff = min_cutoff_.val_ + beta_.val_ * fabsf(*speed);
+        *value += Alpha(cutoff, dt) * (*val - *value);
+        *val = *value;
+      }
+    }
+  }
+
+ private:
+  // The smoothing factor of an exponential filter with a cutoff frequency
+  // of |cutoff| Hz, sampled every |dt| seconds.
+  static double Alpha(double cutoff, stime_t dt) {
+    return 1.0 / (1.0 + 1.0 / (2.0 * M_PI * cutoff * dt));
+  }
+
+  // The filtered position and speed, by axis and slot, and the time of the
+  // slot's last sample.
+  float value_[2][kMaxFingerSlots];
+  float speed_[2][kMaxFingerSlots];
+  stime_t prev_time_[kMaxFingerSlots];
+  // Slots with a filtered position.
+  uint64_t tracked_;
+
+  BoolProperty enabled_;
+  // The cutoff frequency in Hz of a stationary finger, and how much it rises
+  // for each mm/s of speed.
+  DoubleProperty min_cutoff_;
+  DoubleProperty beta_;
+  // The cutoff frequency in Hz of the low-pass filter on the speed.
+  DoubleProperty speed_cutoff_;
+};
+
+}  // namespace {}
+
+SmoothingFilterInterpreter::SmoothingFilterInterpreter(
+    PropRegistry* prop_reg, Interpreter* next, Tracer* tracer,
+    const std::vector<SmoothingStage>& stages)
+    : FilterInterpreter(NULL, next, tracer, false) {
+  InitName();
+  for (SmoothingStage stage : stages) {
+    switch (stage) {
+      case kSmoothingStationaryWiggle:
+        stages_.emplace_back(new StationaryWiggleStage(prop_reg));
+        break;
+      case kSmoothingBox:
+        stages_.emplace_back(new BoxStage(prop_reg));
+        break;
+      case kSmoothingBiquad:
+        stages_.emplace_back(new BiquadStage(prop_reg));
+        break;
+      case kSmoothingOneEuro:
+        stages_.emplace_back(new OneEuroStage(prop_reg));
+        break;
+    }
+  }
+}
+
+SmoothingFilterInterpreter::~SmoothingFilterInterpreter() {}
+
+void SmoothingFilterInterpreter::SyncInterpretImpl(HardwareState* hwstate,
+                                                   stime_t* timeout) {
+  // Fingers past kMaxFingerSlots contacts don't get a slot, and aren't
+  // filtered.
+  const size_t finger_cnt =
+      std::min<size_t>(hwstate->finger_cnt, kMaxFingerSlots);
+  finger_slots_.Update(*hwstate);
+  int slots[kMaxFingerSlots];
+  uint64_t present = 0;
+  for (size_t i = 0; i < finger_cnt; i++) {
+    slots[i] = finger_slots_.SlotForId(hwstate->fingers[i].tracking_id);
+    if (slots[i] >= 0)
+      present |= SlotBit(slots[i]);
+  }
+  for (size_t i = 0; i < stages_.size(); i++)
+    stages_[i]->Filter(hwprops_, slots, finger_cnt, present, hwstate);
+  next_->SyncInterpret(hwstate, timeout);
+}
+
+}  // namespace gestures
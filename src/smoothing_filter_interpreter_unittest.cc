@@ -0,0 +1,311 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "include/box_filter_interpreter.h"
+#include "include/gestures.h"
+#include "include/iir_filter_interpreter.h"
+#include "include/macros.h"
+#include "include/prop_registry.h"
+#include "include/smoothing_filter_interpreter.h"
+#include "include/stationary_wiggle_filter_interpreter.h"
+#include "include/unittest_util.h"
+
+namespace gestures {
+
+class SmoothingFilterInterpreterTest : public ::testing::Test {};
+
+class SmoothingFilterInterpreterTestInterpreter : public Interpreter {
+ public:
+  SmoothingFilterInterpreterTestInterpreter()
+      : Interpreter(NULL, NULL, false) {}
+
+  virtual void SyncInterpret(HardwareState* hwstate, stime_t* timeout) {
+    fingers_.assign(hwstate->fingers,
+                    hwstate->fingers + hwstate->finger_cnt);
+  }
+
+  virtual void HandleTimer(stime_t now, stime_t* timeout) {}
+
+  std::vector<FingerState> fingers_;
+};
+
+namespace {
+
+void SetProperty(PropRegistry* prop_reg, const char* name,
+                 const Json::Value& value) {
+  Property* prop = prop_reg->FindProperty(name);
+  ASSERT_NE(nullptr, prop) << name;
+  EXPECT_TRUE(prop->SetValue(value)) << name;
+  prop->HandleGesturesPropWritten();
+}
+
+// Sets |name| on both registries.
+void SetProperties(PropRegistry* a, PropRegistry* b, const char* name,
+                   const Json::Value& value) {
+  SetProperty(a, name, value);
+  SetProperty(b, name, value);
+}
+
+// Sets |name| on both registries without notifying, as replaying a log does.
+void ReplayProperties(PropRegistry* a, PropRegistry* b, const char* name,
+                      const Json::Value& value) {
+  PropRegistry* regs[] = { a, b };
+  for (PropRegistry* reg : regs) {
+    Property* prop = reg->FindProperty(name);
+    ASSERT_NE(nullptr, prop) << name;
+    EXPECT_TRUE(prop->SetValue(value)) << name;
+  }
+}
+
+Json::Value BiquadSections(const double* coeffs, size_t count) {
+  Json::Value list(Json::arrayValue);
+  for (size_t i = 0; i < count; i++)
+    list.append(coeffs[i]);
+  return list;
+}
+
+}  // namespace {}
+
+// Runs the same random contacts through the separate stationary wiggle, box
+// and IIR interpreters, and a SmoothingFilterInterpreter that does the same,
+// and checks they agree to the bit. The last properties are set the way a
+// replayed log sets them, so neither side hears about them.
+TEST(SmoothingFilterInterpreterTest, CompatibilityTest) {
+  HardwareProperties hwprops = {
+    0, 0, 100, 60,  // left, top, right, bottom
+    1, 1,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch,
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+
+  PropRegistry old_reg;
+  SmoothingFilterInterpreterTestInterpreter* old_base =
+      new SmoothingFilterInterpreterTestInterpreter;
+  Interpreter* temp = new IirFilterInterpreter(&old_reg, old_base, NULL);
+  temp = new BoxFilterInterpreter(&old_reg, temp, NULL);
+  StationaryWiggleFilterInterpreter old_chain(&old_reg, temp, NULL);
+  TestInterpreterWrapper old_wrapper(&old_chain, &hwprops);
+
+  PropRegistry new_reg;
+  SmoothingFilterInterpreterTestInterpreter* new_base =
+      new SmoothingFilterInterpreterTestInterpreter;
+  SmoothingFilterInterpreter new_chain(
+      &new_reg, new_base, NULL,
+      { kSmoothingStationaryWiggle, kSmoothingBox, kSmoothingBiquad });
+  TestInterpreterWrapper new_wrapper(&new_chain, &hwprops);
+
+  std::mt19937 gen(2026);
+  std::uniform_real_distribution<float> unit(0.0, 1.0);
+  std::vector<FingerState> contacts;
+  short next_id = 1;
+  stime_t now = 1.0;
+  for (size_t frame = 0; frame < 24000; frame++) {
+    switch (frame) {
+      case 4000:
+        SetProperties(&old_reg, &new_reg, "Stationary Wiggle Filter Enabled",
+                      Json::Value(true));
+        break;
+      case 8000:
+        SetProperties(&old_reg, &new_reg, "Box Width", Json::Value(0.6));
+        SetProperties(&old_reg, &new_reg, "Box Height", Json::Value(0.4));
+        break;
+      case 12000:
+        SetProperties(&old_reg, &new_reg, "Adjust IIR History On Warp",
+                      Json::Value(true));
+        SetProperties(&old_reg, &new_reg, "IIR Distance Threshold",
+                      Json::Value(2.0));
+        break;
+      case 16000:
+        SetProperties(&old_reg, &new_reg, "IIR b1", Json::Value(0.2));
+        SetProperties(&old_reg, &new_reg, "IIR b3", Json::Value(0.05));
+        break;
+      case 20000:
+        ReplayProperties(&old_reg, &new_reg, "IIR b2", Json::Value(0.1));
+        ReplayProperties(&old_reg, &new_reg, "IIR a2", Json::Value(0.3));
+        ReplayProperties(&old_reg, &new_reg, "IIR Filter Touch Major",
+                         Json::Value(true));
+        ReplayProperties(&old_reg, &new_reg, "Finger Moving Energy",
+                         Json::Value(0.02));
+        ReplayProperties(&old_reg, &new_reg, "Stationary Wiggle Window",
+                         Json::Value(4));
+        ReplayProperties(&old_reg, &new_reg, "Box Width", Json::Value(0.2));
+        break;
+    }
+
+    // Contacts come and go, move by up to 3 mm a frame, and now and then
+    // warp or pause long enough to reset the wiggle history.
+    for (size_t i = 0; i < contacts.size();) {
+      if (unit(gen) < 0.01) {
+        contacts.erase(contacts.begin() + i);
+        continue;
+      }
+      FingerState* fs = &contacts[i++];
+      float step = unit(gen) < 0.1 ? 3.0 : 0.2;
+      fs->position_x += (unit(gen) - 0.5) * step;
+      fs->position_y += (unit(gen) - 0.5) * step;
+      fs->pressure = 40.0 + 20.0 * unit(gen);
+      fs->flags = 0;
+      if (unit(gen) < 0.05)
+        fs->flags |= GESTURES_FINGER_WARP_X_MOVE;
+      if (unit(gen) < 0.05)
+        fs->flags |= GESTURES_FINGER_WARP_Y_MOVE;
+    }
+    if (contacts.size() < 5 && unit(gen) < 0.03) {
+      FingerState fs = {
+        8.0, 6.0, 0, 0, 50.0, 0, 100 * unit(gen), 60 * unit(gen), next_id++,
+        0
+      };
+      contacts.push_back(fs);
+    }
+    now += unit(gen) < 0.005 ? 0.2 : 0.01;
+
+    std::vector<FingerState> old_fingers = contacts;
+    std::vector<FingerState> new_fingers = contacts;
+    HardwareState old_hs = make_hwstate(now, 0, contacts.size(),
+                                        contacts.size(), old_fingers.data());
+    HardwareState new_hs = make_hwstate(now, 0, contacts.size(),
+                                        contacts.size(), new_fingers.data());
+    old_wrapper.SyncInterpret(&old_hs, NULL);
+    new_wrapper.SyncInterpret(&new_hs, NULL);
+
+    ASSERT_EQ(old_base->fingers_.size(), new_base->fingers_.size());
+    for (size_t i = 0; i < old_base->fingers_.size(); i++) {
+      ASSERT_EQ(0, memcmp(&old_base->fingers_[i], &new_base->fingers_[i],
+                          sizeof(FingerState)))
+          << "frame " << frame << " finger " << i;
+    }
+  }
+}
+
+TEST(SmoothingFilterInterpreterTest, ExtraSectionTest) {
+  PropRegistry prop_reg;
+  SmoothingFilterInterpreterTestInterpreter* base =
+      new SmoothingFilterInterpreterTestInterpreter;
+  SmoothingFilterInterpreter interpreter(&prop_reg, base, NULL,
+                                         { kSmoothingBiquad });
+  HardwareProperties hwprops = {
+    0, 0, 100, 60,  // left, top, right, bottom
+    1, 1,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch,
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TestInterpreterWrapper wrapper(&interpreter, &hwprops);
+
+  // Make the IIR section a pass through, and the second extra section a
+  // low-pass filter. The first extra section, left a pass through, is still
+  // run.
+  SetProperty(&prop_reg, "IIR b0", Json::Value(1.0));
+  SetProperty(&prop_reg, "IIR b1", Json::Value(0.0));
+  SetProperty(&prop_reg, "IIR b2", Json::Value(0.0));
+  SetProperty(&prop_reg, "IIR a1", Json::Value(0.0));
+  SetProperty(&prop_reg, "IIR a2", Json::Value(0.0));
+  const double kCoeffs[] = {
+    1.0, 0.0, 0.0, 0.0, 0.0,
+    0.2, 0.3, 0.1, -0.5, 0.1,
+    1.0, 0.0, 0.0, 0.0, 0.0,
+  };
+  SetProperty(&prop_reg, "IIR Extra Sections",
+              BiquadSections(kCoeffs, arraysize(kCoeffs)));
+
+  const double* sec = &kCoeffs[5];
+  float x1 = 10.0, x2 = 10.0, y1 = 10.0, y2 = 10.0;
+  for (size_t i = 0; i < 20; i++) {
+    FingerState fs = { 0, 0, 0, 0, 50, 0, 10.0f + 0.3f * i, 20, 1, 0 };
+    HardwareState hs = make_hwstate(1.0 + 0.01 * i, 0, 1, 1, &fs);
+    wrapper.SyncInterpret(&hs, NULL);
+    ASSERT_EQ(1, base->fingers_.size());
+    float x0 = 10.0f + 0.3f * i;
+    float y0 = x0;  // A new finger passes through.
+    if (i)
+      y0 = sec[0] * x0 + sec[1] * x1 + sec[2] * x2 - sec[3] * y1 -
+          sec[4] * y2;
+    EXPECT_EQ(y0, base->fingers_[0].position_x) << i;
+    EXPECT_EQ(20.0, base->fingers_[0].position_y) << i;
+    EXPECT_EQ(50.0, base->fingers_[0].pressure) << i;
+    x2 = x1;
+    x1 = x0;
+    y2 = y1;
+    y1 = y0;
+  }
+  EXPECT_LT(base->fingers_[0].position_x, 10.0f + 0.3f * 19);
+}
+
+TEST(SmoothingFilterInterpreterTest, OneEuroTest) {
+  PropRegistry prop_reg;
+  SmoothingFilterInterpreterTestInterpreter* base =
+      new SmoothingFilterInterpreterTestInterpreter;
+  SmoothingFilterInterpreter interpreter(&prop_reg, base, NULL,
+                                         { kSmoothingOneEuro });
+  HardwareProperties hwprops = {
+    0, 0, 100, 60,  // left, top, right, bottom
+    1, 1,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch,
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TestInterpreterWrapper wrapper(&interpreter, &hwprops);
+
+  stime_t now = 1.0;
+  // Sends a finger at (x, y) and returns where it comes out.
+  auto run = [&](float x, float y, unsigned flags) {
+    FingerState fs = { 0, 0, 0, 0, 50, 0, x, y, 1, flags };
+    HardwareState hs = make_hwstate(now, 0, 1, 1, &fs);
+    now += 0.01;
+    wrapper.SyncInterpret(&hs, NULL);
+    return base->fingers_[0];
+  };
+
+  // Off by default.
+  EXPECT_EQ(10.3f, run(10.3, 20.0, 0).position_x);
+  EXPECT_EQ(9.7f, run(9.7, 20.0, 0).position_x);
+
+  SetProperty(&prop_reg, "One Euro Filter Enable", Json::Value(true));
+  // Jitter on a resting finger mostly goes away.
+  float min_x = 100.0, max_x = 0.0;
+  for (size_t i = 0; i < 100; i++) {
+    float x = run(i % 2 ? 10.3 : 9.7, 20.0, 0).position_x;
+    if (i >= 50) {
+      min_x = std::min(min_x, x);
+      max_x = std::max(max_x, x);
+    }
+  }
+  EXPECT_LT(max_x - min_x, 0.1);
+
+  // A quick swipe is barely held back.
+  FingerState out;
+  for (size_t i = 1; i <= 20; i++)
+    out = run(10.0 + 5.0 * i, 20.0, 0);
+  EXPECT_GT(out.position_x, 110.0 - 10.0);
+  EXPECT_EQ(20.0, out.position_y);
+
+  // A warp goes straight to the new position.
+  out = run(30.0, 40.0, GESTURES_FINGER_WARP_X_MOVE);
+  EXPECT_EQ(30.0, out.position_x);
+  EXPECT_LT(out.position_y, 40.0);
+}
+
+}  // namespace gestures
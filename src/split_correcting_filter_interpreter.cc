@@ -6,6 +6,7 @@
 
 #include <math.h>
 
+#include "include/assignment_solver.h"
 #include "include/tracer.h"
 #include "include/util.h"
 
@@ -56,64 +57,83 @@ void SplitCorrectingFilterInterpreter::RemoveMissingUnmergedContacts(
 
 void SplitCorrectingFilterInterpreter::MergeFingers(
     const HardwareState& hwstate) {
-  std::set<const FingerState*> unused;
+  // Fingers that weren't in the last frame
+  const FingerState* unused[kMaxAssignmentSize];
+  size_t unused_cnt = 0;
   for (size_t i = 0; i < hwstate.finger_cnt; i++) {
-    if (!SetContainsValue(last_tracking_ids_, hwstate.fingers[i].tracking_id))
-      unused.insert(&hwstate.fingers[i]);
+    if (SetContainsValue(last_tracking_ids_, hwstate.fingers[i].tracking_id))
+      continue;
+    if (unused_cnt == arraysize(unused)) {
+      Err("Too many new fingers");
+      break;
+    }
+    unused[unused_cnt++] = &hwstate.fingers[i];
   }
-  if (unused.empty())
+  if (!unused_cnt)
     return;
-  for (UnmergedContact* it = unmerged_; it->Valid();) {
-    // Current state of the unmerged finger
-    const FingerState* existing_contact = hwstate.GetFingerState(it->input_id);
-    if (!existing_contact) {
-      Err("How is existing_contact NULL?");
-      return;
-    }
-    // try all fingers for possible merging
-    float min_error = INFINITY;
-    std::set<const FingerState*>::iterator min_error_it = unused.end();
-    for (std::set<const FingerState*>::iterator unused_it =
-             unused.begin(), e = unused.end(); unused_it != e; ++unused_it) {
-      const FingerState* new_contact = *unused_it;
-      if (new_contact == existing_contact)
-        continue;
-      float error = AreMergePair(*existing_contact, *new_contact, *it);
-      if (error < 0)
-        continue;
-      if (error < min_error) {
-        min_error = error;
-        min_error_it = unused_it;
+  size_t unmerged_cnt = 0;
+  while (unmerged_cnt < arraysize(unmerged_) &&
+         unmerged_[unmerged_cnt].Valid())
+    unmerged_cnt++;
+  if (unmerged_cnt) {
+    // Score every unmerged contact (row) against every new finger (column),
+    // and merge along the pairing that makes the most merges with the least
+    // total error, so one contact taking the best partner of another
+    // doesn't leave the other without one.
+    FingerDistances distances;
+    distances.Update(hwstate);
+    const FingerState* existing[kMaxAssignmentSize];
+    float error[kMaxAssignmentSize][kMaxAssignmentSize];
+    for (size_t row = 0; row < unmerged_cnt; row++) {
+      // Current state of the unmerged finger
+      existing[row] = hwstate.GetFingerState(unmerged_[row].input_id);
+      if (!existing[row]) {
+        Err("How is existing_contact NULL?");
+        return;
+      }
+      for (size_t col = 0; col < unused_cnt; col++) {
+        error[row][col] = INFINITY;
+        if (unused[col] == existing[row])
+          continue;
+        float sep_sq = distances.DistSq(unused[col] - hwstate.fingers,
+                                        existing[row] - hwstate.fingers);
+        float pair_error = AreMergePair(*existing[row], *unused[col], sep_sq,
+                                        unmerged_[row]);
+        if (pair_error >= 0)
+          error[row][col] = pair_error;
       }
     }
-    if (min_error_it != unused.end()) {
-      // we have a merge!
-      AppendMergedContact(*existing_contact, *(*min_error_it), it->output_id);
-      unused.erase(min_error_it);
-      // Delete this UnmergedContact
-      std::copy(it + 1, &unmerged_[arraysize(unmerged_)], it);
-      unmerged_[arraysize(unmerged_) - 1].Invalidate();
-      continue;
+    int merge_with[kMaxAssignmentSize];
+    if (SolveAssignment(error, unmerged_cnt, unused_cnt, merge_with)) {
+      // Move the merged contacts out of unmerged_, keeping the order of the
+      // rest.
+      size_t kept = 0;
+      for (size_t row = 0; row < unmerged_cnt; row++) {
+        if (merge_with[row] < 0) {
+          unmerged_[kept++] = unmerged_[row];
+          continue;
+        }
+        AppendMergedContact(*existing[row], *unused[merge_with[row]],
+                            unmerged_[row].output_id);
+        unused[merge_with[row]] = NULL;
+      }
+      for (size_t i = kept; i < unmerged_cnt; i++)
+        unmerged_[i].Invalidate();
+      unmerged_cnt = kept;
     }
-    it++;
   }
-  if (unused.empty())
-    return;
   // Put the unused new fingers into the unmerged fingers
-  // Find next slot
-  UnmergedContact* it = unmerged_;
-  for (; it->Valid() && it != &unmerged_[kMaxFingers]; ++it) {}
-  for (std::set<const FingerState*>::iterator unused_it =
-           unused.begin(), e = unused.end(); unused_it != e; ++unused_it) {
-    if (it == &unmerged_[kMaxFingers]) {
+  for (size_t col = 0; col < unused_cnt; col++) {
+    if (!unused[col])
+      continue;
+    if (unmerged_cnt == arraysize(unmerged_)) {
       Err("How is there no space?");
       return;
     }
-    const FingerState& fs = *(*unused_it);
-    it->input_id = it->output_id = fs.tracking_id;
-    it->position_x = fs.position_x;
-    it->position_y = fs.position_y;
-    it++;
+    UnmergedContact* it = &unmerged_[unmerged_cnt++];
+    it->input_id = it->output_id = unused[col]->tracking_id;
+    it->position_x = unused[col]->position_x;
+    it->position_y = unused[col]->position_y;
   }
 }
 
@@ -150,11 +170,11 @@ void SplitCorrectingFilterInterpreter::AppendUnmergedContact(
 float SplitCorrectingFilterInterpreter::AreMergePair(
     const FingerState& existing_contact,
     const FingerState& new_contact,
+    float sep_sq,
     const UnmergedContact& merge_recipient) const {
   // Is it close enough to the old contact?
   const float kMaxSepSq =
       merge_max_separation_.val_ * merge_max_separation_.val_;
-  float sep_sq = DistSq(new_contact, existing_contact);
   if (sep_sq > kMaxSepSq) {
     return -1;
   }
@@ -167,9 +187,8 @@ float SplitCorrectingFilterInterpreter::AreMergePair(
     return old_to_mid_dist_sq;  // Return new distance; definite improvement
 
   // Check if the merge recipient is too far from new_contact
-  float current_dist_sq = DistSq(existing_contact, new_contact);
   float new_to_reicpient_sq = DistSq(merge_recipient, new_contact);
-  if (current_dist_sq < new_to_reicpient_sq)
+  if (sep_sq < new_to_reicpient_sq)
     return -1;
 
   // Check if the new contact is, more or less, "along the line" from
@@ -194,7 +213,7 @@ float SplitCorrectingFilterInterpreter::AreMergePair(
   // We compute the maximum ratio of orthogonal_dist / hypotenuse length
 
   if (orthogonal_dist_sq <
-      merge_max_ratio_.val_ * merge_max_ratio_.val_ * current_dist_sq)
+      merge_max_ratio_.val_ * merge_max_ratio_.val_ * sep_sq)
     return old_to_mid_dist_sq;  // merge!
 
   return -1;  // no merge
@@ -1906,4 +1906,24 @@ TEST(SplitCorrectingFilterInterpreterTest, ThumbEdgePlusFingerTest) {
   DoTest(events, arraysize(events), false);
 }
 
+// Tests that two contacts that split at once both merge back, even when the
+// best new finger for one is the only one the other can merge with.
+TEST(SplitCorrectingFilterInterpreterTest, CrossedSplitTest) {
+  InputEventWithExpectations events[] = {
+    {{{ 0, 0, 0, 0, 50, 0, 20.0, 50.0, 1, 0 },
+      { 0, 0, 0, 0, 50, 0, 30.0, 50.0, 2, 0 },
+      { 0, 0, 0, 0, 0, 0, 0, 0, -1, 0 }},
+     { 1, 2, -1 }},
+    // 3 suits 1 better than 4 does, but only 3 suits 2.
+    {{{ 0, 0, 0, 0, 50, 0, 18.0, 48.5, 1, 0 },
+      { 0, 0, 0, 0, 50, 0, 32.0, 48.5, 2, 0 },
+      { 0, 0, 0, 0, 50, 0, 24.5, 48.5, 3, 0 },
+      { 0, 0, 0, 0, 50, 0, 18.0, 50.5, 4, 0 },
+      { 0, 0, 0, 0, 0, 0, 0, 0, -1, 0 }},
+     { 1, 2, -1 }},
+  };
+
+  DoTest(events, arraysize(events), false);
+}
+
 }  // namespace gestures
@@ -2,10 +2,12 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include <map>
-
 #include "include/stationary_wiggle_filter_interpreter.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "include/gestures.h"
 #include "include/interpreter.h"
 #include "include/tracer.h"
@@ -13,6 +15,23 @@
 
 namespace gestures {
 
+FingerEnergyHistory::FingerEnergyHistory(size_t window)
+    : max_size_(std::max<size_t>(1, std::min<size_t>(window,
+                                                     MAX_SIGNAL_SAMPLES))),
+      size_(0),
+      head_(0),
+      moving_(false),
+      idle_time_(0.1),
+      prev_(0),
+      sum_x_(0.0),
+      sum_y_(0.0),
+      sum_mixed_x_(0.0),
+      sum_mixed_y_(0.0),
+      sum_energy_x_(0.0),
+      sum_energy_y_(0.0) {
+  memset(history_, 0, sizeof(history_));
+}
+
 void FingerEnergyHistory::PushFingerState(const FingerState &fs,
                                           const stime_t timestamp) {
 
@@ -21,42 +40,45 @@ void FingerEnergyHistory::PushFingerState(const FingerState &fs,
   if (moving_ && timestamp - prev_ > idle_time_) {
     moving_ = false;
     head_ = size_ = 0;
+    sum_x_ = sum_y_ = 0.0;
+    sum_mixed_x_ = sum_mixed_y_ = 0.0;
+    sum_energy_x_ = sum_energy_y_ = 0.0;
   }
 
-  // Insert current finger position into the queue
+  // Insert current finger position into the queue. Once it's full, the
+  // oldest sample is overwritten, so take it out of the sums first.
   head_ = (head_ + max_size_ - 1) % max_size_;
-  history_[head_].x = fs.position_x;
-  history_[head_].y = fs.position_y;
-  size_ = std::min(size_ + 1, max_size_);
-
-  // Calculate average of original signal set, the average of original signal
-  // is considered as the offset.
-  float sum_x = 0.0;
-  float sum_y = 0.0;
-  for (size_t i = 0; i < size_; ++i) {
-    const FingerEnergy& fe = Get(i);
-    sum_x += fe.x;
-    sum_y += fe.y;
+  FingerEnergy* fe = &history_[head_];
+  if (size_ == max_size_) {
+    sum_x_ -= fe->x;
+    sum_y_ -= fe->y;
+    sum_mixed_x_ -= fe->mixed_x;
+    sum_mixed_y_ -= fe->mixed_y;
+    sum_energy_x_ -= fe->energy_x;
+    sum_energy_y_ -= fe->energy_y;
+  } else {
+    size_++;
   }
-  // Obtain the mixed signal strength
-  history_[head_].mixed_x = fs.position_x - sum_x / size_;
-  history_[head_].mixed_y = fs.position_y - sum_y / size_;
-
-
-  // Calculate the average of the mixed signal set, the average of mixed signal
-  // is considered as pure signal strength.
-  float psx = 0.0;
-  float psy = 0.0;
-  for (size_t i = 0; i < size_; ++i) {
-    const FingerEnergy& fe = Get(i);
-    psx += fe.mixed_x;
-    psy += fe.mixed_y;
-  }
-  psx /= size_;
-  psy /= size_;
-  // Calculate current pure signal energy
-  history_[head_].energy_x = psx * psx;
-  history_[head_].energy_y = psy * psy;
+  fe->x = fs.position_x;
+  fe->y = fs.position_y;
+  sum_x_ += fe->x;
+  sum_y_ += fe->y;
+
+  // The average of original signal set is considered as the offset. Obtain
+  // the mixed signal strength.
+  fe->mixed_x = fs.position_x - sum_x_ / size_;
+  fe->mixed_y = fs.position_y - sum_y_ / size_;
+  sum_mixed_x_ += fe->mixed_x;
+  sum_mixed_y_ += fe->mixed_y;
+
+  // The average of the mixed signal set is considered as pure signal
+  // strength. Calculate current pure signal energy.
+  double psx = sum_mixed_x_ / size_;
+  double psy = sum_mixed_y_ / size_;
+  fe->energy_x = psx * psx;
+  fe->energy_y = psy * psy;
+  sum_energy_x_ += fe->energy_x;
+  sum_energy_y_ += fe->energy_y;
 
   prev_ = timestamp;
 }
@@ -75,14 +97,7 @@ bool FingerEnergyHistory::IsFingerMoving(float threshold) {
   if (size_ < max_size_)
     return false;
 
-  float sum_energy_x = 0.0;
-  float sum_energy_y = 0.0;
-  for (size_t i = 0; i < size_; i++) {
-    const FingerEnergy& fe = history_[i];
-    sum_energy_x += fe.energy_x;
-    sum_energy_y += fe.energy_y;
-  }
-  moving_ = (sum_energy_x > threshold || sum_energy_y > threshold);
+  moving_ = (sum_energy_x_ > threshold || sum_energy_y_ > threshold);
   return moving_;
 }
 
@@ -90,7 +105,8 @@ bool FingerEnergyHistory::operator==(const FingerEnergyHistory& that) const {
   for (size_t i = 0; i < size_; i++)
     if (history_[i] != that.history_[i])
       return false;
-  if (size_ != that.size_ || head_ != that.head_ || moving_ != that.moving_)
+  if (max_size_ != that.max_size_ || size_ != that.size_ ||
+      head_ != that.head_ || moving_ != that.moving_)
     return false;
   return true;
 }
@@ -99,48 +115,64 @@ bool FingerEnergyHistory::operator!=(const FingerEnergyHistory& that) const {
   return !(*this == that);
 }
 
+void StationaryWiggleDetector::Update(const int* slots, size_t finger_cnt,
+                                      float threshold, float hysteresis,
+                                      size_t window, HardwareState* hwstate) {
+  for (size_t i = 0; i < finger_cnt; ++i) {
+    if (slots[i] < 0)
+      continue;
+    FingerState *fs = &hwstate->fingers[i];
+    FingerEnergyHistory* feh = &histories_[slots[i]];
+    uint64_t bit = static_cast<uint64_t>(1) << slots[i];
+
+    // Start a new history if it is a new finger
+    if (!(tracked_ & bit)) {
+      *feh = FingerEnergyHistory(window);
+      feh->PushFingerState(*fs, hwstate->timestamp);
+      tracked_ |= bit;
+      continue;
+    }
+
+    // Update the energy history and check if the finger is moving
+    feh->PushFingerState(*fs, hwstate->timestamp);
+    if (feh->HasEnoughSamples()) {
+      if (!feh->IsFingerMoving(feh->moving() ? hysteresis : threshold))
+        fs->flags |= (GESTURES_FINGER_WARP_X | GESTURES_FINGER_WARP_Y);
+      else
+        fs->flags |= GESTURES_FINGER_INSTANTANEOUS_MOVING;
+    }
+  }
+}
+
 StationaryWiggleFilterInterpreter::StationaryWiggleFilterInterpreter(
     PropRegistry* prop_reg, Interpreter* next, Tracer* tracer)
     : FilterInterpreter(NULL, next, tracer, false),
       enabled_(prop_reg, "Stationary Wiggle Filter Enabled", false),
       threshold_(prop_reg, "Finger Moving Energy", 0.012),
-      hysteresis_(prop_reg, "Finger Moving Hysteresis", 0.006) {
+      hysteresis_(prop_reg, "Finger Moving Hysteresis", 0.006),
+      window_(prop_reg, "Stationary Wiggle Window", SIGNAL_SAMPLES) {
   InitName();
 }
 
 void StationaryWiggleFilterInterpreter::SyncInterpretImpl(
     HardwareState* hwstate, stime_t* timeout) {
+  // Contacts are followed even while disabled, so that a contact given the
+  // slot of one that left doesn't pick up its history.
+  const size_t finger_cnt =
+      std::min<size_t>(hwstate->finger_cnt, kMaxFingerSlots);
+  finger_slots_.Update(*hwstate);
+  int slots[kMaxFingerSlots];
+  uint64_t present = 0;
+  for (size_t i = 0; i < finger_cnt; i++) {
+    slots[i] = finger_slots_.SlotForId(hwstate->fingers[i].tracking_id);
+    if (slots[i] >= 0)
+      present |= static_cast<uint64_t>(1) << slots[i];
+  }
+  detector_.RemoveMissing(present);
   if (enabled_.val_)
-    UpdateStationaryFlags(hwstate);
+    detector_.Update(slots, finger_cnt, threshold_.val_, hysteresis_.val_,
+                     window_.val_, hwstate);
   next_->SyncInterpret(hwstate, timeout);
 }
 
-void StationaryWiggleFilterInterpreter::UpdateStationaryFlags(
-    HardwareState* hwstate) {
-
-  RemoveMissingIdsFromMap(&histories_, *hwstate);
-
-  for (int i = 0; i < hwstate->finger_cnt; ++i) {
-    FingerState *fs = &hwstate->fingers[i];
-
-    // Create a new entry if it is a new finger
-    if (!MapContainsKey(histories_, fs->tracking_id)) {
-      histories_[fs->tracking_id] = FingerEnergyHistory();
-      histories_[fs->tracking_id].PushFingerState(*fs, hwstate->timestamp);
-      continue;
-    }
-
-    // Update the energy history and check if the finger is moving
-    FingerEnergyHistory& feh = histories_[fs->tracking_id];
-    feh.PushFingerState(*fs, hwstate->timestamp);
-    if (feh.HasEnoughSamples()) {
-      float threshold = feh.moving() ? hysteresis_.val_ : threshold_.val_;
-      if (!feh.IsFingerMoving(threshold))
-        fs->flags |= (GESTURES_FINGER_WARP_X | GESTURES_FINGER_WARP_Y);
-      else
-        fs->flags |= GESTURES_FINGER_INSTANTANEOUS_MOVING;
-    }
-  }
-}
-
 }  // namespace gestures
@@ -2,6 +2,11 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <math.h>
+
+#include <deque>
+#include <random>
+
 #include <gtest/gtest.h>
 
 #include "include/stationary_wiggle_filter_interpreter.h"
@@ -149,4 +154,78 @@ TEST(StationaryWiggleFilterInterpreterTest, SimpleTest) {
   EXPECT_EQ(interpreter.hysteresis_.val_, 0.006);
 }
 
+// Checks the running sums against summing up the window for each sample,
+// over long enough a contact for rounding errors to build up.
+TEST(StationaryWiggleFilterInterpreterTest, WindowTest) {
+  const size_t kWindow = 12;
+  FingerEnergyHistory history(kWindow);
+  std::deque<float> xs, mixed;
+  std::deque<double> energies;
+  std::mt19937 gen(48);
+  std::uniform_real_distribution<float> noise(-0.05, 0.05);
+  float x = 50.0;
+  for (size_t i = 0; i < 100000; i++) {
+    // Drift across the pad and back, with noise on top.
+    x += (i / 5000) % 2 ? -0.01 : 0.01;
+    FingerState fs = { 0, 0, 0, 0, 20, 0, x + noise(gen), 20, 1, 0 };
+    history.PushFingerState(fs, 1.0 + 0.01 * i);
+
+    xs.push_front(fs.position_x);
+    if (xs.size() > kWindow)
+      xs.pop_back();
+    double sum = 0.0;
+    for (float val : xs)
+      sum += val;
+    mixed.push_front(fs.position_x - sum / xs.size());
+    if (mixed.size() > kWindow)
+      mixed.pop_back();
+    double ps = 0.0;
+    for (float val : mixed)
+      ps += val;
+    ps /= mixed.size();
+    energies.push_front(ps * ps);
+    if (energies.size() > kWindow)
+      energies.pop_back();
+
+    ASSERT_EQ(i + 1 >= kWindow, history.HasEnoughSamples());
+    ASSERT_NEAR(mixed[0], history.Get(0).mixed_x, 1e-5) << i;
+    ASSERT_NEAR(energies[0], history.Get(0).energy_x, 1e-7) << i;
+    if (history.HasEnoughSamples()) {
+      double energy = 0.0;
+      for (double val : energies)
+        energy += val;
+      // Thresholds just either side of the energy.
+      ASSERT_TRUE(history.IsFingerMoving(energy - 1e-6)) << i;
+      ASSERT_FALSE(history.IsFingerMoving(energy + 1e-6)) << i;
+    }
+  }
+
+  // The window property applies to new contacts.
+  StationaryWiggleFilterInterpreterTestInterpreter* base_interpreter =
+      new StationaryWiggleFilterInterpreterTestInterpreter;
+  StationaryWiggleFilterInterpreter interpreter(NULL, base_interpreter, NULL);
+  interpreter.enabled_.val_ = true;
+  interpreter.window_.val_ = kWindow;
+  HardwareProperties hwprops = {
+    0, 0, 100, 100,  // left, top, right, bottom
+    1, 1,  // x res (pixels/mm), y res (pixels/mm)
+    1, 1,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch,
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TestInterpreterWrapper wrapper(&interpreter, &hwprops);
+  for (size_t i = 0; i < kWindow + 4; i++) {
+    FingerState fs = { 0, 0, 0, 0, 20, 0, 40, 20.0f + 5 * i, 1, 0 };
+    HardwareState hs = make_hwstate(1.0 + 0.01 * i, 0, 1, 1, &fs);
+    wrapper.SyncInterpret(&hs, NULL);
+    unsigned expected =
+        i + 1 < kWindow ? 0 : GESTURES_FINGER_INSTANTANEOUS_MOVING;
+    EXPECT_EQ(expected, base_interpreter->prev_.flags) << i;
+  }
+}
+
 }  // namespace gestures
@@ -0,0 +1,261 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "include/touch_stream_generator.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "include/logging.h"
+
+namespace gestures {
+
+namespace {
+
+// Time between segments with no contacts, in seconds.
+const double kSegmentGap = 0.05;
+// Drumroll taps start this often, and each lasts for kTapLength.
+const double kTapPeriod = 0.06;
+const double kTapLength = 0.035;
+
+}  // namespace {}
+
+TouchStreamGenerator::TouchStreamGenerator(const HardwareProperties& hwprops,
+                                           const TouchStreamConfig& config)
+    : hwprops_(hwprops),
+      config_(config),
+      rng_(config.seed),
+      segment_(0),
+      segment_start_(0.0),
+      frame_(0),
+      last_timestamp_(0.0),
+      next_id_(1) {
+  if (config_.rate <= 0.0) {
+    Err("Invalid rate %f", config_.rate);
+    config_.rate = 60.0;
+  }
+  memset(&hwstate_, 0, sizeof(hwstate_));
+  memset(fingers_, 0, sizeof(fingers_));
+  hwstate_.fingers = fingers_;
+  StartSegment();
+}
+
+void TouchStreamGenerator::AddSegment(TouchSegmentKind kind, size_t fingers,
+                                      double duration) {
+  Segment segment = { kind, fingers, duration };
+  segments_.push_back(segment);
+}
+
+void TouchStreamGenerator::StartSegment() {
+  for (size_t i = 0; i < kMaxFingers; i++) {
+    slot_ids_[i] = next_id_++;
+    slot_taps_[i] = -1;
+  }
+}
+
+HardwareState* TouchStreamGenerator::Next() {
+  double now = frame_ / config_.rate;
+  while (segment_ < segments_.size() &&
+         now - segment_start_ >=
+             segments_[segment_].duration + kSegmentGap) {
+    segment_start_ += segments_[segment_].duration + kSegmentGap;
+    segment_++;
+    StartSegment();
+  }
+  if (segment_ >= segments_.size())
+    return NULL;
+
+  const Segment& segment = segments_[segment_];
+  double elapsed = now - segment_start_;
+  hwstate_.finger_cnt = 0;
+  if (elapsed < segment.duration)
+    FillFingers(segment, elapsed);
+  hwstate_.touch_cnt = hwstate_.finger_cnt;
+  hwstate_.msc_timestamp = now;
+
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  double arrival = now;
+  if (config_.burst_probability > 0.0 &&
+      unit(rng_) < config_.burst_probability)
+    arrival += 1.0 / config_.rate;  // Arrives with the next frame
+  arrival += config_.delivery_latency;
+  if (config_.delivery_jitter > 0.0)
+    arrival += config_.delivery_jitter * unit(rng_);
+  hwstate_.timestamp = std::max(arrival, last_timestamp_);
+  last_timestamp_ = hwstate_.timestamp;
+
+  frame_++;
+  return &hwstate_;
+}
+
+void TouchStreamGenerator::FillFingers(const Segment& segment,
+                                       double elapsed) {
+  size_t max_fingers = hwprops_.max_finger_cnt ?
+      std::min<size_t>(hwprops_.max_finger_cnt, kMaxFingers) : kMaxFingers;
+  size_t count = std::max<size_t>(1, std::min(segment.fingers, max_fingers));
+  switch (segment.kind) {
+    case kTouchSegmentMove:
+      AddFinger(0, -20.0 + 60.0 * elapsed, 0.0, 8.0, 60.0);
+      break;
+    case kTouchSegmentScroll:
+      for (size_t i = 0; i < count; i++)
+        AddFinger(i, (i - (count - 1) / 2.0) * 12.0, -15.0 + 50.0 * elapsed,
+                  8.0, 60.0);
+      break;
+    case kTouchSegmentPinch: {
+      double separation = 10.0 + 40.0 * elapsed;
+      AddFinger(0, -separation / 2, 0.0, 8.0, 60.0);
+      AddFinger(1, separation / 2, 0.0, 8.0, 60.0);
+      break;
+    }
+    case kTouchSegmentPalm: {
+      double bottom = (hwprops_.bottom - hwprops_.top) /
+          std::max(hwprops_.res_y, 1.0f) / 2;
+      AddFinger(0, 5.0, bottom - 5.0, 25.0, 200.0);
+      for (size_t i = 1; i < count; i++)
+        AddFinger(i, -20.0 + 60.0 * elapsed, -10.0 + 12.0 * i, 8.0, 60.0);
+      break;
+    }
+    case kTouchSegmentDrumroll: {
+      int64_t tap = static_cast<int64_t>(elapsed / kTapPeriod);
+      if (elapsed - tap * kTapPeriod >= kTapLength)
+        break;
+      size_t slot = tap % count;
+      if (slot_taps_[slot] != tap) {
+        slot_ids_[slot] = next_id_++;
+        slot_taps_[slot] = tap;
+      }
+      AddFinger(slot, (slot - (count - 1) / 2.0) * 15.0, 0.0, 7.0, 50.0);
+      break;
+    }
+  }
+}
+
+void TouchStreamGenerator::AddFinger(size_t slot, double x, double y,
+                                     float size, float pressure) {
+  if (config_.position_noise > 0.0) {
+    std::normal_distribution<double> noise(0.0, config_.position_noise);
+    x += noise(rng_);
+    y += noise(rng_);
+  }
+  float res_x = std::max(hwprops_.res_x, 1.0f);
+  float res_y = std::max(hwprops_.res_y, 1.0f);
+  FingerState* fs = &fingers_[hwstate_.finger_cnt++];
+  memset(fs, 0, sizeof(*fs));
+  fs->position_x = std::min(hwprops_.right, std::max(hwprops_.left,
+      static_cast<float>((hwprops_.left + hwprops_.right) / 2 + x * res_x)));
+  fs->position_y = std::min(hwprops_.bottom, std::max(hwprops_.top,
+      static_cast<float>((hwprops_.top + hwprops_.bottom) / 2 + y * res_y)));
+  fs->touch_major = size * res_x;
+  fs->touch_minor = 0.8 * size * res_x;
+  fs->pressure = pressure;
+  fs->tracking_id = slot_ids_[slot];
+}
+
+namespace {
+
+// A timer provider that runs on the stream's clock.
+struct LoadTimer {
+  stime_t now = 0.0;
+  bool armed = false;
+  stime_t deadline = 0.0;
+  GesturesTimerCallback callback = NULL;
+  void* callback_data = NULL;
+};
+
+GesturesTimer* LoadTimerCreate(void* data) {
+  return reinterpret_cast<GesturesTimer*>(data);
+}
+
+void LoadTimerSet(void* data, GesturesTimer* timer, stime_t delay,
+                  GesturesTimerCallback callback, void* callback_data) {
+  LoadTimer* load_timer = reinterpret_cast<LoadTimer*>(data);
+  load_timer->armed = true;
+  load_timer->deadline = load_timer->now + delay;
+  load_timer->callback = callback;
+  load_timer->callback_data = callback_data;
+}
+
+void LoadTimerCancel(void* data, GesturesTimer* timer) {
+  reinterpret_cast<LoadTimer*>(data)->armed = false;
+}
+
+void LoadTimerFree(void* data, GesturesTimer* timer) {}
+
+void CountGesture(void* data, const Gesture* gesture) {
+  (*reinterpret_cast<size_t*>(data))++;
+}
+
+double Seconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double>(duration).count();
+}
+
+// |sorted| must be sorted and not empty.
+double Percentile(const std::vector<double>& sorted, double fraction) {
+  size_t idx = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+  return sorted[idx];
+}
+
+}  // namespace {}
+
+TouchLoadReport DriveGestureInterpreter(GestureInterpreter* gi,
+                                        TouchStreamGenerator* generator) {
+  TouchLoadReport report;
+  LoadTimer timer;
+  GesturesTimerProvider timer_provider = {
+    LoadTimerCreate,
+    LoadTimerSet,
+    LoadTimerCancel,
+    LoadTimerFree
+  };
+  gi->SetTimerProvider(&timer_provider, &timer);
+  gi->SetCallback(CountGesture, &report.gestures);
+  gi->SetHardwareProperties(generator->hwprops());
+
+  const double period = 1.0 / generator->rate();
+  std::vector<double> latencies;
+  std::chrono::steady_clock::duration busy(0);
+  while (HardwareState* hwstate = generator->Next()) {
+    while (timer.armed && timer.deadline <= hwstate->timestamp) {
+      timer.armed = false;
+      timer.now = timer.deadline;
+      auto start = std::chrono::steady_clock::now();
+      stime_t next = timer.callback(timer.deadline, timer.callback_data);
+      busy += std::chrono::steady_clock::now() - start;
+      report.timer_callbacks++;
+      if (next >= 0.0 && !timer.armed) {
+        timer.armed = true;
+        timer.deadline = timer.now + next;
+      }
+    }
+    timer.now = hwstate->timestamp;
+    auto start = std::chrono::steady_clock::now();
+    gi->PushHardwareState(hwstate);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    busy += elapsed;
+    latencies.push_back(Seconds(elapsed) * 1e6);
+    if (Seconds(elapsed) > period)
+      report.missed_deadlines++;
+  }
+  gi->SetCallback(NULL, NULL);
+  gi->SetTimerProvider(NULL, NULL);
+
+  report.frames = latencies.size();
+  report.busy_seconds = Seconds(busy);
+  if (report.busy_seconds > 0.0)
+    report.throughput = report.frames / report.busy_seconds;
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    report.p50_us = Percentile(latencies, 0.5);
+    report.p90_us = Percentile(latencies, 0.9);
+    report.p99_us = Percentile(latencies, 0.99);
+    report.max_us = latencies.back();
+  }
+  return report;
+}
+
+}  // namespace gestures
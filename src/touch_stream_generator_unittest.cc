@@ -0,0 +1,122 @@
+// Copyright 2026 The ChromiumOS Authors
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <set>
+
+#include <gtest/gtest.h>
+
+#include "include/gestures.h"
+#include "include/touch_stream_generator.h"
+
+namespace gestures {
+
+class TouchStreamGeneratorTest : public ::testing::Test {};
+
+TEST(TouchStreamGeneratorTest, SimpleTest) {
+  HardwareProperties hwprops = {
+    0, 0, 1000, 600,  // left, top, right, bottom
+    10, 10,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TouchStreamConfig config;
+  config.rate = 200.0;
+  config.position_noise = 0.2;
+  config.delivery_jitter = 0.003;
+  config.burst_probability = 0.1;
+  TouchStreamGenerator generator(hwprops, config);
+  generator.AddSegment(kTouchSegmentScroll, 3, 0.5);
+  generator.AddSegment(kTouchSegmentDrumroll, 2, 0.5);
+
+  size_t frames = 0;
+  stime_t last_timestamp = -1.0;
+  std::set<short> scroll_ids;
+  std::set<short> drumroll_ids;
+  while (HardwareState* hwstate = generator.Next()) {
+    EXPECT_NEAR(frames / config.rate, hwstate->msc_timestamp, 1e-9);
+    EXPECT_GE(hwstate->timestamp, last_timestamp);
+    EXPECT_GE(hwstate->timestamp, hwstate->msc_timestamp);
+    last_timestamp = hwstate->timestamp;
+    EXPECT_LE(hwstate->finger_cnt, 3);
+    for (size_t i = 0; i < hwstate->finger_cnt; i++) {
+      const FingerState& fs = hwstate->fingers[i];
+      EXPECT_GE(fs.position_x, hwprops.left);
+      EXPECT_LE(fs.position_x, hwprops.right);
+      EXPECT_GE(fs.position_y, hwprops.top);
+      EXPECT_LE(fs.position_y, hwprops.bottom);
+      if (hwstate->msc_timestamp < 0.5)
+        scroll_ids.insert(fs.tracking_id);
+      else
+        drumroll_ids.insert(fs.tracking_id);
+    }
+    frames++;
+  }
+  // Two segments of 0.5s, each followed by a 0.05s gap.
+  EXPECT_EQ(220, frames);
+  // The scroll keeps its three contacts, while every tap is a new contact.
+  EXPECT_EQ(3, scroll_ids.size());
+  EXPECT_EQ(9, drumroll_ids.size());
+  EXPECT_EQ(NULL, generator.Next());
+}
+
+TEST(TouchStreamGeneratorTest, MaxFingersTest) {
+  HardwareProperties hwprops = {
+    0, 0, 1000, 600,  // left, top, right, bottom
+    10, 10,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    2, 2,  // max fingers, max_touch
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TouchStreamGenerator generator(hwprops, TouchStreamConfig());
+  generator.AddSegment(kTouchSegmentScroll, 4, 0.1);
+  generator.AddSegment(kTouchSegmentPalm, 4, 0.1);
+  size_t max_seen = 0;
+  while (HardwareState* hwstate = generator.Next())
+    max_seen = std::max<size_t>(max_seen, hwstate->finger_cnt);
+  EXPECT_EQ(2, max_seen);
+}
+
+TEST(TouchStreamGeneratorTest, DriveTest) {
+  HardwareProperties hwprops = {
+    0, 0, 1000, 600,  // left, top, right, bottom
+    10, 10,  // x res (pixels/mm), y res (pixels/mm)
+    133, 133,  // scrn DPI X, Y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    5, 5,  // max fingers, max_touch
+    0, 0, 1,  // t5r2, semi, button pad
+    0, 0,  // has wheel, vertical wheel is high resolution
+    0,  // haptic pad
+  };
+  TouchStreamConfig config;
+  config.position_noise = 0.1;
+  TouchStreamGenerator generator(hwprops, config);
+  generator.AddSegment(kTouchSegmentMove, 1, 0.3);
+  generator.AddSegment(kTouchSegmentScroll, 2, 0.3);
+  generator.AddSegment(kTouchSegmentPinch, 2, 0.3);
+
+  GestureInterpreter* gi = NewGestureInterpreter();
+  gi->Initialize(GESTURES_DEVCLASS_TOUCHPAD);
+  TouchLoadReport report = DriveGestureInterpreter(gi, &generator);
+  DeleteGestureInterpreter(gi);
+
+  EXPECT_EQ(252, report.frames);
+  EXPECT_GT(report.gestures, 0);
+  EXPECT_GT(report.timer_callbacks, 0);
+  EXPECT_LE(report.p50_us, report.p90_us);
+  EXPECT_LE(report.p90_us, report.p99_us);
+  EXPECT_LE(report.p99_us, report.max_us);
+  EXPECT_GT(report.throughput, 0.0);
+}
+
+}  // namespace gestures
@@ -4,7 +4,11 @@
 
 #include "include/unittest_util.h"
 
+#include <json/value.h>
+
 #include "include/gestures.h"
+#include "include/logging.h"
+#include "include/prop_registry.h"
 
 namespace gestures {
 
@@ -94,4 +98,35 @@ HardwareState make_hwstate(stime_t timestamp, int buttons_down,
   };
 }
 
+std::string RecordMouseActivityLog(size_t frames) {
+  std::unique_ptr<GestureInterpreter> gi(NewGestureInterpreter());
+  gi->Initialize(GESTURES_DEVCLASS_MOUSE);
+  Property* logging = gi->prop_reg()->FindProperty("Event Logging Enable");
+  if (!logging) {
+    Err("Mouse chain has no event logging");
+    return "";
+  }
+  logging->SetValue(Json::Value(true));
+  logging->HandleGesturesPropWritten();
+  HardwareProperties hwprops = {
+    0, 0, 0, 0,  // left, top, right, bottom
+    0, 0,  // x res, y res
+    0, 0,  // screen DPI x, y
+    -1,  // orientation minimum
+    2,   // orientation maximum
+    0, 0,  // max fingers, max touch
+    0, 0, 0,  // t5r2, semi-mt, is button pad
+    0, 0,  // has_wheel, wheel_is_hi_res
+    0,  // is haptic pad
+  };
+  gi->SetHardwareProperties(hwprops);
+  for (size_t i = 0; i < frames; i++) {
+    HardwareState hs = make_hwstate(0.01 * (i + 1), 0, 0, 0, NULL);
+    hs.rel_x = 2 + i;
+    hs.rel_y = 1;
+    gi->PushHardwareState(&hs);
+  }
+  return gi->EncodeActivityLog();
+}
+
 }  // namespace gestures